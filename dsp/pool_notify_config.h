@@ -48,7 +48,178 @@
 extern "C" {
 #endif /* defined (__cplusplus) */
 
-#define MEM_SIZE    425984
+/** ============================================================================
+ *  @const  STREAM_NUM_BUFS, STREAM_BUF_SIZE
+ *
+ *  @desc   Number and size of the band buffers the GPP streams images in.
+ *          Must match gpp/pool_notify.h.
+ *  ============================================================================
+ */
+#define STREAM_NUM_BUFS    2
+#define STREAM_BUF_SIZE    32768
+
+/** ============================================================================
+ *  @const  CMD_NUM_SLOTS, CMD_SLOT_SIZE, CMD_KERNEL_MAX
+ *
+ *  @desc   Number of command blocks in the command buffer, the space taken
+ *          by each (one cache line, so a block is written back and
+ *          invalidated on its own) and the largest kernel a command carries.
+ *          Whole frames, the benchmark, CMD_CONFIG and CMD_RING_OPEN use
+ *          slot 0, band N of a streamed frame slot N % STREAM_NUM_BUFS, so
+ *          there must be a slot for every band buffer.
+ *          Must match gpp/pool_notify.h.
+ *  ============================================================================
+ */
+#define CMD_NUM_SLOTS      4
+#define CMD_SLOT_SIZE      128
+#define CMD_KERNEL_MAX     32
+
+#if CMD_NUM_SLOTS < STREAM_NUM_BUFS
+#error "Every band buffer needs a command slot of its own"
+#endif
+
+/** ============================================================================
+ *  @const  CMD_KERNEL_IIR, CMD_IIR_FRAC_BITS
+ *
+ *  @desc   A kernel of CMD_KERNEL_IIR taps, which no Gaussian window has,
+ *          carries the recursive (Young - van Vliet) Gaussian used for large
+ *          sigma instead: the weights of the last three outputs, the second
+ *          one subtracted, and the gain of the input, with CMD_IIR_FRAC_BITS
+ *          fraction bits, each as its low and then its high 16 bits. Its
+ *          cost does not grow with sigma. The recursion runs down whole
+ *          columns, so it only smooths whole frames: CMD_SMOOTH of all rows,
+ *          CMD_EDGES and the frame ring, never CMD_SMOOTH_BAND.
+ *  ============================================================================
+ */
+#define CMD_KERNEL_IIR     8
+#define CMD_IIR_FRAC_BITS  24
+
+/** ============================================================================
+ *  @const  CMD_SMOOTH, CMD_SMOOTH_BAND, CMD_SHUTDOWN, CMD_CONFIG, CMD_EDGES,
+ *          CMD_BENCH, CMD_RING_OPEN
+ *
+ *  @desc   Command opcodes. CMD_SMOOTH smooths the rows [firstRow, firstRow +
+ *          numRows) of a whole frame in the data buffer, writing them at their
+ *          place in the result, scaled by 90 and rounded to integers.
+ *          CMD_SMOOTH_BAND smooths the same rows of a frame streamed in bands.
+ *          CMD_SHUTDOWN ends the DSP command loop. CMD_CONFIG is sent once
+ *          when the session is created; its rows and cols give the tile size
+ *          the DSP allocates its working buffers for. CMD_EDGES smooths a
+ *          whole frame into buf + outOffset, which only the DSP uses, and goes
+ *          on with the derivatives, the gradient magnitude and the non-maximal
+ *          suppression. Only the magnitude (shorts at buf + magOffset) and the
+ *          suppression map (bytes at buf + nmsOffset) are returned. CMD_BENCH
+ *          does the CMD_BENCH_* steps set in numRows on the rows x cols bytes
+ *          at buf + inOffset, for timing the transport and the smoothing; with
+ *          no step set it is a plain round trip. CMD_RING_OPEN hands the DSP
+ *          the frame ring at buf and the result ring at buf + outOffset.
+ *  ============================================================================
+ */
+#define CMD_SMOOTH         1
+#define CMD_SMOOTH_BAND    2
+#define CMD_SHUTDOWN       3
+#define CMD_CONFIG         4
+#define CMD_EDGES          5
+#define CMD_BENCH          6
+#define CMD_RING_OPEN      7
+
+/** ============================================================================
+ *  @const  CMD_BENCH_INV, CMD_BENCH_FILL, CMD_BENCH_WB, CMD_BENCH_SMOOTH,
+ *          CMD_BENCH_COLUMNS, CMD_BENCH_TILES
+ *
+ *  @desc   Steps of CMD_BENCH, done in this order: invalidate the region in
+ *          the DSP cache, write every byte of it, write it back, smooth it as
+ *          an image into buf + outOffset with the kernel of the command.
+ *          CMD_BENCH_TILES has the smoothing blur whole tiles in two passes
+ *          instead of streaming the rows through a line buffer, and
+ *          CMD_BENCH_COLUMNS does the same with the vertical pass walking
+ *          the tiles column by column, for comparison.
+ *  ============================================================================
+ */
+#define CMD_BENCH_INV      1
+#define CMD_BENCH_FILL     2
+#define CMD_BENCH_WB       4
+#define CMD_BENCH_SMOOTH   8
+#define CMD_BENCH_COLUMNS  16
+#define CMD_BENCH_TILES    32
+
+/** ============================================================================
+ *  @const  CMD_STATUS_OK, CMD_STATUS_EINVAL, CMD_STATUS_EOPCODE,
+ *          CMD_STATUS_ENOMEM
+ *
+ *  @desc   Completion status the DSP stores in a command block.
+ *  ============================================================================
+ */
+#define CMD_STATUS_OK      0
+#define CMD_STATUS_EINVAL  1
+#define CMD_STATUS_EOPCODE 2
+#define CMD_STATUS_ENOMEM  3
+
+/** ============================================================================
+ *  @name   Cmd_Block
+ *
+ *  @desc   Command sent to the DSP. The GPP fills a block and notifies its
+ *          DSP address; the DSP sets status and notifies seq back when
+ *          the command is complete. The input rows, haloTop rows above
+ *          firstRow up to haloBottom rows below the last row, are read at
+ *          buf + inOffset and the smoothed rows are written at buf + outOffset.
+ *          The kernel taps are only filled in when kernelId changes; the DSP
+ *          keeps the last kernel it received.
+ *          Must match gpp/pool_notify.h.
+ *  ============================================================================
+ */
+typedef struct Cmd_Block_tag {
+    Uint32   opcode ;
+    Uint32   seq ;
+    Uint32   status ;
+    Uint32   rows ;
+    Uint32   cols ;
+    Uint32   firstRow ;
+    Uint32   numRows ;
+    Uint32   haloTop ;
+    Uint32   haloBottom ;
+    Uint32   buf ;
+    Uint32   inOffset ;
+    Uint32   outOffset ;
+    Uint32   windowSize ;
+    Uint32   kernelId ;
+    Uint16   kernel [CMD_KERNEL_MAX] ;
+    Uint32   magOffset ;
+    Uint32   nmsOffset ;
+} Cmd_Block ;
+
+/** ============================================================================
+ *  @const  RING_LINE, RING_HEADER_SIZE
+ *
+ *  @desc   Space taken by each field group of a Ring_Header, one cache line
+ *          of either processor, and by the whole header.
+ *  ============================================================================
+ */
+#define RING_LINE          128
+#define RING_HEADER_SIZE   (3 * RING_LINE)
+
+/** ============================================================================
+ *  @name   Ring_Header
+ *
+ *  @desc   Start of a ring of equal slots in the shared pool. The frame ring
+ *          carries images from the GPP to the DSP, the result ring their
+ *          smoothed images back. Each slot holds a Cmd_Block (CMD_SLOT_SIZE
+ *          bytes) followed by the pixels. Only the producer writes
+ *          writeCount and only the consumer readCount, each in a cache line
+ *          of its own; both count slots since the ring was opened, so the
+ *          ring is empty when they are equal and full when they are
+ *          numSlots apart. Must match gpp/pool_notify.h.
+ *  ============================================================================
+ */
+typedef struct Ring_Header_tag {
+    Uint32   numSlots ;
+    Uint32   slotSize ;
+    Uint32   pad0 [RING_LINE / 4 - 2] ;
+    Uint32   writeCount ;
+    Uint32   pad1 [RING_LINE / 4 - 1] ;
+    Uint32   readCount ;
+    Uint32   pad2 [RING_LINE / 4 - 1] ;
+} Ring_Header ;
 
 /** ============================================================================
  *  @name   SAMPLE_POOL_ID
@@ -83,6 +254,15 @@ extern "C" {
  */
 #define MPCSXFER_IPS_EVENTNO           5
 
+/** ============================================================================
+ *  @const  MPCSXFER_RING_EVENTNO
+ *
+ *  @desc   The IPS event number both sides ring each other with when they
+ *          have moved a ring counter. Must match gpp/pool_notify.c.
+ *  ============================================================================
+ */
+#define MPCSXFER_RING_EVENTNO          6
+
 typedef struct MPCSXFER_Ctrl_tag {
     Uint32   procId ;
     Uint32   iterNo ;
@@ -18,23 +18,77 @@
 #include <task.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 #define INT_FIXED(number) (((uint16_t)number)<<8)
 #define MULTIPLICATION(A,B) (uint16_t)(((uint32_t)A*(uint32_t)B+(1<<(7)))>>8)  
 #define DIVISION(A,B) (uint16_t)((((uint32_t)A<<8)+(B/2))/B)
+/* The smoothed image leaves the DSP scaled by 90 (BOOSTBLURFACTOR) and rounded to an integer */
+#define BOOST(q) ((uint16_t)(((uint32_t)(q)*90+128)>>8))
 
 extern Uint16 MPCSXFER_BufferSize ;
-unsigned char* buf;
 
-int rows, cols, windowSize;    /* Dimension of the gaussian kernel. */
-//We use static Arrays because are faster than dynamic ones
-unsigned char image[76800];// Local array on DSP memory for received picture from ARM
-uint16_t kernel[20]; // Local array on DSP memory for received kernel from ARM
-uint16_t tempim[76800];// Local array on DSP memory for the first half of calculations from gaussian_smooth
-uint16_t smoothedim[76800];// Local array on DSP memory for the second half of calculations from gaussian_smooth
+int rows, cols, windowSize;    /* Geometry and kernel size of the current command. */
+uint16_t kernel[CMD_KERNEL_MAX]; // Local array on DSP memory for received kernel from ARM
+Uint32 kernelId; // Id of the kernel held in kernel[], 0 before the first one arrives
+/* Set up with every new kernel for the interior of the image, where the whole
+ * window lies inside it: the sum of the taps, its reciprocal, and whether the
+ * taps are symmetric so that the pixels sharing a tap can be added first. */
+uint32_t kernelSum, kernelRecip;
+int kernelFolds;
+/* Coefficients of a CMD_KERNEL_IIR kernel: the weights of the last three
+ * outputs, the second one subtracted, and the gain of the input, with
+ * CMD_IIR_FRAC_BITS fraction bits. */
+uint32_t iirA1, iirA2, iirA3, iirB;
+#define IIR_ROUND ((uint64_t)1<<(CMD_IIR_FRAC_BITS-1))
+/* The recursion keeps IIR_STATE_BITS fraction bits more than the 8 of the
+ * frame in its state. Rounded to 8 at every step, the state would settle up to
+ * 2^(CMD_IIR_FRAC_BITS-9)/B units short of a flat input, grey levels at large
+ * sigma. */
+#define IIR_STATE_BITS 12
+#define IIR_STATE_MAX ((uint32_t)0xFFFF << IIR_STATE_BITS)
+#define IIR_STATE(q) ((uint32_t)(q) << IIR_STATE_BITS)
+#define IIR_FRAME(y) ((uint16_t)(((y) + (1<<(IIR_STATE_BITS-1))) >> IIR_STATE_BITS))
+/* Set by CMD_BENCH_TILES and CMD_BENCH_COLUMNS: the frame is smoothed in tiles
+ * in two passes, as it used to, with the vertical pass walking the tile row by
+ * row or column by column, so the benchmark can compare them. */
+int smoothTiles, yColumns;
+
+/* The frame is smoothed in strips of tileCols columns, or with smoothTiles in
+ * tiles of tileRows x tileCols pixels. The buffers are allocated by CMD_CONFIG
+ * with room for the widest halo around a tile; a strip only uses one input row
+ * of tileIn and windowSize rows of tileTemp. */
+#define HALO_MAX (CMD_KERNEL_MAX/2)
+int tileRows, tileCols;
+unsigned char *tileIn;  // Input pixels of a tile and its halo, or of a strip row
+uint16_t *tileTemp;     // Tile rows and their halo rows after the blur in the x - direction, or the strip line buffer
+
+#define CMD_QUEUE_SIZE 8
+Cmd_Block* volatile cmdQueue[CMD_QUEUE_SIZE];// Command blocks received from ARM, in order of arrival
+volatile unsigned int cmdHead, cmdTail;
+
+/* Rings opened by CMD_RING_OPEN: frames come in on ringFrames, results go out on ringResults */
+Ring_Header *ringFrames, *ringResults;
 
 
 static Void Task_notify (Uint32 eventNo, Ptr arg, Ptr info) ;
+static Void Task_ringNotify (Uint32 eventNo, Ptr arg, Ptr info) ;
+static Int Task_command (Cmd_Block * cmd) ;
+static Int Task_setup (Cmd_Block * cmd) ;
+static Int Task_kernel (Cmd_Block * cmd) ;
+static void Task_ring (void) ;
+static Int Task_config (Cmd_Block * cmd) ;
+static void Task_bench (Cmd_Block * cmd) ;
+static void Task_freeTiles (void) ;
+static Int gaussian_smooth_rows(unsigned char *in, int inFirst, int inRows,
+                                uint16_t *out, int outFirst, int outRows);
+static Int edges_frame(uint16_t *smoothed, short *mag, unsigned char *nms);
+static void gaussian_smooth_tile(unsigned char *in, int inFirst, uint16_t *out, int outFirst,
+                                 int r0, int nr, int c0, int nc);
+static void gaussian_smooth_strip(unsigned char *in, int inFirst, uint16_t *out, int outFirst,
+                                  int outRows, int c0, int nc);
+static void kernel_prepare(void);
+static Int gaussian_iir_frame(unsigned char *in, uint16_t *out);
 
 Int Task_create (Task_TransferInfo ** infoPtr)
 {
@@ -67,8 +121,8 @@ Int Task_create (Task_TransferInfo ** infoPtr)
     }
 
     /*
-     *  Register notification for the event callback to get control and data
-     *  buffer pointers from the GPP-side.
+     *  Register notification for the event callback to get the command blocks
+     *  sent by the GPP-side.
      */
     if (status == SYS_OK) 
 	{
@@ -83,6 +137,22 @@ Int Task_create (Task_TransferInfo ** infoPtr)
         }
     }
 
+    /*
+     *  Register for the doorbell the GPP rings when it has moved a ring counter.
+     */
+    if (status == SYS_OK) 
+	{
+        status = NOTIFY_register (ID_GPP,
+                                  MPCSXFER_IPS_ID,
+                                  MPCSXFER_RING_EVENTNO,
+                                  (FnNotifyCbck) Task_ringNotify,
+                                  info) ;
+        if (status != SYS_OK) 
+		{
+            return status;
+        }
+    }
+
     /*
      *  Send notification to the GPP-side that the application has completed its
      *  setup and is ready for further execution.
@@ -99,92 +169,1035 @@ Int Task_create (Task_TransferInfo ** infoPtr)
         }
     }
 
-    /*
-     *  Wait for the event callback from the GPP-side to post the semaphore
-     *  indicating receipt of the data buffer pointer and image width and height.
-     */
-    
-    SEM_pend (&(info->notifySemObj), SYS_FOREVER) ;//wait for semaphore in order to get databuffer
-    SEM_pend (&(info->notifySemObj), SYS_FOREVER) ;//wait for semaphore in order to get rows from pool_notify_dimension
-    SEM_pend (&(info->notifySemObj), SYS_FOREVER) ;//wait for semaphore in order to get cols from pool_notify_dimension
     return status ;
 }
 
 Int Task_execute (Task_TransferInfo * info)
 {
-// ------------------- Receive Image and windowSize---------------------------------
-    SEM_pend (&(info->notifySemObj), SYS_FOREVER);
-    BCACHE_inv ((Ptr)buf, MEM_SIZE, TRUE) ;
-    memcpy(image,buf,rows*cols);
-    NOTIFY_notify(ID_GPP,MPCSXFER_IPS_ID,MPCSXFER_IPS_EVENTNO,(Uint32)0);
-    
-//-------------------- Receive Kernel from ARM------------------------------------
-    SEM_pend (&(info->notifySemObj), SYS_FOREVER);
-    //invalidate cache
-    BCACHE_inv ((Ptr)buf, MEM_SIZE, TRUE) ;
-    memcpy(kernel,buf,windowSize*sizeof(uint16_t));
-       
-    gaussian_smooth(); // execute gaussian smooth on DSP
-//-----------------------Send smoothed image to ARM----------------------------------
-    memcpy(buf,smoothedim, 76800*sizeof(uint16_t)); 
-    BCACHE_wb((Ptr)buf, MEM_SIZE, TRUE);
-    
-    NOTIFY_notify(ID_GPP,MPCSXFER_IPS_ID,MPCSXFER_IPS_EVENTNO,(Uint32)0); // inform ARM tha DSP finished
-   
+    Cmd_Block * cmd;
+    int done = 0;
+
+    // Run commands until the GPP shuts the session down. A wake up is either a command or a ring doorbell.
+    while (!done) {
+        SEM_pend (&(info->notifySemObj), SYS_FOREVER);
+        if (cmdTail != cmdHead) {
+            cmd = cmdQueue[cmdTail % CMD_QUEUE_SIZE];
+            cmdTail++;
+
+            BCACHE_inv ((Ptr)cmd, sizeof(Cmd_Block), TRUE) ;
+            done = Task_command (cmd);
+            BCACHE_wb ((Ptr)cmd, sizeof(Cmd_Block), TRUE) ;
+            NOTIFY_notify(ID_GPP,MPCSXFER_IPS_ID,MPCSXFER_IPS_EVENTNO,cmd->seq); // inform ARM the command is complete
+        }
+        if (ringFrames != NULL && !done) {
+            Task_ring ();
+        }
+    }
     return SYS_OK;
 }
+//------------------------- Execute one command and store its status ------------------------------------
+/* Returns 1 when the command ends the session */
+static Int Task_command (Cmd_Block * cmd)
+{
+    unsigned char * in;
+    uint16_t * out;
+    int inRows;
+
+    cmd->status = CMD_STATUS_OK;
+    if (cmd->opcode == CMD_SHUTDOWN) {
+        return 1;
+    }
+    if (cmd->opcode == CMD_CONFIG) {
+        cmd->status = Task_config (cmd);
+        return 0;
+    }
+    if (cmd->opcode == CMD_BENCH) {
+        Task_bench (cmd);
+        return 0;
+    }
+    if (cmd->opcode == CMD_RING_OPEN) {
+        ringFrames = (Ring_Header *)cmd->buf;
+        ringResults = (Ring_Header *)((unsigned char *)cmd->buf + cmd->outOffset);
+        BCACHE_inv ((Ptr)ringFrames, RING_HEADER_SIZE, TRUE) ;
+        BCACHE_inv ((Ptr)ringResults, RING_HEADER_SIZE, TRUE) ;
+        return 0;
+    }
+    cmd->status = Task_setup (cmd);
+    if (cmd->status != CMD_STATUS_OK) {
+        return 0;
+    }
+
+    switch (cmd->opcode) {
+    case CMD_SMOOTH:
+        // The frame is read and its rows written in place in the data buffer, the GPP may smooth the others
+        in = (unsigned char *)cmd->buf + cmd->inOffset;
+        out = (uint16_t *)((unsigned char *)cmd->buf + cmd->outOffset) + cmd->firstRow*cols;
+        BCACHE_inv ((Ptr)in, rows*cols, TRUE) ;
+
+        cmd->status = gaussian_smooth_rows(in, 0, rows, out, cmd->firstRow, cmd->numRows); // execute gaussian smooth on DSP
+
+        BCACHE_wb ((Ptr)out, cmd->numRows*cols*sizeof(uint16_t), TRUE);
+        return 0;
+
+    case CMD_SMOOTH_BAND:
+        // The input rows and halo are read and the band is written in place in the band buffer
+        inRows = cmd->haloTop + cmd->numRows + cmd->haloBottom;
+        in = (unsigned char *)cmd->buf + cmd->inOffset;
+        out = (uint16_t *)((unsigned char *)cmd->buf + cmd->outOffset);
+        BCACHE_inv ((Ptr)in, inRows*cols, TRUE) ;
+
+        cmd->status = gaussian_smooth_rows(in, cmd->firstRow - cmd->haloTop, inRows,
+                                           out, cmd->firstRow, cmd->numRows);
+
+        BCACHE_wb ((Ptr)out, cmd->numRows*cols*sizeof(uint16_t), TRUE) ;
+        return 0;
+
+    case CMD_EDGES:
+        // Only the magnitude and the suppression map leave the DSP, the smoothed frame is scratch
+        // The GPP does frames of a single row or column itself
+        if (rows < 2 || cols < 2) {
+            cmd->status = CMD_STATUS_EINVAL;
+            return 0;
+        }
+        in = (unsigned char *)cmd->buf + cmd->inOffset;
+        out = (uint16_t *)((unsigned char *)cmd->buf + cmd->outOffset);
+        BCACHE_inv ((Ptr)in, rows*cols, TRUE) ;
+
+        cmd->status = gaussian_smooth_rows(in, 0, rows, out, 0, rows);
+        if (cmd->status == CMD_STATUS_OK) {
+            cmd->status = edges_frame(out, (short *)((unsigned char *)cmd->buf + cmd->magOffset),
+                                      (unsigned char *)cmd->buf + cmd->nmsOffset);
+        }
+
+        // The scratch is written back too, so no dirty line of it is evicted over later frames
+        BCACHE_wb ((Ptr)out, rows*cols*sizeof(uint16_t), TRUE) ;
+        BCACHE_wb ((Ptr)((unsigned char *)cmd->buf + cmd->magOffset), rows*cols*sizeof(short), TRUE) ;
+        BCACHE_wb ((Ptr)((unsigned char *)cmd->buf + cmd->nmsOffset), rows*cols, TRUE) ;
+        return 0;
+
+    default:
+        cmd->status = CMD_STATUS_EOPCODE;
+        return 0;
+    }
+}
+//------------------------- Check a frame command and take its geometry and kernel -------------------
+static Int Task_setup (Cmd_Block * cmd)
+{
+    Int status;
+
+    if (tileIn == NULL) {
+        return CMD_STATUS_EINVAL;
+    }
+    status = Task_kernel (cmd);
+    if (status != CMD_STATUS_OK) {
+        return status;
+    }
+
+    if (cmd->firstRow + cmd->numRows > rows) {
+        return CMD_STATUS_EINVAL;
+    }
+    // The recursive Gaussian only smooths whole frames
+    if (windowSize == CMD_KERNEL_IIR
+        && (cmd->opcode == CMD_SMOOTH_BAND || cmd->firstRow != 0 || cmd->numRows != rows)) {
+        return CMD_STATUS_EINVAL;
+    }
+    return CMD_STATUS_OK;
+}
+
+static Int Task_kernel (Cmd_Block * cmd)
+{
+    if (cmd->windowSize > CMD_KERNEL_MAX
+        || ((cmd->windowSize & 1) == 0 && cmd->windowSize != CMD_KERNEL_IIR)) {
+        return CMD_STATUS_EINVAL;
+    }
+    rows = cmd->rows;
+    cols = cmd->cols;
+    // The taps only travel with the first command that uses a new kernel
+    if (cmd->kernelId != kernelId) {
+        windowSize = cmd->windowSize;
+        memcpy(kernel, cmd->kernel, windowSize*sizeof(uint16_t));
+        kernelId = cmd->kernelId;
+        kernel_prepare();
+    }
+    return CMD_STATUS_OK;
+}
+//------------------------- Smooth every frame waiting on the frame ring ------------------------------
+/* Slot count % numSlots of ring */
+static Cmd_Block * Task_ringSlot (Ring_Header * ring, Uint32 count)
+{
+    return (Cmd_Block *)((unsigned char *)ring + RING_HEADER_SIZE + (count % ring->numSlots) * ring->slotSize);
+}
+
+/* Runs until the frame ring is empty or the result ring full; the GPP rings
+ * again when it adds a frame or frees a result slot */
+static void Task_ring (void)
+{
+    Cmd_Block * frame;
+    Cmd_Block * result;
+    Uint32 pixels;
+
+    for (;;) {
+        BCACHE_inv ((Ptr)&ringFrames->writeCount, RING_LINE, TRUE) ;
+        BCACHE_inv ((Ptr)&ringResults->readCount, RING_LINE, TRUE) ;
+        if (ringFrames->readCount == ringFrames->writeCount) return;
+        if (ringResults->writeCount - ringResults->readCount >= ringResults->numSlots) return;
+
+        frame = Task_ringSlot (ringFrames, ringFrames->readCount);
+        result = Task_ringSlot (ringResults, ringResults->writeCount);
+        BCACHE_inv ((Ptr)frame, sizeof(Cmd_Block), TRUE) ;
+        memcpy (result, frame, sizeof(Cmd_Block));
+        pixels = frame->rows * frame->cols;
+        result->status = Task_setup (frame);
+        if (result->status == CMD_STATUS_OK
+            && (CMD_SLOT_SIZE + pixels > ringFrames->slotSize
+                || CMD_SLOT_SIZE + pixels*sizeof(uint16_t) > ringResults->slotSize)) {
+            result->status = CMD_STATUS_EINVAL;
+        }
+        if (result->status == CMD_STATUS_OK) {
+            BCACHE_inv ((Ptr)((unsigned char *)frame + CMD_SLOT_SIZE), pixels, TRUE) ;
+            result->status = gaussian_smooth_rows((unsigned char *)frame + CMD_SLOT_SIZE, 0, rows,
+                                                  (uint16_t *)((unsigned char *)result + CMD_SLOT_SIZE), 0, rows);
+            BCACHE_wb ((Ptr)((unsigned char *)result + CMD_SLOT_SIZE), pixels*sizeof(uint16_t), TRUE) ;
+        }
+        BCACHE_wb ((Ptr)result, sizeof(Cmd_Block), TRUE) ;
+
+        // Publish the result only once it is in memory, then free the frame slot
+        ringResults->writeCount++;
+        BCACHE_wb ((Ptr)&ringResults->writeCount, RING_LINE, TRUE) ;
+        ringFrames->readCount++;
+        BCACHE_wb ((Ptr)&ringFrames->readCount, RING_LINE, TRUE) ;
+        NOTIFY_notify(ID_GPP,MPCSXFER_IPS_ID,MPCSXFER_RING_EVENTNO,result->seq);
+    }
+}
+//------------------------- Transport benchmark steps, the GPP times the round trip -------------------
+static void Task_bench (Cmd_Block * cmd)
+{
+    unsigned char * region = (unsigned char *)cmd->buf + cmd->inOffset;
+    Uint32 size = cmd->rows * cmd->cols;
+    uint16_t * out;
+
+    if (cmd->numRows & CMD_BENCH_INV) {
+        BCACHE_inv ((Ptr)region, size, TRUE) ;
+    }
+    if (cmd->numRows & CMD_BENCH_FILL) {
+        memset (region, (int)(cmd->seq & 0xFF), size) ;
+    }
+    if (cmd->numRows & CMD_BENCH_WB) {
+        BCACHE_wb ((Ptr)region, size, TRUE) ;
+    }
+    if (cmd->numRows & CMD_BENCH_SMOOTH) {
+        // The result is written back so the GPP can compare the variants
+        if (tileIn == NULL || Task_kernel (cmd) != CMD_STATUS_OK) {
+            cmd->status = CMD_STATUS_EINVAL;
+            return;
+        }
+        out = (uint16_t *)((unsigned char *)cmd->buf + cmd->outOffset);
+        yColumns = (cmd->numRows & CMD_BENCH_COLUMNS) != 0;
+        smoothTiles = yColumns || (cmd->numRows & CMD_BENCH_TILES) != 0;
+        cmd->status = gaussian_smooth_rows(region, 0, rows, out, 0, rows);
+        smoothTiles = yColumns = 0;
+        BCACHE_wb ((Ptr)out, rows*cols*sizeof(uint16_t), TRUE) ;
+    }
+}
+//------------------------- Allocate the tile buffers for the session --------------------------------
+static Int Task_config (Cmd_Block * cmd)
+{
+    if (cmd->rows == 0 || cmd->cols == 0) {
+        return CMD_STATUS_EINVAL;
+    }
+    Task_freeTiles ();
+    tileIn = MEM_alloc (DSPLINK_SEGID,
+                        (cmd->rows + 2*HALO_MAX) * (cmd->cols + 2*HALO_MAX),
+                        DSPLINK_BUF_ALIGN) ;
+    tileTemp = MEM_alloc (DSPLINK_SEGID,
+                          (cmd->rows + 2*HALO_MAX) * cmd->cols * sizeof(uint16_t),
+                          DSPLINK_BUF_ALIGN) ;
+    if (tileIn == MEM_ILLEGAL || tileTemp == MEM_ILLEGAL) {
+        Task_freeTiles ();
+        return CMD_STATUS_ENOMEM;
+    }
+    tileRows = cmd->rows;
+    tileCols = cmd->cols;
+    return CMD_STATUS_OK;
+}
+
+static void Task_freeTiles (void)
+{
+    if (tileIn != NULL && tileIn != MEM_ILLEGAL) {
+        MEM_free (DSPLINK_SEGID, tileIn, (tileRows + 2*HALO_MAX) * (tileCols + 2*HALO_MAX)) ;
+    }
+    if (tileTemp != NULL && tileTemp != MEM_ILLEGAL) {
+        MEM_free (DSPLINK_SEGID, tileTemp, (tileRows + 2*HALO_MAX) * tileCols * sizeof(uint16_t)) ;
+    }
+    tileIn = NULL;
+    tileTemp = NULL;
+}
 //------------------------- GAUSSIAN SMOOTH WITH FIXED POINT ARITHMETICS--------------------------------
-void gaussian_smooth()
+/* Smooths outRows image rows starting at row outFirst into out. in holds inRows
+ * image rows starting at row inFirst, which must cover the output rows plus
+ * windowSize/2 rows above and below them wherever the image has them. The rows
+ * are processed in strips of at most tileCols columns. A CMD_KERNEL_IIR kernel
+ * smooths the whole frame, which Task_setup has checked in and out hold.
+ * Returns the status of the command. */
+static Int gaussian_smooth_rows(unsigned char *in, int inFirst, int inRows,
+                                uint16_t *out, int outFirst, int outRows)
+{
+    int r0, c0, nr, nc;
+
+    (void) inRows; /* Covered by the caller */
+    if(windowSize == CMD_KERNEL_IIR)
+    {
+        return gaussian_iir_frame(in, out);
+    }
+    for(c0=0; c0<cols && !smoothTiles; c0+=tileCols)
+    {
+        nc = (cols-c0 < tileCols) ? cols-c0 : tileCols;
+        gaussian_smooth_strip(in, inFirst, out, outFirst, outRows, c0, nc);
+    }
+    for(r0=outFirst; r0<outFirst+outRows && smoothTiles; r0+=tileRows)
+    {
+        nr = (outFirst+outRows-r0 < tileRows) ? outFirst+outRows-r0 : tileRows;
+        for(c0=0; c0<cols; c0+=tileCols)
+        {
+            nc = (cols-c0 < tileCols) ? cols-c0 : tileCols;
+            gaussian_smooth_tile(in, inFirst, out, outFirst, r0, nr, c0, nc);
+        }
+    }
+    return CMD_STATUS_OK;
+}
+/* Sum, reciprocal and symmetry of the kernel just received */
+static void kernel_prepare(void)
+{
+    int i;
+
+    if(windowSize == CMD_KERNEL_IIR)
+    {
+        iirA1 = kernel[0] | (uint32_t)kernel[1] << 16;
+        iirA2 = kernel[2] | (uint32_t)kernel[3] << 16;
+        iirA3 = kernel[4] | (uint32_t)kernel[5] << 16;
+        iirB = kernel[6] | (uint32_t)kernel[7] << 16;
+    }
+    kernelSum = 0;
+    kernelFolds = 1;
+    for(i=0; i<windowSize; i++)
+    {
+        kernelSum += kernel[i];
+        if(kernel[i] != kernel[windowSize-1-i]) kernelFolds = 0;
+    }
+    if(kernelSum == 0) kernelFolds = 0;
+    kernelRecip = kernelFolds ? 0xFFFFFFFFu / kernelSum : 0;
+}
+
+/* DIVISION(dot, kernelSum) without a divide. The multiply by the reciprocal is
+ * short by at most one, which the remainder corrects, so the result is exact. */
+static inline uint16_t division_recip(uint32_t dot)
+{
+    uint32_t n = (dot<<8) + kernelSum/2;
+    uint32_t q = (uint32_t)(((uint64_t)n * kernelRecip) >> 32);
+
+    if(n - q*kernelSum >= kernelSum) q++;
+    return (uint16_t) q;
+}
+
+/* Blurs in the x - direction the image columns [from, to) of a staged row,
+ * leaving out the taps past the ends of the image row and renormalizing the
+ * others. row holds the image columns from left on. */
+static void blur_x_normalized(unsigned char *row, int left, uint16_t *temp, int c0,
+                              int from, int to)
+{
+    int c, cc, center = windowSize/2;
+    uint32_t dot, sum;
+
+    for(c=from; c<to; c++)
+    {
+        dot = 0;
+        sum = 0;
+        for(cc=(-center); cc<=center; cc++)
+        {
+            if(((c+cc) >= 0) && ((c+cc) < cols))
+            {
+                dot += MULTIPLICATION(INT_FIXED(row[c+cc-left]), kernel[center+cc]);
+                sum += kernel[center+cc];
+            }
+        }
+        temp[c-c0] = DIVISION(dot,sum);
+    }
+}
+
+/* Blurs in the x - direction n pixels from p whose windows lie inside the row.
+ * A pixel times a tap is exact in Q8.8, so the two pixels sharing a tap are
+ * added first. center is a constant in the specializations, so the taps are
+ * unrolled and held in registers. */
+static inline void blur_x_interior(unsigned char *p, uint16_t *temp, int n, const int center)
+{
+    uint32_t k[HALO_MAX+1], dot;
+    int c, i;
+
+    for(i=0; i<=center; i++) k[i] = kernel[center+i];
+    for(c=0; c<n; c++, p++)
+    {
+        dot = k[0]*p[0];
+        for(i=1; i<=center; i++) dot += k[i]*(p[-i]+p[i]);
+        temp[c] = division_recip(dot);
+    }
+}
+
+/* Windows of 7 to 17 taps, sigma 1 to 3, get their own unrolled loop */
+static void blur_x_interior_any(unsigned char *p, uint16_t *temp, int n)
+{
+    switch(windowSize/2)
+    {
+    case 3: blur_x_interior(p, temp, n, 3); break;
+    case 4: blur_x_interior(p, temp, n, 4); break;
+    case 5: blur_x_interior(p, temp, n, 5); break;
+    case 6: blur_x_interior(p, temp, n, 6); break;
+    case 7: blur_x_interior(p, temp, n, 7); break;
+    case 8: blur_x_interior(p, temp, n, 8); break;
+    default: blur_x_interior(p, temp, n, windowSize/2); break;
+    }
+}
+
+/* Blurs in the y - direction and scales the image rows [from, to) of a column,
+ * renormalizing the taps inside the image. temp holds the column from image
+ * row top on, nc apart, and out the output column from row outFirst on. Every
+ * tap is a stride of a row away, which is what the row order avoids; it is
+ * kept for CMD_BENCH_COLUMNS. */
+static void blur_y_column_normalized(uint16_t *temp, int top, int nc, uint16_t *out, int outFirst,
+                              int from, int to)
+{
+    int r, rr, center = windowSize/2;
+    uint32_t dot, sum;
+
+    for(r=from; r<to; r++)
+    {
+        sum = 0;
+        dot = 0;
+        for(rr=(-center); rr<=center; rr++)
+        {
+            if(((r+rr) >= 0) && ((r+rr) < rows))
+            {
+                dot += MULTIPLICATION(temp[(r+rr-top)*nc],kernel[center+rr]);
+                sum += kernel[center+rr];
+            }
+        }
+        out[(r-outFirst)*cols] = BOOST(DIVISION(dot,sum));
+    }
+}
+
+/* Blurs in the y - direction and scales n pixels of a column from t, nc apart,
+ * whose windows lie inside the image. */
+static inline void blur_y_column_interior(uint16_t *t, int nc, uint16_t *out, int n, const int center)
+{
+    uint32_t k[HALO_MAX+1], dot;
+    int r, i;
+
+    for(i=0; i<=center; i++) k[i] = kernel[center+i];
+    for(r=0; r<n; r++, t+=nc, out+=cols)
+    {
+        dot = MULTIPLICATION(t[0], k[0]);
+        for(i=1; i<=center; i++) dot += MULTIPLICATION(t[-i*nc], k[i]) + MULTIPLICATION(t[i*nc], k[i]);
+        *out = BOOST(division_recip(dot));
+    }
+}
+
+static void blur_y_column_interior_any(uint16_t *t, int nc, uint16_t *out, int n)
+{
+    switch(windowSize/2)
+    {
+    case 3: blur_y_column_interior(t, nc, out, n, 3); break;
+    case 4: blur_y_column_interior(t, nc, out, n, 4); break;
+    case 5: blur_y_column_interior(t, nc, out, n, 5); break;
+    case 6: blur_y_column_interior(t, nc, out, n, 6); break;
+    case 7: blur_y_column_interior(t, nc, out, n, 7); break;
+    case 8: blur_y_column_interior(t, nc, out, n, 8); break;
+    default: blur_y_column_interior(t, nc, out, n, windowSize/2); break;
+    }
+}
+
+/* Blurs in the y - direction and scales the nc pixels of image row r into out,
+ * renormalizing the taps inside the image. temp holds the tile rows from image
+ * row top on. The taps and their sum are the same along the row, so each tap
+ * row is walked contiguously. */
+static void blur_y_row_normalized(uint16_t *temp, int top, int nc, int r, uint16_t *out)
+{
+    int c, rr, lo, hi, center = windowSize/2;
+    uint32_t dot, sum = 0;
+
+    lo = (r-center >= 0) ? -center : -r;
+    hi = (r+center < rows) ? center : rows-1-r;
+    for(rr=lo; rr<=hi; rr++) sum += kernel[center+rr];
+    for(c=0; c<nc; c++)
+    {
+        dot = 0;
+        for(rr=lo; rr<=hi; rr++)
+        {
+            dot += MULTIPLICATION(temp[(r+rr-top)*nc+c],kernel[center+rr]);
+        }
+        out[c] = BOOST(DIVISION(dot,sum));
+    }
+}
+
+/* Blurs in the y - direction and scales the nc pixels of a row whose windows
+ * lie inside the image. t points at the row, the rows of the window are nc
+ * apart. Every product is rounded on its own, as in the normalizing path, so
+ * only the reciprocal and the unrolling apply. The pixels of the row are
+ * independent and each tap row is read contiguously, so the loop pipelines. */
+static inline void blur_y_row_interior(uint16_t *t, int nc, uint16_t *out, const int center)
+{
+    uint32_t k[HALO_MAX+1], dot;
+    int c, i;
+
+    for(i=0; i<=center; i++) k[i] = kernel[center+i];
+    for(c=0; c<nc; c++)
+    {
+        dot = MULTIPLICATION(t[c], k[0]);
+        for(i=1; i<=center; i++) dot += MULTIPLICATION(t[c-i*nc], k[i]) + MULTIPLICATION(t[c+i*nc], k[i]);
+        out[c] = BOOST(division_recip(dot));
+    }
+}
+
+static void blur_y_row_interior_any(uint16_t *t, int nc, uint16_t *out)
+{
+    switch(windowSize/2)
+    {
+    case 3: blur_y_row_interior(t, nc, out, 3); break;
+    case 4: blur_y_row_interior(t, nc, out, 4); break;
+    case 5: blur_y_row_interior(t, nc, out, 5); break;
+    case 6: blur_y_row_interior(t, nc, out, 6); break;
+    case 7: blur_y_row_interior(t, nc, out, 7); break;
+    case 8: blur_y_row_interior(t, nc, out, 8); break;
+    default: blur_y_row_interior(t, nc, out, windowSize/2); break;
+    }
+}
+
+/* Blurs in the y - direction and scales the nc pixels of a row from the lines
+ * of its window, line[center+rr] holding the row rr away after the blur in the
+ * x - direction. Only the taps [lo, hi] inside the image are used, and
+ * renormalized. */
+static void blur_y_lines_normalized(uint16_t **line, int lo, int hi, int nc, uint16_t *out)
+{
+    int c, rr, center = windowSize/2;
+    uint32_t dot, sum = 0;
+
+    for(rr=lo; rr<=hi; rr++) sum += kernel[center+rr];
+    for(c=0; c<nc; c++)
+    {
+        dot = 0;
+        for(rr=lo; rr<=hi; rr++)
+        {
+            dot += MULTIPLICATION(line[center+rr][c],kernel[center+rr]);
+        }
+        out[c] = BOOST(DIVISION(dot,sum));
+    }
+}
+
+/* As blur_y_row_interior, with the rows of the window wherever the line
+ * buffer holds them. */
+static inline void blur_y_lines_interior(uint16_t **line, int nc, uint16_t *out, const int center)
+{
+    uint32_t k[HALO_MAX+1], dot;
+    uint16_t *l[2*HALO_MAX+1];
+    int c, i;
+
+    for(i=0; i<=center; i++) k[i] = kernel[center+i];
+    for(i=0; i<=2*center; i++) l[i] = line[i];
+    for(c=0; c<nc; c++)
+    {
+        dot = MULTIPLICATION(l[center][c], k[0]);
+        for(i=1; i<=center; i++) dot += MULTIPLICATION(l[center-i][c], k[i]) + MULTIPLICATION(l[center+i][c], k[i]);
+        out[c] = BOOST(division_recip(dot));
+    }
+}
+
+static void blur_y_lines_interior_any(uint16_t **line, int nc, uint16_t *out)
+{
+    switch(windowSize/2)
+    {
+    case 3: blur_y_lines_interior(line, nc, out, 3); break;
+    case 4: blur_y_lines_interior(line, nc, out, 4); break;
+    case 5: blur_y_lines_interior(line, nc, out, 5); break;
+    case 6: blur_y_lines_interior(line, nc, out, 6); break;
+    case 7: blur_y_lines_interior(line, nc, out, 7); break;
+    case 8: blur_y_lines_interior(line, nc, out, 8); break;
+    default: blur_y_lines_interior(line, nc, out, windowSize/2); break;
+    }
+}
+
+/* Smooths the output rows [outFirst, outFirst+outRows) of the nc columns from
+ * column c0 in a single pass down the strip. Each input row is staged in tileIn
+ * and blurred in the x - direction into a circular buffer of windowSize lines
+ * in tileTemp, image row r in line r % windowSize, and each output row is
+ * written as soon as the last row of its window is in. Every row is blurred in
+ * the x - direction once, and the working set is windowSize lines of the strip
+ * whatever the size of the frame. */
+static void gaussian_smooth_strip(unsigned char *in, int inFirst, uint16_t *out, int outFirst,
+                                  int outRows, int c0, int nc)
+{
+    int r, o, rr,            /* Counter variables, r an input and o an output image row. */
+        center,              /* Half of the windowsize. */
+        top, bottom,         /* Input image rows [top, bottom) of the strip. */
+        left, right,         /* Image columns [left, right) staged in tileIn. */
+        xFrom, xTo,          /* Strip columns [xFrom, xTo) with the whole window in the image. */
+        lo, hi;              /* Taps of the window of o inside the image. */
+    uint16_t *line[2*HALO_MAX+1]; /* The lines of the window of o. */
+    uint16_t *temp;
+
+    center = windowSize / 2;
+    top = (outFirst-center > 0) ? outFirst-center : 0;
+    bottom = (outFirst+outRows+center < rows) ? outFirst+outRows+center : rows;
+    left = (c0-center > 0) ? c0-center : 0;
+    right = (c0+nc+center < cols) ? c0+nc+center : cols;
+    xFrom = (c0 > center) ? c0 : center;
+    xTo = (c0+nc < cols-center) ? c0+nc : cols-center;
+    if(!kernelFolds || xTo < xFrom) xFrom = xTo = c0+nc;
+
+    r = top;
+    for(o=outFirst; o<outFirst+outRows; o++)
+    {
+        /****************************************************************************
+        * Blur in the x - direction the rows up to the last one of the window of o.
+        ****************************************************************************/
+        for(; r<bottom && r<=o+center; r++)
+        {
+            memcpy(tileIn, in+(r-inFirst)*cols+left, right-left);
+            temp = tileTemp+(r%windowSize)*nc;
+            blur_x_normalized(tileIn, left, temp, c0, c0, xFrom);
+            blur_x_interior_any(tileIn+xFrom-left, temp+xFrom-c0, xTo-xFrom);
+            blur_x_normalized(tileIn, left, temp, c0, xTo, c0+nc);
+        }
+        /****************************************************************************
+        * Blur row o in the y - direction.
+        ****************************************************************************/
+        lo = (o-center >= 0) ? -center : -o;
+        hi = (o+center < rows) ? center : rows-1-o;
+        for(rr=lo; rr<=hi; rr++) line[center+rr] = tileTemp+((o+rr)%windowSize)*nc;
+        if(kernelFolds && lo == -center && hi == center)
+            blur_y_lines_interior_any(line, nc, out+(o-outFirst)*cols+c0);
+        else
+            blur_y_lines_normalized(line, lo, hi, nc, out+(o-outFirst)*cols+c0);
+    }
+}
+
+/* Smooths the nr x nc pixels at image row r0, column c0. The tile and the halo
+ * the image has around it are staged in tileIn, so every pixel is read from the
+ * shared buffer once, and the x - direction blur of the tile rows and their halo
+ * rows is kept in tileTemp. Pixels outside the image are left out of the window
+ * and the remaining taps renormalized, exactly as for the whole frame; where the
+ * whole window lies inside the image the taps need neither a check nor a sum. */
+static void gaussian_smooth_tile(unsigned char *in, int inFirst, uint16_t *out, int outFirst,
+                                 int r0, int nr, int c0, int nc)
 {   
-int r, c, rr, cc,    /* Counter variables. */
-        center;            /* Half of the windowsize. */
-    uint32_t dot,sum;              /* Dot product summing variable. */
-                      
+int r, c,            /* Counter variables. */
+        center,            /* Half of the windowsize. */
+        top, bottom,       /* Image rows [top, bottom) staged in tileIn. */
+        left, right,       /* Image columns [left, right) staged in tileIn. */
+        xFrom, xTo,        /* Tile columns [xFrom, xTo) with the whole window in the image. */
+        yFrom, yTo;        /* Tile rows [yFrom, yTo) with the whole window in the image. */
+    int width;             /* Row length of tileIn. */
+    unsigned char *row;
 	
     center = windowSize / 2;
+    top = (r0-center > 0) ? r0-center : 0;
+    bottom = (r0+nr+center < rows) ? r0+nr+center : rows;
+    left = (c0-center > 0) ? c0-center : 0;
+    right = (c0+nc+center < cols) ? c0+nc+center : cols;
+    width = right-left;
+    xFrom = (c0 > center) ? c0 : center;
+    xTo = (c0+nc < cols-center) ? c0+nc : cols-center;
+    yFrom = (r0 > center) ? r0 : center;
+    yTo = (r0+nr < rows-center) ? r0+nr : rows-center;
+    if(!kernelFolds || xTo < xFrom) xFrom = xTo = c0+nc;
+    if(!kernelFolds || yTo < yFrom) yFrom = yTo = r0+nr;
+
+    for(r=top; r<bottom; r++)
+    {
+        memcpy(tileIn+(r-top)*width, in+(r-inFirst)*cols+left, width);
+    }
 	/****************************************************************************
-    * Blur in the x - direction.
+    * Blur in the x - direction. r and c are image coordinates.
     ****************************************************************************/
     
+    for(r=top; r<bottom; r++)
+    {
+        row = tileIn+(r-top)*width;
+        blur_x_normalized(row, left, tileTemp+(r-top)*nc, c0, c0, xFrom);
+        blur_x_interior_any(row+xFrom-left, tileTemp+(r-top)*nc+xFrom-c0, xTo-xFrom);
+        blur_x_normalized(row, left, tileTemp+(r-top)*nc, c0, xTo, c0+nc);
+    }
+    /****************************************************************************
+    * Blur in the y - direction, a whole tile row at a time. r is an image row.
+    ****************************************************************************/
+    for(r=r0; r<r0+nr && !yColumns; r++)
+    {
+        if(r >= yFrom && r < yTo)
+            blur_y_row_interior_any(tileTemp+(r-top)*nc, nc, out+(r-outFirst)*cols+c0);
+        else
+            blur_y_row_normalized(tileTemp, top, nc, r, out+(r-outFirst)*cols+c0);
+    }
+    for(c=c0; c<c0+nc && yColumns; c++)
+    {
+        blur_y_column_normalized(tileTemp+(c-c0), top, nc, out+c, outFirst, r0, yFrom);
+        blur_y_column_interior_any(tileTemp+(yFrom-top)*nc+(c-c0), nc, out+(yFrom-outFirst)*cols+c, yTo-yFrom);
+        blur_y_column_normalized(tileTemp+(c-c0), top, nc, out+c, outFirst, yTo, r0+nr);
+    }
+}
+//------------------------- RECURSIVE GAUSSIAN FOR LARGE SIGMA -----------------------------------------
+/* One step of the recursion: the input x and the last three outputs, all with
+ * 8 + IIR_STATE_BITS fraction bits. The coefficients add up to one, so a
+ * constant input is kept as it is. They are below 2^26 and the values below
+ * 2^28, so the products are taken in 64 bits. The output is clamped to what
+ * the frame can store. */
+static inline uint32_t iir_step(uint32_t x, uint32_t y1, uint32_t y2, uint32_t y3)
+{
+    uint64_t plus = (uint64_t)iirB*x + (uint64_t)iirA1*y1 + (uint64_t)iirA3*y3;
+    uint64_t minus = (uint64_t)iirA2*y2, y;
+
+    if(plus <= minus) return 0;
+    y = (plus - minus + IIR_ROUND) >> CMD_IIR_FRAC_BITS;
+    return (uint32_t)((y > IIR_STATE_MAX) ? IIR_STATE_MAX : y);
+}
+
+/* Blurs an image row in the x - direction, forwards and then backwards in
+ * place. The recursion starts as if the row went on with its end pixels. */
+static void blur_iir_row(unsigned char *in, uint16_t *out)
+{
+    int c;
+    uint32_t y, y1, y2, y3;
+
+    y1 = y2 = y3 = IIR_STATE(INT_FIXED(in[0]));
+    for(c=0; c<cols; c++)
+    {
+        y = iir_step(IIR_STATE(INT_FIXED(in[c])), y1, y2, y3);
+        out[c] = IIR_FRAME(y);
+        y3 = y2; y2 = y1; y1 = y;
+    }
+    y1 = y2 = y3 = IIR_STATE(out[cols-1]);
+    for(c=cols-1; c>=0; c--)
+    {
+        y = iir_step(IIR_STATE(out[c]), y1, y2, y3);
+        out[c] = IIR_FRAME(y);
+        y3 = y2; y2 = y1; y1 = y;
+    }
+}
+
+/* One step of the recursion in the y - direction for a whole row t in place.
+ * y1 to y3 are the last three rows it went through, in the state format;
+ * the new row replaces y3, the oldest. */
+static void blur_iir_lines(uint16_t *t, uint32_t *y1, uint32_t *y2, uint32_t *y3)
+{
+    int c;
+
+    for(c=0; c<cols; c++)
+    {
+        y3[c] = iir_step(IIR_STATE(t[c]), y1[c], y2[c], y3[c]);
+        t[c] = IIR_FRAME(y3[c]);
+    }
+}
+
+/* Starts the recursion down or up the columns as if the frame went on with
+ * its end row t */
+static void iir_lines_start(uint32_t *state, uint16_t *t)
+{
+    int c;
+
+    for(c=0; c<cols; c++) state[c] = state[cols+c] = state[2*cols+c] = IIR_STATE(t[c]);
+}
+
+static void boost_row(uint16_t *t)
+{
+    int c;
+
+    for(c=0; c<cols; c++) t[c] = BOOST(t[c]);
+}
+
+/* Smooths a whole frame with the recursive Gaussian into out. The first sweep
+ * down the frame blurs every row in the x - direction and runs the forward
+ * recursion down the columns, the second one the backward recursion up the
+ * columns, scaling each row as soon as it is done. The state of the column
+ * recursion, the last three rows, is kept in a buffer of its own, row k at
+ * k % 3. Both sweeps walk the frame a row at a time, and the cost per pixel
+ * does not depend on sigma. */
+static Int gaussian_iir_frame(unsigned char *in, uint16_t *out)
+{
+    uint32_t *state;
+    int r;
+
+    state = MEM_alloc (DSPLINK_SEGID, 3*cols*sizeof(uint32_t), DSPLINK_BUF_ALIGN) ;
+    if (state == MEM_ILLEGAL) {
+        return CMD_STATUS_ENOMEM;
+    }
+
     for(r=0; r<rows; r++)
     {
-        for(c=0; c<cols; c++)
+        blur_iir_row(in+r*cols, out+r*cols);
+        if(r == 0) iir_lines_start(state, out);
+        blur_iir_lines(out+r*cols, state+((r+2)%3)*cols, state+((r+1)%3)*cols, state+(r%3)*cols);
+    }
+    iir_lines_start(state, out+(rows-1)*cols);
+    for(r=rows-1; r>=0; r--)
+    {
+        blur_iir_lines(out+r*cols, state+((r+1)%3)*cols, state+((r+2)%3)*cols, state+(r%3)*cols);
+        boost_row(out+r*cols);
+    }
+
+    MEM_free (DSPLINK_SEGID, state, 3*cols*sizeof(uint32_t)) ;
+    return CMD_STATUS_OK;
+}
+//------------------------- DERIVATIVE, MAGNITUDE AND NON-MAXIMAL SUPPRESSION --------------------------
+/* The same steps as derrivative_x_y, magnitude_x_y and non_max_supp on the GPP,
+ * done row by row so only two rows of each derivative are ever kept. The C64x+
+ * has no floating point unit, so the float rounding the GPP versions give is
+ * reproduced in integers, as gpp/magnitude.c and gpp/hysteresis.c do. */
+#define NOEDGE 255
+#define POSSIBLE_EDGE 128
+#define MAG_MAX 32767
+
+/* Values non_max_supp carries from one pixel to the next: gx and gy choose the
+ * neighbours, px, py and pm are the derivatives and the magnitude of the last
+ * pixel with a non-zero magnitude. A pixel with a zero magnitude reuses them,
+ * so they must follow the same order as on the GPP. */
+typedef struct Nms_State_tag {
+    short gx, gy;
+    short px, py, pm;
+} Nms_State;
+
+static void derivative_row(uint16_t *smoothed, int r, short *dx, short *dy)
+{
+    uint16_t *row = smoothed + r*cols;
+    uint16_t *up = (r > 0) ? row - cols : row;
+    uint16_t *down = (r < rows-1) ? row + cols : row;
+    int c;
+
+    dx[0] = (short)row[1] - (short)row[0];
+    for(c=1; c<cols-1; c++)
+    {
+        dx[c] = (short)row[c+1] - (short)row[c-1];
+    }
+    dx[cols-1] = (short)row[cols-1] - (short)row[cols-2];
+    for(c=0; c<cols; c++)
+    {
+        dy[c] = (short)down[c] - (short)up[c];
+    }
+}
+
+/* n rounded to the 24 bit significand of a float, ties to even, returning the
+ * significand and adding its exponent to *e. */
+static uint64_t round_significand(uint64_t n, int *e)
+{
+    int s = 0;
+    uint64_t rem, half;
+
+    while((n >> s) >= ((uint64_t)1 << 24)) s++;
+    if(s == 0) return n;
+    rem = n & (((uint64_t)1 << s) - 1);
+    half = (uint64_t)1 << (s-1);
+    n >>= s;
+    if(rem > half || (rem == half && (n & 1))) n++;
+    *e += s;
+    return n;
+}
+
+/* x rounded as the conversion to float rounds it */
+static uint32_t round_float(uint32_t x)
+{
+    int e = 0;
+    uint64_t m = round_significand(x, &e);
+
+    return (uint32_t)(m << e);
+}
+
+/* The square root of n rounded to the nearest integer, bit by bit. n can not
+ * be k*k + k exactly between two roots, so there are no ties. */
+static uint32_t round_sqrt(uint32_t n)
+{
+    uint32_t root = 0, bit = 1u << 30, rem = n;
+
+    while(bit > n) bit >>= 2;
+    while(bit != 0)
+    {
+        if(rem >= root + bit)
         {
-            dot = 0;
-            sum = 0;
-            for(cc=(-center); cc<=center; cc++)
-            {
-                if(((c+cc) >= 0) && ((c+cc) < cols))
-                {
-                    dot += MULTIPLICATION(INT_FIXED(image[r*cols+(c+cc)]), kernel[center+cc]);
-                    sum += kernel[center+cc];
-                }
-            }
-            tempim[r*cols+c] = DIVISION(dot,sum);
+            rem -= root + bit;
+            root = (root >> 1) + bit;
         }
+        else root >>= 1;
+        bit >>= 2;
     }
-    /****************************************************************************
-    * Blur in the y - direction.
-    ****************************************************************************/
+    return root + (rem > root);
+}
+
+/* The exact magnitude of the GPP: the squares and their sum rounded the way
+ * the float version rounds them, and their rounded square root. */
+static void magnitude_row(short *dx, short *dy, short *mag)
+{
+    int c;
+    uint32_t sq1, sq2, m;
+
     for(c=0; c<cols; c++)
     {
-        for(r=0; r<rows; r++)
+        sq1 = (uint32_t)((int)dx[c] * (int)dx[c]);
+        sq2 = (uint32_t)((int)dy[c] * (int)dy[c]);
+        m = round_sqrt(round_float(round_float(sq1) + round_float(sq2)));
+        mag[c] = (short)((m > MAG_MAX) ? MAG_MAX : m);
+    }
+}
+
+/* The float quotient p/m of p >= 0 and m > 0, as a significand and its
+ * exponent in *e. Two more bits of the quotient and one for any remainder
+ * round like the exact quotient. */
+static uint64_t float_quotient(uint32_t p, uint32_t m, int *e)
+{
+    uint64_t num, q;
+    int k = 0;
+
+    *e = 0;
+    if(p == 0) return 0;
+    while(((uint64_t)p << k) < ((uint64_t)m << 25)) k++;
+    num = (uint64_t)p << k;
+    q = ((num / m) << 1) | ((num % m) != 0);
+    *e = -k-1;
+    return round_significand(q, e);
+}
+
+/* The float product of a and the float sign * q * 2^e, as a signed
+ * significand and its exponent in *pe. */
+static int64_t float_product(int a, int sign, uint64_t q, int e, int *pe)
+{
+    uint64_t m;
+
+    *pe = e;
+    m = round_significand((uint64_t)abs(a) * q, pe);
+    return ((a < 0) != (sign < 0)) ? -(int64_t)m : (int64_t)m;
+}
+
+/* The sign of a*xperp + b*yperp as the float version computes it, with
+ * xperp = -px/pm and yperp = py/pm. Only the sign of e = -a*px + b*py, an
+ * exact integer, matters unless it is within the float rounding of zero; then
+ * the float quotients, products and sum are rounded in integers. The sum of
+ * two floats is only zero when they cancel, so its sign is the exact one. */
+static int nms_sign(int a, int b, int px, int py, int pm)
+{
+    int e = -a*px + b*py, ex, ey, ea, eb;
+    unsigned int s;
+    uint64_t qx, qy;
+    int64_t ma, mb;
+
+    if(e > 512) return 1;
+    if(e < -512) return -1;
+    s = (unsigned int)abs(a*px) + (unsigned int)abs(b*py);
+    if(s == 0) return 0;
+    if((unsigned int)abs(e) > (s >> 22) + 1) return (e > 0) - (e < 0);
+
+    qx = float_quotient(abs(px), pm, &ex);
+    qy = float_quotient(abs(py), pm, &ey);
+    ma = float_product(a, -px, qx, ex, &ea);
+    mb = float_product(b, py, qy, ey, &eb);
+    if(ma == 0 || mb == 0) return (ma + mb > 0) - (ma + mb < 0);
+    /* Significands up to 2^24 shifted by up to 38 bits stay within 63 */
+    if(ea - eb > 38) return (ma > 0) - (ma < 0);
+    if(eb - ea > 38) return (mb > 0) - (mb < 0);
+    if(ea > eb) ma <<= ea - eb;
+    else mb <<= eb - ea;
+    return (ma + mb > 0) - (ma + mb < 0);
+}
+
+/* Suppresses the non-maximum points of row r, 1 <= r < rows-2, in integers as
+ * non_max_supp_pixels on the GPP does. The eight interpolation cases come down
+ * to one sector: along x when |gx| >= |gy| (strictly greater when both are
+ * negative), the first neighbour on the side -gx and the diagonal one towards
+ * -gx, -gy; the second pair is opposite. mag holds the whole frame, at least
+ * up to row r+1. */
+static void nms_row(short *mag, short *gxrow, short *gyrow, int r,
+                    unsigned char *nms, Nms_State *st)
+{
+    int c, m00, hx, vy, sx, sy, z1, z2, y1, y2, sign1, sign2;
+    int gx = st->gx, gy = st->gy, px = st->px, py = st->py, pm = st->pm;
+    short *magptr;
+
+    for(c=1; c<cols-2; c++)
+    {
+        magptr = mag + r*cols + c;
+        m00 = *magptr;
+        if(m00 != 0)
         {
-            sum = 0;
-            dot = 0;
-            for(rr=(-center); rr<=center; rr++)
-            {
-                if(((r+rr) >= 0) && ((r+rr) < rows))
-                {
-                    dot += MULTIPLICATION(tempim[(r+rr)*cols+c],kernel[center+rr]);
-                    sum += kernel[center+rr];
-                }
-            }
-            smoothedim[r*cols+c] = DIVISION(dot,sum);
-			
+            gx = px = gxrow[c];
+            gy = py = gyrow[c];
+            pm = m00;
+        }
+        else if(gx < 0) gy = gyrow[c];
+
+        sx = (gx >= 0) ? 1 : -1;
+        sy = (gy >= 0) ? 1 : -1;
+        hx = -sx;
+        vy = -sy * cols;
+        if((sx > 0 || sy > 0) ? abs(gx) >= abs(gy) : abs(gx) > abs(gy))
+        {
+            z1 = magptr[hx];
+            z2 = magptr[vy+hx];
+            y1 = magptr[-hx];
+            y2 = magptr[-vy-hx];
+            sign1 = nms_sign(sx*(m00 - z1), sy*(z2 - z1), px, py, pm);
+            sign2 = nms_sign(sx*(m00 - y1), sy*(y2 - y1), px, py, pm);
+        }
+        else
+        {
+            z1 = magptr[vy];
+            z2 = magptr[vy+hx];
+            y1 = magptr[-vy];
+            y2 = magptr[-vy-hx];
+            sign1 = nms_sign(sx*(z1 - z2), sy*(z1 - m00), px, py, pm);
+            sign2 = nms_sign(sx*(y1 - y2), sy*(y1 - m00), px, py, pm);
+        }
+        nms[r*cols+c] = (sign1 <= 0 && sign2 < 0) ? (unsigned char) POSSIBLE_EDGE
+                                                  : (unsigned char) NOEDGE;
+    }
+    st->gx = gx;
+    st->gy = gy;
+    st->px = px;
+    st->py = py;
+    st->pm = pm;
+}
+
+/* Computes the gradient magnitude and the non-maximal suppression map of the
+ * smoothed frame. Pixels the GPP version never examines, the border and the
+ * last row and column but one, are set to 0 like the border. */
+static Int edges_frame(uint16_t *smoothed, short *mag, unsigned char *nms)
+{
+    short *dx, *dy;
+    Nms_State st = {0, 0, 0, 0, 1};
+    int r, c, cur;
+
+    dx = MEM_alloc (DSPLINK_SEGID, 4*cols*sizeof(short), DSPLINK_BUF_ALIGN) ;
+    if (dx == MEM_ILLEGAL) {
+        return CMD_STATUS_ENOMEM;
+    }
+    dy = dx + 2*cols;
+
+    for(r=0; r<rows; r++)
+    {
+        /* Two rows of each derivative, row r and the row above it */
+        cur = (r & 1) * cols;
+        derivative_row(smoothed, r, dx+cur, dy+cur);
+        magnitude_row(dx+cur, dy+cur, mag+r*cols);
+
+        if(r-1 >= 1 && r-1 < rows-2)
+        {
+            cur = ((r-1) & 1) * cols;
+            nms[(r-1)*cols] = 0;
+            for(c=(cols-2 > 1) ? cols-2 : 1; c<cols; c++) nms[(r-1)*cols+c] = 0;
+            nms_row(mag, dx+cur, dy+cur, r-1, nms, &st);
+        }
+        else if(r-1 >= 0)
+        {
+            memset(nms+(r-1)*cols, 0, cols);
         }
     }
+    memset(nms+(rows-1)*cols, 0, cols);
+
+    MEM_free (DSPLINK_SEGID, dx, 4*cols*sizeof(short)) ;
+    return CMD_STATUS_OK;
 }
+
 Int Task_delete (Task_TransferInfo * info)
 {
     Int    status     = SYS_OK ;
@@ -198,6 +1211,14 @@ Int Task_delete (Task_TransferInfo * info)
                                 (FnNotifyCbck) Task_notify,
                                 info) ;
 
+    NOTIFY_unregister (ID_GPP,
+                       MPCSXFER_IPS_ID,
+                       MPCSXFER_RING_EVENTNO,
+                       (FnNotifyCbck) Task_ringNotify,
+                       info) ;
+
+    Task_freeTiles () ;
+
     /* Free the info structure */
     MEM_free (DSPLINK_SEGID,
               info,
@@ -209,26 +1230,23 @@ Int Task_delete (Task_TransferInfo * info)
 
 static Void Task_notify (Uint32 eventNo, Ptr arg, Ptr info)
 {
-    static int count = 0;
     Task_TransferInfo * mpcsInfo = (Task_TransferInfo *) arg ;
 
     (Void) eventNo ; /* To avoid compiler warning. */
 
-    count++;
-    if (count==1) {
-        buf =(unsigned char*)info ;
-    }
-   if (count==2) {
-        rows = (int)info;           
-    }
-     if (count==3) {
-        cols = (int)info;
-    }
-     if (count==4) {
-        windowSize = (int)info;
-    }
-     if (count==5){
-      // kernel
-    }
+    // Every notification carries the address of a command block
+    cmdQueue[cmdHead % CMD_QUEUE_SIZE] = (Cmd_Block *)info;
+    cmdHead++;
+    SEM_post(&(mpcsInfo->notifySemObj));
+}
+
+static Void Task_ringNotify (Uint32 eventNo, Ptr arg, Ptr info)
+{
+    Task_TransferInfo * mpcsInfo = (Task_TransferInfo *) arg ;
+
+    (Void) eventNo ;
+    (Void) info ;
+
+    // A doorbell only wakes the command loop, which looks at the rings
     SEM_post(&(mpcsInfo->notifySemObj));
 }
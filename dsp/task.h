@@ -13,8 +13,6 @@ typedef struct Task_TransferInfo_tag {
     Uint32          bufferSize ;
 } Task_TransferInfo ;
 
-void gaussian_smooth();
-
 Int Task_create (Task_TransferInfo ** transferInfo) ;
 
 Int Task_execute (Task_TransferInfo * transferInfo) ;
@@ -2,7 +2,4 @@
 
 /home/root/powercycle.sh
 chmod 777 *
-./pool_notify klomp.pgm
-./pool_notify tiger.pgm
-./pool_notify square.pgm
-
+./pool_notify klomp.pgm tiger.pgm square.pgm
@@ -0,0 +1,62 @@
+/*******************************************************************************
+* FILE: bench_util.c
+* What the benchmarks share: the clock, the percentiles of the samples and the
+* frame sizes and line format of their tables.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "bench_util.h"
+
+const int benchCols[BENCH_NUM_SIZES] = {128, 320, 640, 1280, 1920};
+const int benchRows[BENCH_NUM_SIZES] = { 96, 240, 480,  720, 1080};
+
+/* Monotonic time in microseconds */
+double bench_now_us(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000.0 + t.tv_nsec / 1000.0;
+}
+
+static int compare_times(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Sorts the n samples of t in increasing order */
+void bench_sort(double *t, int n)
+{
+    qsort(t, n, sizeof(double), compare_times);
+}
+
+/* Nearest rank percentile of the sorted samples t */
+double bench_percentile(double *t, int n, double p)
+{
+    int k = (int)ceil(p / 100.0 * n) - 1;
+
+    if(k < 0) k = 0;
+    return t[k];
+}
+
+/*******************************************************************************
+* PROCEDURE: bench_report
+* PURPOSE: Print a line of a frame table: the label, the frame size, the
+* percentiles of the sorted samples of t, in microseconds, and the megapixels
+* per second at the median. The line is left open for the columns a benchmark
+* adds of its own.
+*******************************************************************************/
+void bench_report(const char *label, int rows, int cols, double *t, int n)
+{
+    double p50 = bench_percentile(t, n, 50);
+
+    printf("%-9s %5dx%-5d %9.1f %9.1f %9.1f %9.1f", label, cols, rows,
+           t[0], p50, bench_percentile(t, n, 90), t[n-1]);
+    if(p50 > 0) printf(" %9.2f", rows * cols / p50);
+    else printf(" %9s", "-");
+}
@@ -0,0 +1,14 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+/* Frame sizes the benchmarks time, from QVGA - ish up to 1080p */
+#define BENCH_NUM_SIZES 5
+extern const int benchCols[BENCH_NUM_SIZES];
+extern const int benchRows[BENCH_NUM_SIZES];
+
+double bench_now_us(void);
+void bench_sort(double *t, int n);
+double bench_percentile(double *t, int n, double p);
+void bench_report(const char *label, int rows, int cols, double *t, int n);
+
+#endif
@@ -58,11 +58,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <unistd.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "markers.h"
 #include "Timer.h"
+#include "magnitude.h"
+#include "hysteresis.h"
+#include "smooth.h"
+#include "derivative.h"
 /* ----------------------Arm Neon Library for SIMD registers and instructions */
+#if defined (__ARM_NEON__)
 #include <arm_neon.h>
+#endif
 /* ----------------------Library to have certain bit integers for fixed point */
 #include <stdint.h>
 /*  ----------------------------------- DSP/BIOS Link                 */
@@ -82,43 +92,99 @@
 
 /*-----------------------------------------------------------------------------*/
 
+/* Longest time to wait for the DSP before giving up on it */
+#define DSP_TIMEOUT_MS 10000
 
+/* Smallest sigma smoothed with the recursive Gaussian, whose cost does not grow
+ * with sigma, instead of the kernel of 1 + 2*ceil(2.5*sigma) taps */
+#define IIR_SIGMA_MIN 3.0f
 
+/* Largest sigma accepted. The coefficients of the recursion lose precision as
+ * sigma grows; up to here the frame stays within a grey level of the exact
+ * recursion. */
+#define IIR_SIGMA_MAX 80.0f
 
+/* ---------------------------RUN TIME OPTIONS SET FROM THE COMMAND LINE */
+static int streamBands = 0; /* -b: stream the image to the DSP in row bands */
+static int splitRows = 0;   /* -s: smooth part of the rows on the GPP at the same time */
+static int dspEdges = 0;    /* -e: derivatives, magnitude and suppression on the DSP too */
+static int pipeline = 0;    /* -p: the DSP starts the next frame while the GPP finishes one */
+static int ringStream = 0;  /* -r: stream the frames through the shared-memory rings */
 
+/* ---------------------------SMOOTHING SPLIT BETWEEN THE DSP AND THE GPP (-s) */
+static float dspShare = 0.5f;          /* Fraction of the rows given to the DSP, adapted every frame */
+static int splitFrame;                 /* The frame being smoothed is split, not with the recursive Gaussian */
+static int splitDspRows;               /* DSP rows of the frame being smoothed */
+static unsigned char *splitImage;      /* Image of the frame being smoothed */
+#define SPLIT_SHARE_MIN 0.05f          /* Both sides keep some rows, so both can be timed */
+#define SPLIT_SHARE_MAX 0.95f
 
+/* ---------------------------A FRAME OF THE BATCH, TWO ARE IN FLIGHT WITH -p, RING_NUM_SLOTS WITH -r */
+typedef struct {
+    unsigned char *image;          /* NULL when it could not be read */
+    int rows, cols;
+    char *fname;                   /* Gradient direction file, NULL when not written */
+    char dirname[1024];
+    pool_notify_Request *request;  /* Its DSP part */
+} Frame;
+
+
+
+
+
+
+int add_images(char *path, char ***names, int *count);
+int read_frame(Frame *frame, char *infilename, int writeDir, float sigma,
+               float tlow, float thigh);
 int read_pgm_image(char *infilename, unsigned char **image, int *rows,
                    int *cols);
+int read_pgm_size(char *infilename, int *rows, int *cols);
+int read_pgm_image_into(char *infilename, unsigned char **image, int *rows,
+                        int *cols, unsigned char *(*alloc)(int rows, int cols),
+                        void (*release)(unsigned char *image));
 int write_pgm_image(char *outfilename, unsigned char *image, int rows,
                     int cols, char *comment, int maxval);
 
 void canny(unsigned char *image, int rows, int cols, float sigma,
            float tlow, float thigh, unsigned char **edge, char *fname);
+pool_notify_Request* canny_submit(unsigned char *image, int rows, int cols,
+                                  float sigma, char *fname);
+void canny_finish(pool_notify_Request *request, int rows, int cols,
+                  float tlow, float thigh, unsigned char **edge, char *fname);
+void canny_back(uint16_t *smoothedim, int rows, int cols, float tlow,
+                float thigh, unsigned char **edge, char *fname);
+int canny_ring(char **infilenames, int numImages, int writeDir, float sigma,
+               float tlow, float thigh);
 uint16_t* gaussian_smooth(unsigned char *image, int rows, int cols, float sigma);
-void make_gaussian_kernel(float sigma, uint16_t **kernel, int *windowsize);
-void derrivative_x_y(uint16_t *smoothedim, int rows, int cols,
-        short int **delta_x, short int **delta_y);
-void magnitude_x_y(short int *delta_x, short int *delta_y, int rows, int cols,
-                   short int *magnitude);
-void apply_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
-                      float tlow, float thigh, unsigned char *edge);
+pool_notify_Request* gaussian_smooth_submit(unsigned char *image, int rows, int cols, float sigma);
+uint16_t* gaussian_smooth_finish(pool_notify_Request *request, int rows, int cols);
+Uint32 gaussian_smooth_send(float sigma);
+pool_notify_Request* dsp_edges_submit(unsigned char *image, int rows, int cols, float sigma);
+void dsp_edges_finish(pool_notify_Request *request, short **magnitude,
+                      unsigned char **nms);
+void make_recursive_gaussian(float sigma, uint16_t **kernel, int *windowsize);
 void radian_direction(short int *delta_x, short int *delta_y, int rows,
                       int cols, float **dir_radians, int xdirtag, int ydirtag);
 double angle_radians(double x, double y);
 
+void gradient_nms(uint16_t *smoothedim, int rows, int cols, short *mag,
+                  unsigned char *result);
 void non_max_supp(short *mag, short *gradx, short *grady, int nrows,
                   int ncols, unsigned char *result);
  
 int main(int argc, char *argv[])
 {
 	char *dspExecutable = "pool_notify.out"; /* EXECUTABLE THAT WILL RUN ON DSP CO-PROCESSOR*/
-    char *infilename = NULL;  /* Name of the input image */
     char *dirfilename = NULL; /* Name of the output gradient direction image */
-    char outfilename[128];    /* Name of the output "edge" image */
-    char composedfname[128];  /* Name of the output "direction" image */
-    unsigned char *image;     /* The input image */
+    char outfilename[1024];   /* Name of the output "edge" image */
+    char **infilenames = NULL; /* Input images, in processing order */
+    int numImages = 0;        /* Number of input images */
+    int failures = 0;         /* Images that could not be processed */
+    Frame frames[DATA_NUM_BUFS]; /* The frame being finished and, with -p, the next ones */
+    Frame *frame;
     unsigned char *edge;      /* The output edge image */
     int rows, cols;           /* The dimensions of the image. */
+    int maxRows = 0, maxCols = 0; /* The largest dimensions of the images. */
     float sigma=2.5,              /* Standard deviation of the gaussian kernel. */
           tlow=0.5,               /* Fraction of the high threshold in hysteresis. */
           thigh=0.5;              /* High hysteresis threshold control. The actual
@@ -127,94 +193,251 @@ int main(int argc, char *argv[])
 			        gradient image that passes non-maximal
 			        suppression. */
     Timer totalTime;
+    Timer batchTime;
      
     
     char strBufferSize[128];
     
-    DSP_STATUS status    = DSP_SOK;
+    int opt, i, numRead = 0;
     
 
     /****************************************************************************
     * Get the command line arguments.
     ****************************************************************************/
-    if(argc < 2)
+    while((opt = getopt(argc, argv, "bseprg:m:y:t:")) != -1)
     {
-        fprintf(stderr,"\n<USAGE> %s image sigma tlow thigh [writedirim]\n",argv[0]);
+        switch(opt)
+        {
+            case 'g': sigma = atof(optarg); break;
+            case 'm': magnitudeMode = magnitude_mode(optarg); break;
+            case 'y': hysteresisMode = hysteresis_mode(optarg); break;
+            case 't': hysteresisThreads = atoi(optarg); break;
+            case 'b': streamBands = 1; break;
+            case 's': splitRows = 1; break;
+            case 'e': dspEdges = 1; break;
+            case 'p': pipeline = 1; break;
+            case 'r': ringStream = 1; break;
+            default: argc = 0; break;
+        }
+    }
+    if(argc - optind < 1 || sigma <= 0 || sigma > IIR_SIGMA_MAX || streamBands + splitRows + dspEdges > 1
+       || magnitudeMode < 0 || (dspEdges && magnitudeMode != MAG_EXACT)
+       || hysteresisMode < 0 || hysteresisThreads < 0
+       || (pipeline && (streamBands || splitRows))
+       || (ringStream && (streamBands + splitRows + dspEdges + pipeline > 0)))
+    {
+        fprintf(stderr,"\n<USAGE> %s [-g sigma] [-m mode] [-y mode [-t threads]] [-b | -s | -e] [-p] | [-r] image|directory ...\n",argv[0]);
         fprintf(stderr,"\n      image:      An image to process. Must be in ");
         fprintf(stderr,"PGM format.\n");
+        fprintf(stderr,"      directory:  Process every PGM image in the directory.\n");
+        fprintf(stderr,"      -g:         Standard deviation of the Gaussian (2.5), up to %.0f. From\n", IIR_SIGMA_MAX);
+        fprintf(stderr,"                  %.1f on it is applied recursively, in one piece with -b or -s.\n", IIR_SIGMA_MIN);
+        fprintf(stderr,"      -m:         Magnitude of the gradient: exact (the default), or the\n");
+        fprintf(stderr,"                  l1 or ambm approximation. Only exact with -e.\n");
+        fprintf(stderr,"      -y:         Hysteresis: follow the edges (the default), label the weak\n");
+        fprintf(stderr,"                  components in parallel bands, or grow the strong pixels\n");
+        fprintf(stderr,"                  through the weak ones on bitplanes (bits).\n");
+        fprintf(stderr,"      -t:         Threads of -y label, one per processor by default.\n");
+        fprintf(stderr,"      -b:         Stream the image to the DSP in row bands.\n");
+        fprintf(stderr,"      -s:         Split the smoothing between the DSP and the GPP.\n");
+        fprintf(stderr,"      -e:         Compute the gradient and its suppression on the DSP.\n");
+        fprintf(stderr,"      -p:         Smooth the next image on the DSP while the GPP finishes one.\n");
+        fprintf(stderr,"                  Not with -b or -s.\n");
+        fprintf(stderr,"      -r:         Stream the images through shared-memory rings, %d in\n", RING_NUM_SLOTS);
+        fprintf(stderr,"                  flight. Not with the other options.\n");
+        fprintf(stderr,"\n      All images are processed in one DSP session.\n");
+        exit(1);
+    }
+    for(i = optind; i < argc; i++)
+    {
+        if(add_images(argv[i], &infilenames, &numImages) == 0)
+        {
+            fprintf(stderr, "Error reading the input %s.\n", argv[i]);
+            exit(1);
+        }
+    }
+    if(numImages == 0)
+    {
+        fprintf(stderr, "No PGM images to process.\n");
         exit(1);
     }
 
-    infilename = argv[1]; // GIVEN PICTURE FROM SHELL
-	printf("=====%s====",infilename);
-	//----------------------------------DSP BUFFER SIZE SET------------------------------
-	sprintf(strBufferSize, "%d", MEM_SIZE);
     initTimer(&totalTime, "Total Time");
-	
-	
+    initTimer(&batchTime, "Batch Time");
+
     /****************************************************************************
-    * Read in the image. This read function allocates memory for the image.
+    * Size the shared buffers for the largest image of the session.
     ****************************************************************************/
-    if(VERBOSE) printf("Reading the image %s.\n", infilename);
-    if(read_pgm_image(infilename, &image, &rows, &cols) == 0)
+    for(i = 0; i < numImages; i++)
     {
-        fprintf(stderr, "Error reading the input image, %s.\n", infilename);
-        exit(1);
+        if(read_pgm_size(infilenames[i], &rows, &cols) == 0) continue;
+        if(rows > maxRows) maxRows = rows;
+        if(cols > maxCols) maxCols = cols;
     }
-    
+
+	//----------------------------------DSP BUFFER SIZE SET------------------------------
+    if(dspEdges && pool_notify_edgeFrameSize(maxRows, maxCols) > MEM_SIZE)
+        sprintf(strBufferSize, "%u", (unsigned) pool_notify_edgeFrameSize(maxRows, maxCols));
+    else
+        sprintf(strBufferSize, "%d", MEM_SIZE);
 
     //--------------------------Call pool_notify main which will create the poll notify with the given Buffer size
+    //--------------------------The DSP is loaded once and serves every image
 
-    pool_notify_Main(dspExecutable, strBufferSize, rows, cols);
-	    
+    if(ringStream) pool_notify_ringSlots(RING_NUM_SLOTS);
+    pool_notify_Main(dspExecutable, strBufferSize, maxRows, maxCols);
 
-    /****************************************************************************
-    * Perform the edge detection. All of the work takes place here.
-    ****************************************************************************/
-    if(VERBOSE) printf("Starting Canny edge detection.\n");
-    if(dirfilename != NULL)
+    startTimer(&batchTime);
+    if(ringStream) failures = canny_ring(infilenames, numImages, dirfilename != NULL, sigma, tlow, thigh);
+    for(i = 0; i < numImages && !ringStream; i++)
     {
-        sprintf(composedfname, "%s_s_%3.2f_l_%3.2f_h_%3.2f.fim", infilename,sigma, tlow, thigh);
-        dirfilename = composedfname;
-    }
+        frame = &frames[i % DATA_NUM_BUFS];
+        printf("=====%s====",infilenames[i]);
+
+        /****************************************************************************
+        * Read in the image. It is decoded straight into a buffer shared with
+        * the DSP whenever one is free. With -p it was read, and its DSP part
+        * started, while the previous images were being finished.
+        ****************************************************************************/
+        if(!pipeline)
+            read_frame(frame, infilenames[i], dirfilename != NULL, sigma, tlow, thigh);
+
+        /****************************************************************************
+        * Perform the edge detection. All of the work takes place here.
+        ****************************************************************************/
+        if(VERBOSE) printf("Starting Canny edge detection.\n");
+        startTimer(&totalTime); // Start timer to measure the execution time   
+        if(frame->image != NULL && !pipeline)
+            frame->request = canny_submit(frame->image, frame->rows, frame->cols, sigma, frame->fname);
+        /* The DSP has the next images queued, one per data buffer, and goes on
+           to them as soon as it is done with this one */
+        for(; pipeline && numRead < numImages && numRead < i + DATA_NUM_BUFS; numRead++)
+        {
+            Frame *next = &frames[numRead % DATA_NUM_BUFS];
 
-    startTimer(&totalTime); // Start timer to measure the execution time   
-    canny(image, rows, cols, sigma, tlow, thigh, &edge, dirfilename); // Main function of image processing   
-	stopTimer(&totalTime); // Stop timer 
-    printTimer(&totalTime);
+            if(read_frame(next, infilenames[numRead], dirfilename != NULL, sigma, tlow, thigh))
+                next->request = canny_submit(next->image, next->rows, next->cols, sigma, next->fname);
+        }
+        if(frame->image == NULL)
+        {
+            failures++;
+            continue;
+        }
+        canny_finish(frame->request, frame->rows, frame->cols, tlow, thigh, &edge, frame->fname); // Main function of image processing   
+        stopTimer(&totalTime); // Stop timer 
+        printTimer(&totalTime);
+
+        /****************************************************************************
+        * Write out the edge image to a file.
+        ****************************************************************************/
+        snprintf(outfilename, sizeof(outfilename), "%s_s_%3.2f_l_%3.2f_h_%3.2f.pgm", infilenames[i],
+                sigma, tlow, thigh);
+        if(VERBOSE) printf("Writing the edge iname in the file %s.\n", outfilename);
+        if(write_pgm_image(outfilename, edge, frame->rows, frame->cols, "", 255) == 0)
+        {
+            fprintf(stderr, "Error writing the edge image, %s.\n", outfilename);
+            failures++;
+        }
+
+        pool_notify_freeImage(frame->image);
+        free(edge);
+    }
+    stopTimer(&batchTime);
+    if(numImages > 1) printTimer(&batchTime);
     
     
     /****************************************************************************
     * Final part of the pool example to delete it
     ****************************************************************************/
-    if ((dspExecutable != NULL) && (strBufferSize != NULL)) { 
-        pool_notify_Delete (0) ;
-        
+    pool_notify_Delete (0) ;
+
+    for(i = 0; i < numImages; i++) free(infilenames[i]);
+    free(infilenames);
+    return (failures == 0) ? 0 : 1;
+}
+
+/*******************************************************************************
+* PROCEDURE: read_frame
+* PURPOSE: Reads in an image for the edge detection, into a frame slot of the
+* ring with -r, and names its gradient direction file. Returns 0, leaving frame->image NULL, when it cannot be read.
+*******************************************************************************/
+int read_frame(Frame *frame, char *infilename, int writeDir, float sigma,
+               float tlow, float thigh)
+{
+    if(VERBOSE) printf("Reading the image %s.\n", infilename);
+    if(read_pgm_image_into(infilename, &frame->image, &frame->rows, &frame->cols,
+                           ringStream ? pool_notify_ring_allocImage : pool_notify_allocImage,
+                           ringStream ? pool_notify_ring_freeImage : pool_notify_freeImage) == 0)
+    {
+        fprintf(stderr, "Error reading the input image, %s.\n", infilename);
+        frame->image = NULL;
+        return 0;
     }
-    else 
-	{
-        status = DSP_EINVALIDARG ;
-        printf ("ERROR! Invalid arguments specified for  "
-                         "pool_notify application\n") ;
+    /* The DSP requests submitted from now on are for this size */
+    pool_notify_dimensions(frame->rows, frame->cols);
+
+    frame->fname = NULL;
+    if(writeDir)
+    {
+        snprintf(frame->dirname, sizeof(frame->dirname), "%s_s_%3.2f_l_%3.2f_h_%3.2f.fim",
+                 infilename, sigma, tlow, thigh);
+        frame->fname = frame->dirname;
     }
-   
+    return 1;
+}
 
+/*******************************************************************************
+* PROCEDURE: is_input_image
+* PURPOSE: Selects the PGM images of a directory, leaving out the edge images
+* written next to them by earlier runs.
+*******************************************************************************/
+static int is_input_image(const struct dirent *entry)
+{
+    size_t len = strlen(entry->d_name);
 
-    /****************************************************************************
-    * Write out the edge image to a file.
-    ****************************************************************************/
-    sprintf(outfilename, "%s_s_%3.2f_l_%3.2f_h_%3.2f.pgm", infilename,
-            sigma, tlow, thigh);
-    if(VERBOSE) printf("Writing the edge iname in the file %s.\n", outfilename);
-    if(write_pgm_image(outfilename, edge, rows, cols, "", 255) == 0)
+    if(len < 4 || strcmp(entry->d_name + len - 4, ".pgm") != 0) return 0;
+    return strstr(entry->d_name, ".pgm_s_") == NULL;
+}
+
+/*******************************************************************************
+* PROCEDURE: add_images
+* PURPOSE: Appends path to the list of images to process. A directory adds its
+* PGM images in name order. Returns 0 when path cannot be read.
+*******************************************************************************/
+int add_images(char *path, char ***names, int *count)
+{
+    struct stat st;
+    struct dirent **entries;
+    char **grown;
+    int n, i, added;
+
+    if(stat(path, &st) != 0) return 0;
+    if(!S_ISDIR(st.st_mode))
     {
-        fprintf(stderr, "Error writing the edge image, %s.\n", outfilename);
-        exit(1);
+        if((grown = (char **) realloc(*names, (*count+1)*sizeof(char *))) == NULL) return 0;
+        *names = grown;
+        if(((*names)[*count] = strdup(path)) == NULL) return 0;
+        (*count)++;
+        return 1;
     }
 
-    free(image);
-    free(edge);
-    return 0;
+    if((n = scandir(path, &entries, is_input_image, alphasort)) < 0) return 0;
+    added = 0;
+    if((grown = (char **) realloc(*names, (*count+n+1)*sizeof(char *))) != NULL)
+    {
+        *names = grown;
+        for(i = 0; i < n; i++)
+        {
+            (*names)[*count] = (char *) malloc(strlen(path) + strlen(entries[i]->d_name) + 2);
+            if((*names)[*count] == NULL) break;
+            sprintf((*names)[*count], "%s/%s", path, entries[i]->d_name);
+            (*count)++;
+            added++;
+        }
+    }
+    for(i = 0; i < n; i++) free(entries[i]);
+    free(entries);
+    return added == n;
 }
 
 /*******************************************************************************
@@ -226,46 +449,127 @@ int main(int argc, char *argv[])
 void canny(unsigned char *image, int rows, int cols, float sigma,
            float tlow, float thigh, unsigned char **edge, char *fname)
 {
-    FILE *fpdir=NULL;          /* File to write the gradient image to.     */
-    unsigned char *nms;        /* Points that are local maximal magnitude. */
-    uint16_t *smoothedim;     /* The image after gaussian smoothing.      */
-    short int *delta_x,        /* The first devivative image, x-direction. */
-          *delta_y,        /* The first derivative image, y-direction. */
-          *magnitude;      /* The magnitude of the gadient image.      */
-    float *dir_radians=NULL;   /* Gradient direction image.                */
-	
-	
+    canny_finish(canny_submit(image, rows, cols, sigma, fname), rows, cols,
+                 tlow, thigh, edge, fname);
+}
+
+/*******************************************************************************
+* PROCEDURE: canny_submit
+* PURPOSE: Start the edge detection of an image on the DSP. The image must stay
+* valid until canny_finish returns.
+*******************************************************************************/
+pool_notify_Request* canny_submit(unsigned char *image, int rows, int cols,
+                                  float sigma, char *fname)
+{
+    /****************************************************************************
+    * With -e the DSP runs every step up to the non-maximal suppression and
+    * only the magnitude and the suppression map come back. The direction
+    * image needs the derivatives, so it is computed here, and so are frames
+    * of a single row or column, which the DSP row sweep does not take.
+    ****************************************************************************/
+    if(dspEdges && fname == NULL && rows >= 2 && cols >= 2)
+        return dsp_edges_submit(image, rows, cols, sigma);
+
     /****************************************************************************
     * Perform gaussian smoothing on the image using the input standard
     * deviation.
     ****************************************************************************/
     if(VERBOSE) printf("Smoothing the image using a gaussian kernel.\n");
 	//Gaussian_smooth is the function that spends 75% of the execution time of canny
-	pool_notify_dimensions();
-    smoothedim = gaussian_smooth(image, rows, cols, sigma);
+    return gaussian_smooth_submit(image, rows, cols, sigma);
+}
 
-    /****************************************************************************
-    * Compute the first derivative in the x and y directions.
-    ****************************************************************************/
-    if(VERBOSE) printf("Computing the X and Y first derivatives.\n");
-    derrivative_x_y(smoothedim, rows, cols, &delta_x, &delta_y);
+/*******************************************************************************
+* PROCEDURE: canny_finish
+* PURPOSE: Wait for the DSP part of the edge detection started by canny_submit
+* and perform the rest of it.
+*******************************************************************************/
+void canny_finish(pool_notify_Request *request, int rows, int cols,
+                  float tlow, float thigh, unsigned char **edge, char *fname)
+{
+    unsigned char *nms;        /* Points that are local maximal magnitude. */
+    uint16_t *smoothedim;     /* The image after gaussian smoothing.      */
+    short int *magnitude;      /* The magnitude of the gadient image.      */
+
+    if(request->edges)
+    {
+        if( (*edge=(unsigned char *)malloc(rows*cols*sizeof(unsigned char))) == NULL )
+        {
+            fprintf(stderr, "Error allocating the edge image.\n");
+            exit(1);
+        }
+        dsp_edges_finish(request, &magnitude, &nms);
+        if(VERBOSE) printf("Doing hysteresis thresholding.\n");
+        apply_hysteresis(magnitude, nms, rows, cols, tlow, thigh, *edge);
+        pool_notify_release_edges(magnitude, nms);
+        return;
+    }
+
+    smoothedim = gaussian_smooth_finish(request, rows, cols);
+    canny_back(smoothedim, rows, cols, tlow, thigh, edge, fname);
+    pool_notify_release(smoothedim);
+}
+
+/*******************************************************************************
+* PROCEDURE: canny_back
+* PURPOSE: Perform the edge detection steps after the smoothing on the GPP.
+* smoothedim is left to the caller.
+*******************************************************************************/
+void canny_back(uint16_t *smoothedim, int rows, int cols, float tlow,
+                float thigh, unsigned char **edge, char *fname)
+{
+    FILE *fpdir=NULL;          /* File to write the gradient image to.     */
+    unsigned char *nms;        /* Points that are local maximal magnitude. */
+    short int *delta_x,        /* The first devivative image, x-direction. */
+          *delta_y,        /* The first derivative image, y-direction. */
+          *magnitude;      /* The magnitude of the gadient image.      */
+    float *dir_radians=NULL;   /* Gradient direction image.                */
+
+    if((magnitude = (short *) malloc(rows*cols* sizeof(short))) == NULL)
+    {
+        fprintf(stderr, "Error allocating the magnitude image.\n");
+        exit(1);
+    }
+    if((nms = (unsigned char *) malloc(rows*cols*sizeof(unsigned char)))==NULL)
+    {
+        fprintf(stderr, "Error allocating the nms image.\n");
+        exit(1);
+    }
+    if( (*edge=(unsigned char *)malloc(rows*cols*sizeof(unsigned char))) == NULL )
+    {
+        fprintf(stderr, "Error allocating the edge image.\n");
+        exit(1);
+    }
 
     /****************************************************************************
-    * This option to write out the direction of the edge gradient was added
-    * to make the information available for computing an edge quality figure
-    * of merit.
+    * Without the gradient direction file the derivatives are never needed as
+    * whole images: one sweep down the rows gives the magnitude and the
+    * non-maximal suppression.
     ****************************************************************************/
-    if(fname != NULL)
+    if(fname == NULL)
     {
-        /*************************************************************************
-        * Compute the direction up the gradient, in radians that are
-        * specified counteclockwise from the positive x-axis.
-        *************************************************************************/
+        if(VERBOSE) printf("Computing the gradient and the non-maximal suppression.\n");
+        gradient_nms(smoothedim, rows, cols, magnitude, nms);
+    }
+    else
+    {
+        /************************************************************************
+        * Compute the first derivative in the x and y directions.
+        ************************************************************************/
+        if(VERBOSE) printf("Computing the X and Y first derivatives.\n");
+        derrivative_x_y(smoothedim, rows, cols, &delta_x, &delta_y);
+
+        /************************************************************************
+        * This option to write out the direction of the edge gradient was
+        * added to make the information available for computing an edge
+        * quality figure of merit. Compute the direction up the gradient, in
+        * radians that are specified counteclockwise from the positive x-axis.
+        ************************************************************************/
         radian_direction(delta_x, delta_y, rows, cols, &dir_radians, -1, -1);
 
-        /*************************************************************************
+        /************************************************************************
         * Write the gradient direction image out to a file.
-        *************************************************************************/
+        ************************************************************************/
         if((fpdir = fopen(fname, "wb")) == NULL)
         {
             fprintf(stderr, "Error opening the file %s for writing.\n", fname);
@@ -274,56 +578,119 @@ void canny(unsigned char *image, int rows, int cols, float sigma,
         fwrite(dir_radians, sizeof(float), rows*cols, fpdir);
         fclose(fpdir);
         free(dir_radians);
-    }
 
-    /****************************************************************************
-    * Compute the magnitude of the gradient.
-    ****************************************************************************/
-    /****************************************************************************
-    * Allocate an image to store the magnitude of the gradient.
-    ****************************************************************************/
-    if((magnitude = (short *) malloc(rows*cols* sizeof(short))) == NULL)
-    {
-        fprintf(stderr, "Error allocating the magnitude image.\n");
-        exit(1);
-    }
+        /************************************************************************
+        * Compute the magnitude of the gradient.
+        ************************************************************************/
+        if(VERBOSE) printf("Computing the magnitude of the gradient.\n");
+        magnitude_x_y(delta_x, delta_y, rows, cols, magnitude);
 
-    if(VERBOSE) printf("Computing the magnitude of the gradient.\n");
-    magnitude_x_y(delta_x, delta_y, rows, cols, magnitude);
+        /************************************************************************
+        * Perform non-maximal suppression.
+        ************************************************************************/
+        if(VERBOSE) printf("Doing the non-maximal suppression.\n");
+        non_max_supp(magnitude, delta_x, delta_y, rows, cols, nms);
 
-    /****************************************************************************
-    * Perform non-maximal suppression.
-    ****************************************************************************/
-    if(VERBOSE) printf("Doing the non-maximal suppression.\n");
-    if((nms = (unsigned char *) malloc(rows*cols*sizeof(unsigned char)))==NULL)
-    {
-        fprintf(stderr, "Error allocating the nms image.\n");
-        exit(1);
+        free(delta_x);
+        free(delta_y);
     }
-    non_max_supp(magnitude, delta_x, delta_y, rows, cols, nms);
 
     /****************************************************************************
     * Use hysteresis to mark the edge pixels.
     ****************************************************************************/
     if(VERBOSE) printf("Doing hysteresis thresholding.\n");
-    if( (*edge=(unsigned char *)malloc(rows*cols*sizeof(unsigned char))) == NULL )
-    {
-        fprintf(stderr, "Error allocating the edge image.\n");
-        exit(1);
-    }
     apply_hysteresis(magnitude, nms, rows, cols, tlow, thigh, *edge);
 
     /****************************************************************************
     * Free all of the memory that we allocated except for the edge image that
     * is still being used to store out result.
     ****************************************************************************/
-    free(smoothedim);
-    free(delta_x);
-    free(delta_y);
     free(magnitude);
     free(nms);
 }
 
+/*******************************************************************************
+* PROCEDURE: canny_ring
+* PURPOSE: Perform the edge detection of the batch with the images streamed
+* through the shared-memory rings: the DSP smooths up to RING_NUM_SLOTS images
+* back to back while the GPP reads the next ones and finishes the oldest. The
+* rings wait for each other, so no image waits on a command round trip.
+* Returns the number of images that could not be processed.
+*******************************************************************************/
+int canny_ring(char **infilenames, int numImages, int writeDir, float sigma,
+               float tlow, float thigh)
+{
+    Frame frames[RING_NUM_SLOTS]; /* In flight, the oldest at done % RING_NUM_SLOTS */
+    Frame *frame;
+    uint16_t *smoothedim;
+    unsigned char *edge;
+    char outfilename[1024];
+    int sent = 0, done = 0, failures = 0, rows, cols;
+    Timer totalTime;
+
+    initTimer(&totalTime, "Total Time");
+    while(done < numImages)
+    {
+        /* Keep the DSP supplied. No more images than result slots are in
+           flight, so it never blocks on a result the GPP is not taking. */
+        while(sent < numImages && sent - done < RING_NUM_SLOTS)
+        {
+            frame = &frames[sent % RING_NUM_SLOTS];
+            if(read_frame(frame, infilenames[sent], writeDir, sigma, tlow, thigh)
+               && gaussian_smooth_send(sigma) == 0)
+            {
+                fprintf(stderr, "Error sending the image to the DSP.\n");
+                pool_notify_ring_freeImage(frame->image);
+                frame->image = NULL;
+            }
+            sent++;
+        }
+
+        frame = &frames[done % RING_NUM_SLOTS];
+        printf("=====%s====",infilenames[done]);
+        done++;
+        if(frame->image == NULL)
+        {
+            failures++;
+            continue;
+        }
+        startTimer(&totalTime);
+
+        /* A result that comes in late could not be told from the one of the
+           next image, so the batch stops at the first timeout: this image and
+           the ones after it are not processed. A frame the DSP failed is
+           still taken off the ring in order. */
+        if(!pool_notify_ring_wait(DSP_TIMEOUT_MS))
+        {
+            fprintf(stderr, "The DSP did not smooth the image within %d ms, stopping the batch.\n",
+                    DSP_TIMEOUT_MS);
+            failures += numImages - done + 1;
+            break;
+        }
+        if((smoothedim = pool_notify_ring_receive(&rows, &cols, 0)) == NULL)
+        {
+            fprintf(stderr, "The DSP did not smooth the image.\n");
+            failures++;
+            continue;
+        }
+        canny_back(smoothedim, rows, cols, tlow, thigh, &edge, frame->fname);
+        pool_notify_ring_release();
+        stopTimer(&totalTime);
+        printTimer(&totalTime);
+
+        snprintf(outfilename, sizeof(outfilename), "%s_s_%3.2f_l_%3.2f_h_%3.2f.pgm", infilenames[done-1],
+                sigma, tlow, thigh);
+        if(VERBOSE) printf("Writing the edge iname in the file %s.\n", outfilename);
+        if(write_pgm_image(outfilename, edge, rows, cols, "", 255) == 0)
+        {
+            fprintf(stderr, "Error writing the edge image, %s.\n", outfilename);
+            failures++;
+        }
+        free(edge);
+    }
+    return failures;
+}
+
 /*******************************************************************************
 * Procedure: radian_direction
 * Purpose: To compute a direction of the gradient image from component dx and
@@ -401,185 +768,233 @@ double angle_radians(double x, double y)
 }
 
 /*******************************************************************************
-* PROCEDURE: magnitude_x_y
-* PURPOSE: Compute the magnitude of the gradient. This is the square root of
-* the sum of the squared derivative values.
+* PROCEDURE: gaussian_smooth
+* PURPOSE: Blur an image with a gaussian filter.
 * NAME: Mike Heath
 * DATE: 2/15/96
 *******************************************************************************/
-void magnitude_x_y(short int *delta_x, short int *delta_y, int rows, int cols,
-                   short int *magnitude)
+uint16_t* gaussian_smooth(unsigned char *image, int rows, int cols, float sigma)
 {
-    int r, c, pos, sq1, sq2;
-	
-    for(r=0,pos=0; r<rows; r++)
+    return gaussian_smooth_finish(gaussian_smooth_submit(image, rows, cols, sigma), rows, cols);
+}
+
+/*******************************************************************************
+* PROCEDURE: gaussian_smooth_submit
+* PURPOSE: Start blurring an image with a gaussian filter on the DSP. The image
+* must stay valid until gaussian_smooth_finish returns.
+*******************************************************************************/
+static int windowsize;        /* Dimension of the gaussian kernel. */
+//------------------------Unsigned integers of 16 bit in order to perform fixed pointed calculations to gain speed up    
+static uint16_t *kernel = NULL; /* Kept for the next frames with the same sigma */
+static float kernelSigma;
+
+/* Creates the 1-dimensional gaussian smoothing kernel unless the last frame had
+ * the same sigma. Large sigmas get the recursive Gaussian instead. */
+static void gaussian_kernel_for(float sigma)
+{
+    int i;
+
+    if(kernel == NULL || sigma != kernelSigma)
     {
-        for(c=0; c<cols; c++,pos++)
+        if(VERBOSE) printf("   Computing the gaussian smoothing kernel.\n");   
+        free(kernel);
+        if(sigma >= IIR_SIGMA_MIN) make_recursive_gaussian(sigma, &kernel, &windowsize);
+        else make_gaussian_kernel(sigma, &kernel, &windowsize);
+        kernelSigma = sigma;
+        if(VERBOSE && windowsize != CMD_KERNEL_IIR)
         {
-            sq1 = (int)delta_x[pos] * (int)delta_x[pos];
-            sq2 = (int)delta_y[pos] * (int)delta_y[pos];
-            magnitude[pos] = (short)(0.5 + sqrt((float)sq1 + (float)sq2));
+            printf("The filter coefficients are:\n");
+            for(i=0; i<windowsize; i++)
+                printf("kernel[%d] = %f\n", i, FIXED_FLOAT(kernel[i]));
         }
     }
 }
 
+pool_notify_Request* gaussian_smooth_submit(unsigned char *image, int rows, int cols, float sigma)
+{
+    pool_notify_Request *request;
+    int align;
+
+    gaussian_kernel_for(sigma);
+    /* The recursive Gaussian runs down whole columns, so it cannot be cut into
+     * bands or rows and smooths the frame in one piece */
+    splitFrame = splitRows && windowsize != CMD_KERNEL_IIR;
+	
+    if(streamBands && windowsize != CMD_KERNEL_IIR)
+        request = pool_notify_submit_stream(image, kernel, windowsize, 0); // Stream image to DSP band by band
+    else if(splitFrame)
+    {
+        /* The DSP takes the top rows, the GPP smooths the rest in gaussian_smooth_finish */
+        align = pool_notify_rowAlign(cols);
+        splitDspRows = ((int)(dspShare * rows + 0.5f) / align) * align;
+        splitImage = image;
+        request = pool_notify_submit_rows(image, kernel, windowsize, splitDspRows, 0);
+    }
+    else
+        request = pool_notify_submit(image, kernel, windowsize, 0); // Queue image and kernel for the DSP
+    if(request == NULL)
+    {
+        fprintf(stderr, "Error submitting the image to the DSP.\n");
+        exit(1);
+    }
+       
+    return request;
+}
 
 /*******************************************************************************
-* PROCEDURE: derrivative_x_y
-* PURPOSE: Compute the first derivative of the image in both the x any y
-* directions. The differential filters that are used are:
-*
-*                                          -1
-*         dx =  -1 0 +1     and       dy =  0
-*                                          +1
-*
-* NAME: Mike Heath
-* DATE: 2/15/96
+* PROCEDURE: gaussian_smooth_send
+* PURPOSE: Hand the image read into the frame ring to the DSP to be blurred.
+* Returns its sequence number, 0 when it could not be sent.
 *******************************************************************************/
-void derrivative_x_y(uint16_t *smoothedim, int rows, int cols,
-        short int **delta_x, short int **delta_y)
+Uint32 gaussian_smooth_send(float sigma)
 {
-   int r, c, pos;
-   /****************************************************************************
-   * Allocate images to store the derivatives.
-   ****************************************************************************/
-   if(((*delta_x) = (short *) malloc(rows*cols* sizeof(short))) == NULL){
-      fprintf(stderr, "Error allocating the delta_x image.\n");
-      exit(1);
-   }
-   if(((*delta_y) = (short *) malloc(rows*cols* sizeof(short))) == NULL){
-      fprintf(stderr, "Error allocating the delta_x image.\n");
-      exit(1);
-   }
-
-	
-   for(r=0;r<rows;r++){
-      pos = r * cols;
-      (*delta_x)[pos] = (short)smoothedim[pos+1] - (short)smoothedim[pos];
-      pos++;
-      for(c=1;c<(cols-1);c++,pos++){
-         (*delta_x)[pos] = (short)smoothedim[pos+1] - (short)smoothedim[pos-1];
-      }
-      (*delta_x)[pos] = (short)smoothedim[pos] - (short)smoothedim[pos-1];
-   }
-	
-   for(c=0;c<cols;c++){
-      pos = c;
-      (*delta_y)[pos] = (short)smoothedim[pos+cols] - (short)smoothedim[pos];
-      pos += cols;
-      for(r=1;r<(rows-1);r++,pos+=cols){
-         (*delta_y)[pos] = (short)smoothedim[pos+cols] - (short)smoothedim[pos-cols];
-      }
-      (*delta_y)[pos] = (short)smoothedim[pos] - (short)smoothedim[pos-cols];
-   }
+    gaussian_kernel_for(sigma);
+    return pool_notify_ring_send(kernel, windowsize);
 }
 
 /*******************************************************************************
-* PROCEDURE: gaussian_smooth
-* PURPOSE: Blur an image with a gaussian filter.
-* NAME: Mike Heath
-* DATE: 2/15/96
+* PROCEDURE: gaussian_smooth_finish
+* PURPOSE: Wait for the DSP to blur the image. It comes back scaled by 90 and
+* rounded, ready for the derivatives.
+* With -s the GPP blurs its share of the rows first, while the DSP blurs the
+* others, and the share is adapted so both sides take equally long on the next
+* frame. The result is given back with pool_notify_release.
 *******************************************************************************/
-uint16_t* gaussian_smooth(unsigned char *image, int rows, int cols, float sigma)
+uint16_t* gaussian_smooth_finish(pool_notify_Request *request, int rows, int cols)
 {
-    int windowsize;        /* Dimension of the gaussian kernel. */
-    //------------------------Unsigned integers of 16 bit in order to perform fixed pointed calculations to gain speed up    
-    uint16_t *kernel; 
-	
     uint16_t * smoothedim;
-    uint16_t * smoothedimTemp;
-	//--------------------------------------Variables for SIMD operations--------------------------------------------------------
-    float32_t smoothedimSIMD[4];
-    float32x4_t boostflurfactor;
-	float32x4_t factorhalf; 
-    float32x4_t tempF32;
-    uint32x4_t tempU32;
-    uint16x4_t tempU16; 
-	//---------------------------------------------------------------------------------------------------------------------------
-    short int i,j;    
-
-    /****************************************************************************
-    * Create a 1-dimensional gaussian smoothing kernel.
-    ****************************************************************************/
-    if(VERBOSE) printf("   Computing the gaussian smoothing kernel.\n");   
-	make_gaussian_kernel(sigma, &kernel, &windowsize);
-	
-    pool_notify_image(image,windowsize, 0); // Send image to DSP side with pool notify
-    
-    pool_notify_kernel(kernel,windowsize, 0);// Send Kernel to DSP side with pool notify
-       
-    free(kernel);
-
-    
-    smoothedim = (uint16_t*) malloc(cols*rows*sizeof(uint16_t));// Allocate memory for the processed image from DSP
-	smoothedimTemp = pool_notify_getImage(0); //Get processed image from DSP
-    boostflurfactor = vdupq_n_f32(90.0f);
-    factorhalf = vdupq_n_f32(0.5f);
-	
-    for(i = 0; i < cols*rows/4; i++){
-	
-        for(j = 0; j < 4; j++){
-            smoothedimSIMD[j] = FIXED_FLOAT(*smoothedimTemp++);
-        } 
-        tempF32 = vld1q_f32(smoothedimSIMD); // put the first 4 values
-        tempF32 = vmulq_f32(tempF32, boostflurfactor);//multiply them with boostflurfactor
-        tempF32 = vaddq_f32(tempF32, factorhalf);//add them with halfactor
-		
-        tempU32 = vcvtq_u32_f32(tempF32);//convert from float32x4_t to unsigned integers 32bit
-        tempU16 = vqmovn_u32(tempU32);//convert from uint32x4_t to 16bit
-		
-        vst1_u16(smoothedim, tempU16);// store the values to the final array
-	
-        smoothedim+=4;//move the pointer to the next 4 slots
+    Timer gppTime;
+    float dspRate, gppRate;
 
+    if(splitFrame)
+    {
+        startTimer(&gppTime);
+        if(!gaussian_smooth_gpp(splitImage, rows, cols, kernel, windowsize,
+                                pool_notify_output(request) + splitDspRows*cols,
+                                splitDspRows, rows-splitDspRows))
+        {
+            exit(1);
+        }
+        stopTimer(&gppTime);
+    }
+    if(!pool_notify_wait(request, DSP_TIMEOUT_MS))
+    {
+        fprintf(stderr, "The DSP did not finish smoothing within %d ms.\n", DSP_TIMEOUT_MS);
+        exit(1);
+    }
+    if(splitFrame)
+    {
+        printf("Split: DSP %d rows in %g msec, GPP %d rows in %g msec\n", splitDspRows,
+               request->dspTime, rows-splitDspRows, gppTime.elapsedTime);
+        /* Move halfway to the share at which both rates finish together */
+        if(splitDspRows > 0 && splitDspRows < rows && request->dspTime > 0 && gppTime.elapsedTime > 0)
+        {
+            dspRate = splitDspRows / request->dspTime;
+            gppRate = (rows-splitDspRows) / gppTime.elapsedTime;
+            dspShare = 0.5f * (dspShare + dspRate / (dspRate + gppRate));
+        }
+        else if(splitDspRows == 0) dspShare += SPLIT_SHARE_MIN;
+        else dspShare -= SPLIT_SHARE_MIN;
+        if(dspShare < SPLIT_SHARE_MIN) dspShare = SPLIT_SHARE_MIN;
+        if(dspShare > SPLIT_SHARE_MAX) dspShare = SPLIT_SHARE_MAX;
+    }
+    smoothedim = pool_notify_collect(request); //Get processed image from DSP
+    if(smoothedim == NULL)
+    {
+        fprintf(stderr, "The DSP failed to smooth the image.\n");
+        exit(1);
     }
-    smoothedim = smoothedim - cols*rows;// put pointer to the first position of the array
- 
- /* conventional way of calculation without SIMD 
-	for(i = 0; i < cols; i++){
-        for(j = 0; j < rows; j++){
-	smoothedim[j*cols+i] = (uint16_t) (((FIXED_FLOAT(smoothedimTemp[j*cols+i])) * 90) + 0.5f);
-		}
-	} */
-    
 
     return smoothedim;
 }
  
 /*******************************************************************************
-* PROCEDURE: make_gaussian_kernel
-* PURPOSE: Create a one dimensional gaussian kernel.
-* NAME: Mike Heath
-* DATE: 2/15/96
+* PROCEDURE: dsp_edges_submit
+* PURPOSE: Start blurring an image on the DSP and computing its gradient
+* magnitude and non-maximal suppression there too (-e).
 *******************************************************************************/
-void make_gaussian_kernel(float sigma, uint16_t **kernel, int *windowsize)
+pool_notify_Request* dsp_edges_submit(unsigned char *image, int rows, int cols, float sigma)
 {
-    int i, center, x;
-    uint32_t fx, sum = 0;
-
-    *windowsize = 1 + 2 * ceil(2.5 * sigma);
-    center = (*windowsize) / 2;
+    pool_notify_Request *request;
 
-    if((*kernel = (uint16_t *) malloc((*windowsize)* sizeof(uint16_t))) == NULL)
+    gaussian_kernel_for(sigma);
+    request = pool_notify_submit_edges(image, kernel, windowsize, 0); // The DSP goes on up to the suppression
+    if(request == NULL)
     {
-        fprintf(stderr, "Error callocing the gaussian kernel array.\n");
+        fprintf(stderr, "Error submitting the image to the DSP.\n");
         exit(1);
     }
+    return request;
+}
 
-    for(i=0; i<(*windowsize); i++)
+/*******************************************************************************
+* PROCEDURE: dsp_edges_finish
+* PURPOSE: Wait for the DSP to compute the gradient magnitude and the non-maximal
+* suppression of an image submitted with -e. Both are given back with
+* pool_notify_release_edges.
+*******************************************************************************/
+void dsp_edges_finish(pool_notify_Request *request, short **magnitude,
+                      unsigned char **nms)
+{
+    if(!pool_notify_wait(request, DSP_TIMEOUT_MS))
+    {
+        fprintf(stderr, "The DSP did not finish the edge steps within %d ms.\n", DSP_TIMEOUT_MS);
+        exit(1);
+    }
+    if(!pool_notify_collect_edges(request, magnitude, nms))
     {
-        x = i - center;
-        fx = FLOAT_FIXED(pow(2.71828, -0.5*x*x/(sigma*sigma)) / (sigma * sqrt(6.2831853))); // convert from float to fixed point
-        (*kernel)[i] = fx;
-        sum += fx;
+        fprintf(stderr, "The DSP failed to compute the gradient of the image.\n");
+        exit(1);
     }
+}
 
-    for(i=0; i<(*windowsize); i++) (*kernel)[i] = DIVISION((*kernel)[i], sum);
+/*******************************************************************************
+* PROCEDURE: make_recursive_gaussian
+* PURPOSE: Create the recursive gaussian filter of I.T. Young and L.J. van
+* Vliet, "Recursive implementation of the Gaussian filter", Signal Processing
+* 44 (1995), as a CMD_KERNEL_IIR kernel: the weights of the last three outputs,
+* the second one subtracted, and the gain of the input in fixed point, split in
+* 16 bit halves. The gain is what the weights leave of one, so flat regions keep
+* their value exactly.
+*******************************************************************************/
+void make_recursive_gaussian(float sigma, uint16_t **kernel, int *windowsize)
+{
+    double q, b0, b1, b2, b3;
+    uint32_t a[4];
+    int i;
+
+    if(sigma >= 2.5) q = 0.98711 * sigma - 0.96330;
+    else q = 3.97156 - 4.14554 * sqrt(1.0 - 0.26891 * sigma);
+    b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+    b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+    b2 = 1.4281 * q * q + 1.26661 * q * q * q;  /* Subtracted */
+    b3 = 0.422205 * q * q * q;
+
+    *windowsize = CMD_KERNEL_IIR;
+    if((*kernel = (uint16_t *) malloc(CMD_KERNEL_IIR * sizeof(uint16_t))) == NULL)
+    {
+        fprintf(stderr, "Error callocing the gaussian kernel array.\n");
+        exit(1);
+    }
+    a[0] = (uint32_t) floor(b1 / b0 * (1 << CMD_IIR_FRAC_BITS) + 0.5);
+    a[1] = (uint32_t) floor(b2 / b0 * (1 << CMD_IIR_FRAC_BITS) + 0.5);
+    a[2] = (uint32_t) floor(b3 / b0 * (1 << CMD_IIR_FRAC_BITS) + 0.5);
+    if((double)(1 << CMD_IIR_FRAC_BITS) - a[0] + a[1] - a[2] <= 0)
+    {
+        fprintf(stderr, "The recursive gaussian of sigma %.1f does not fit its fixed point.\n", sigma);
+        exit(1);
+    }
+    a[3] = (1 << CMD_IIR_FRAC_BITS) - a[0] + a[1] - a[2];
+    for(i=0; i<4; i++)
+    {
+        (*kernel)[2*i] = (uint16_t) (a[i] & 0xFFFF);
+        (*kernel)[2*i+1] = (uint16_t) (a[i] >> 16);
+    }
 
     if(VERBOSE)
     {
-        printf("The filter coefficients are:\n");
-        for(i=0; i<(*windowsize); i++)
-            printf("kernel[%d] = %f\n", i, FIXED_FLOAT((*kernel)[i]));
+        printf("The recursive filter coefficients are:\n");
+        printf("a1 = %u, a2 = -%u, a3 = %u, B = %u (/%d)\n", (unsigned)a[0], (unsigned)a[1],
+               (unsigned)a[2], (unsigned)a[3], 1 << CMD_IIR_FRAC_BITS);
     }
 }
@@ -0,0 +1,160 @@
+/*******************************************************************************
+* FILE: deriv_bench.c
+* Benchmark and check of the derivatives on the GPP: random smoothed frames
+* get their dx and dy from derrivative_x_y_rows(), which canny_edge uses, and
+* from the column by column derrivative_x_y_reference() it replaced. Both must
+* give the same images, for the timed frame sizes and a sweep of small odd
+* ones; the table gives their times and the speedup. Runs without the DSP.
+*
+* USAGE: deriv_bench [-n iterations] [-c]
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include "derivative.h"
+#include "bench_util.h"
+
+
+/* The smoothed image is scaled by 90 (BOOSTBLURFACTOR) */
+#define SMOOTHED_MAX (255*90)
+
+/* Sizes up to this are all checked */
+#define CHECK_MAX 40
+
+/*******************************************************************************
+* PROCEDURE: same_derivatives
+* PURPOSE: Compute the derivatives of the rows x cols frame both ways and
+* compare them. Returns 1 when they agree.
+*******************************************************************************/
+static int same_derivatives(uint16_t *smoothed, int rows, int cols,
+                            short *dx, short *dy, short *refDx, short *refDy)
+{
+    int i;
+
+    derrivative_x_y_reference(smoothed, rows, cols, refDx, refDy);
+    derrivative_x_y_rows(smoothed, rows, cols, dx, dy);
+
+    /****************************************************************************
+    * Across a frame one pixel wide or high the reference reads past the frame
+    * (the buffers here are large enough), where the row version has zero.
+    ****************************************************************************/
+    for(i = 0; i < rows*cols; i++)
+    {
+        if(cols < 2) refDx[i] = 0;
+        if(rows < 2) refDy[i] = 0;
+    }
+    if(memcmp(dx, refDx, rows*cols*sizeof(short)) != 0
+       || memcmp(dy, refDy, rows*cols*sizeof(short)) != 0)
+    {
+        fprintf(stderr, "The derivatives of the %dx%d frame differ.\n", cols, rows);
+        return 0;
+    }
+    return 1;
+}
+
+/*******************************************************************************
+* PROCEDURE: derivative_times
+* PURPOSE: Take the derivatives of the frame n times with f and store the
+* times, in microseconds, in t. Returns the median.
+*******************************************************************************/
+static double derivative_times(void (*f)(uint16_t *, int, int, short *, short *),
+                               uint16_t *smoothed, int rows, int cols,
+                               short *dx, short *dy, double *t, int n)
+{
+    double start;
+    int i;
+
+    for(i = 0; i < n; i++)
+    {
+        start = bench_now_us();
+        f(smoothed, rows, cols, dx, dy);
+        t[i] = bench_now_us() - start;
+    }
+    bench_sort(t, n);
+    return bench_percentile(t, n, 50);
+}
+
+int main(int argc, char *argv[])
+{
+    int n = 50, checkOnly = 0, opt, i, k, rows, cols;
+    uint16_t *smoothed;
+    short *dx, *dy, *refDx, *refDy;
+    double *t, byRows, byColumns;
+    size_t pixels;
+
+    while((opt = getopt(argc, argv, "n:c")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': n = atoi(optarg); break;
+            case 'c': checkOnly = 1; break;
+            default: n = 0; break;
+        }
+    }
+    if(n <= 0 || argc > optind)
+    {
+        fprintf(stderr,"\n<USAGE> %s [-n iterations] [-c]\n",argv[0]);
+        fprintf(stderr,"\n      -n:  Repetitions of every measurement (50).\n");
+        fprintf(stderr,"      -c:  Only check that both versions agree.\n");
+        exit(1);
+    }
+
+    pixels = (size_t) benchRows[BENCH_NUM_SIZES-1] * benchCols[BENCH_NUM_SIZES-1];
+    smoothed = (uint16_t *) malloc(pixels*sizeof(uint16_t));
+    dx = (short *) malloc(pixels*sizeof(short));
+    dy = (short *) malloc(pixels*sizeof(short));
+    refDx = (short *) malloc(pixels*sizeof(short));
+    refDy = (short *) malloc(pixels*sizeof(short));
+    t = (double *) malloc(n*sizeof(double));
+    if(smoothed == NULL || dx == NULL || dy == NULL || refDx == NULL || refDy == NULL || t == NULL)
+    {
+        fprintf(stderr, "Error allocating the benchmark buffers.\n");
+        exit(1);
+    }
+    srand(1);
+    for(i = 0; i < (int)pixels; i++) smoothed[i] = (uint16_t)(rand() % (SMOOTHED_MAX + 1));
+
+    /****************************************************************************
+    * Every small size, down to the one pixel wide or high images, and the
+    * timed ones.
+    ****************************************************************************/
+    for(rows = 1; rows <= CHECK_MAX; rows++)
+    {
+        for(cols = 1; cols <= CHECK_MAX; cols++)
+        {
+            if(!same_derivatives(smoothed, rows, cols, dx, dy, refDx, refDy)) exit(1);
+        }
+    }
+    for(k = 0; k < BENCH_NUM_SIZES; k++)
+    {
+        if(!same_derivatives(smoothed, benchRows[k], benchCols[k], dx, dy, refDx, refDy)) exit(1);
+    }
+    printf("The derivatives agree for every size up to %dx%d and the timed ones.\n", CHECK_MAX, CHECK_MAX);
+    if(checkOnly) return 0;
+
+    printf("%d samples per line, times in usec\n", n);
+    printf("%-9s %11s %9s %9s %9s %9s %9s\n", "order", "frame", "min", "p50", "p90", "max", "Mpix/s");
+    for(k = 0; k < BENCH_NUM_SIZES; k++)
+    {
+        rows = benchRows[k];
+        cols = benchCols[k];
+        byRows = derivative_times(derrivative_x_y_rows, smoothed, rows, cols, dx, dy, t, n);
+        bench_report("rows", rows, cols, t, n);
+        printf("\n");
+        byColumns = derivative_times(derrivative_x_y_reference, smoothed, rows, cols, refDx, refDy, t, n);
+        bench_report("columns", rows, cols, t, n);
+        printf("\n");
+        if(byRows > 0) printf("%-9s %5dx%-5d %9.2fx\n", "speedup", cols, rows, byColumns / byRows);
+    }
+
+    free(t);
+    free(refDy);
+    free(refDx);
+    free(dy);
+    free(dx);
+    free(smoothed);
+    return 0;
+}
@@ -0,0 +1,163 @@
+/*******************************************************************************
+* FILE: derivative.c
+* First derivatives of the smoothed image on the GPP. Every row of dx and dy is
+* computed from the three smoothed rows around it in one sweep, with NEON on
+* the board and SSE2 on the host build. derrivative_x_y_reference() keeps the
+* column by column version it replaces, which deriv_bench checks it against.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "derivative.h"
+/* ----------------------Arm Neon Library for SIMD registers and instructions */
+#if defined (__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*******************************************************************************
+* PROCEDURE: derrivative_x_y_row
+* PURPOSE: dx and dy of one image row, at least two pixels wide. up and down
+* are the rows above and below it, the row itself at the top and the bottom of
+* the image. The differences wrap to 16 bits, as the casts to short of the
+* reference do.
+*******************************************************************************/
+void derrivative_x_y_row(uint16_t *up, uint16_t *row, uint16_t *down, int cols,
+                         short *dx, short *dy)
+{
+    int c = 0;
+
+    /****************************************************************************
+    * dy = down - up along the whole row.
+    ****************************************************************************/
+#if defined (__ARM_NEON__)
+    for(; c+8<=cols; c+=8)
+    {
+        vst1q_s16(dy+c, vreinterpretq_s16_u16(vsubq_u16(vld1q_u16(down+c), vld1q_u16(up+c))));
+    }
+#elif defined (__SSE2__)
+    for(; c+8<=cols; c+=8)
+    {
+        _mm_storeu_si128((__m128i *)(dy+c), _mm_sub_epi16(_mm_loadu_si128((__m128i *)(down+c)),
+                                                          _mm_loadu_si128((__m128i *)(up+c))));
+    }
+#endif
+    for(; c<cols; c++) dy[c] = (short)down[c] - (short)up[c];
+
+    /****************************************************************************
+    * dx = right - left, the pixel itself standing in past the ends of the row.
+    ****************************************************************************/
+    dx[0] = (short)row[1] - (short)row[0];
+    c = 1;
+#if defined (__ARM_NEON__)
+    for(; c+8<cols; c+=8)
+    {
+        vst1q_s16(dx+c, vreinterpretq_s16_u16(vsubq_u16(vld1q_u16(row+c+1), vld1q_u16(row+c-1))));
+    }
+#elif defined (__SSE2__)
+    for(; c+8<cols; c+=8)
+    {
+        _mm_storeu_si128((__m128i *)(dx+c), _mm_sub_epi16(_mm_loadu_si128((__m128i *)(row+c+1)),
+                                                          _mm_loadu_si128((__m128i *)(row+c-1))));
+    }
+#endif
+    for(; c<cols-1; c++) dx[c] = (short)row[c+1] - (short)row[c-1];
+    dx[cols-1] = (short)row[cols-1] - (short)row[cols-2];
+}
+
+/*******************************************************************************
+* PROCEDURE: derrivative_x_y_reference
+* PURPOSE: Compute the first derivative of the image in both the x any y
+* directions, into images allocated by the caller. The differential filters
+* that are used are:
+*
+*                                          -1
+*         dx =  -1 0 +1     and       dy =  0
+*                                          +1
+*
+* NAME: Mike Heath
+* DATE: 2/15/96
+*******************************************************************************/
+void derrivative_x_y_reference(uint16_t *smoothedim, int rows, int cols,
+        short int *delta_x, short int *delta_y)
+{
+   int r, c, pos;
+
+   for(r=0;r<rows;r++){
+      pos = r * cols;
+      delta_x[pos] = (short)smoothedim[pos+1] - (short)smoothedim[pos];
+      pos++;
+      for(c=1;c<(cols-1);c++,pos++){
+         delta_x[pos] = (short)smoothedim[pos+1] - (short)smoothedim[pos-1];
+      }
+      delta_x[pos] = (short)smoothedim[pos] - (short)smoothedim[pos-1];
+   }
+
+   for(c=0;c<cols;c++){
+      pos = c;
+      delta_y[pos] = (short)smoothedim[pos+cols] - (short)smoothedim[pos];
+      pos += cols;
+      for(r=1;r<(rows-1);r++,pos+=cols){
+         delta_y[pos] = (short)smoothedim[pos+cols] - (short)smoothedim[pos-cols];
+      }
+      delta_y[pos] = (short)smoothedim[pos] - (short)smoothedim[pos-cols];
+   }
+}
+
+/*******************************************************************************
+* PROCEDURE: derrivative_x_y_rows
+* PURPOSE: The same derivatives as derrivative_x_y_reference, row by row, so
+* the image is read once in memory order.
+*******************************************************************************/
+void derrivative_x_y_rows(uint16_t *smoothedim, int rows, int cols,
+        short int *delta_x, short int *delta_y)
+{
+   int r;
+   uint16_t *up, *down;
+
+   /****************************************************************************
+   * An image one pixel wide has no neighbours across its rows, which the
+   * reference reads from the next row, writing past the image when it is one
+   * pixel high too. The pixel stands in for both, as the row itself does above
+   * and below it at the top and the bottom, so dx is zero.
+   ****************************************************************************/
+   if(cols < 2){
+      for(r=0;r<rows;r++){
+         delta_x[r] = 0;
+         delta_y[r] = (short)smoothedim[(r < rows-1) ? r+1 : r] - (short)smoothedim[(r > 0) ? r-1 : r];
+      }
+      return;
+   }
+   for(r=0;r<rows;r++){
+      up = smoothedim + ((r > 0) ? r-1 : r) * cols;
+      down = smoothedim + ((r < rows-1) ? r+1 : r) * cols;
+      derrivative_x_y_row(up, smoothedim + r*cols, down, cols, delta_x + r*cols, delta_y + r*cols);
+   }
+}
+
+/*******************************************************************************
+* PROCEDURE: derrivative_x_y
+* PURPOSE: Compute the first derivative of the image in both the x any y
+* directions, into newly allocated images.
+* NAME: Mike Heath
+* DATE: 2/15/96
+*******************************************************************************/
+void derrivative_x_y(uint16_t *smoothedim, int rows, int cols,
+        short int **delta_x, short int **delta_y)
+{
+   /****************************************************************************
+   * Allocate images to store the derivatives.
+   ****************************************************************************/
+   if(((*delta_x) = (short *) malloc(rows*cols* sizeof(short))) == NULL){
+      fprintf(stderr, "Error allocating the delta_x image.\n");
+      exit(1);
+   }
+   if(((*delta_y) = (short *) malloc(rows*cols* sizeof(short))) == NULL){
+      fprintf(stderr, "Error allocating the delta_x image.\n");
+      exit(1);
+   }
+
+   derrivative_x_y_rows(smoothedim, rows, cols, *delta_x, *delta_y);
+}
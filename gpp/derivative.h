@@ -0,0 +1,16 @@
+#ifndef DERIVATIVE_H
+#define DERIVATIVE_H
+
+#include <stdint.h>
+
+/* First derivatives of the smoothed image, see derivative.c */
+void derrivative_x_y(uint16_t *smoothedim, int rows, int cols,
+                     short int **delta_x, short int **delta_y);
+void derrivative_x_y_rows(uint16_t *smoothedim, int rows, int cols,
+                          short int *delta_x, short int *delta_y);
+void derrivative_x_y_row(uint16_t *up, uint16_t *row, uint16_t *down, int cols,
+                         short int *dx, short int *dy);
+void derrivative_x_y_reference(uint16_t *smoothedim, int rows, int cols,
+                               short int *delta_x, short int *delta_y);
+
+#endif
@@ -0,0 +1,367 @@
+/*******************************************************************************
+* FILE: hyst_bench.c
+* Benchmark and check of the hysteresis on the GPP: apply_hysteresis() in
+* every mode, following the edges with an explicit stack, labelling the weak
+* components on a number of threads and dilating the strong pixels on
+* bitplanes, against the recursive
+* apply_hysteresis_reference(). All must give the same edge map for dense
+* synthetic scenes, random candidates that percolate into one large edge and a
+* serpentine edge through the whole frame, and for the suppressed smooth scene
+* of nms_bench. The reference recurses once per edge pixel, so it runs in a
+* thread with a stack sized for the frame; where that stack cannot be had, it
+* is left out. The labelling is timed on one thread and on every power of two
+* up to the number of online processors. Runs without the DSP.
+*
+* USAGE: hyst_bench [-n iterations] [-c]
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "hysteresis.h"
+#include "derivative.h"
+#include "bench_util.h"
+
+void magnitude_x_y(short int *delta_x, short int *delta_y, int rows, int cols,
+        short int *magnitude);
+void non_max_supp(short *mag, short *gradx, short *grady, int nrows, int ncols,
+        unsigned char *result);
+
+/* The smoothed image is scaled by 90 (BOOSTBLURFACTOR) */
+#define SMOOTHED_MAX (255*90)
+
+/* The defaults of canny_edge */
+#define TLOW  0.5
+#define THIGH 0.5
+
+#define NOEDGE 255
+#define POSSIBLE_EDGE 128
+#define EDGE 0
+
+/* Stack per level of the recursion of the reference, generously */
+#define FRAME_BYTES 256
+
+/* Sizes up to this are all checked */
+#define CHECK_MAX 24
+
+/* Threads HYST_LABEL is checked on, uneven counts too to put the seams anywhere */
+#define NUM_CHECK_THREADS 4
+static const int checkThreads[NUM_CHECK_THREADS] = {1, 2, 3, 7};
+
+#define NUM_SCENES 3
+static const char *sceneName[NUM_SCENES] = {"random", "serpent", "smooth"};
+
+typedef void (*Hysteresis)(short int *, unsigned char *, int, int, float, float,
+                           unsigned char *);
+
+/* What a thread running the reference needs, and what it gives back */
+typedef struct
+{
+    Hysteresis f;
+    short *mag;
+    unsigned char *nms, *edge;
+    int rows, cols, n;
+    double *t;
+} Hyst_Run;
+
+/*******************************************************************************
+* PROCEDURE: make_scene
+* PURPOSE: The magnitude and the suppression map of a rows x cols scene.
+* random: half of the pixels are candidates, with random magnitudes, which
+* join up into edges that span the frame. serpent: every other row is an edge,
+* joined to the next at alternate ends, so the whole frame is one path. smooth:
+* the smooth frame of nms_bench, through the derivatives, the magnitude and the
+* suppression.
+*******************************************************************************/
+static void make_scene(int scene, int rows, int cols, short *mag, unsigned char *nms)
+{
+    int r, c, pos;
+    uint16_t *smoothed;
+    short *dx, *dy, *edgemag;
+    unsigned char *edgenms;
+    double v;
+
+    for(r = 0, pos = 0; r < rows; r++)
+    {
+        for(c = 0; c < cols; c++, pos++)
+        {
+            if(scene == 0)
+            {
+                mag[pos] = (short)(1 + rand() % 2048);
+                nms[pos] = (rand() & 1) ? POSSIBLE_EDGE : NOEDGE;
+            }
+            else
+            {
+                mag[pos] = (short)(1000 + (pos % 97));
+                nms[pos] = ((r % 2) == 1 || c == ((r % 4 == 0) ? 1 : cols-2)) ? POSSIBLE_EDGE : NOEDGE;
+            }
+        }
+    }
+    if(scene != 2) return;
+
+    /****************************************************************************
+    * The derivatives of a frame one pixel wide or high run past it, so the
+    * smooth scene is made at least 3x3 and its top left corner cut out.
+    ****************************************************************************/
+    r = (rows < 3) ? 3 : rows;
+    c = (cols < 3) ? 3 : cols;
+    if((smoothed = (uint16_t *) malloc(r*c*sizeof(uint16_t))) == NULL
+       || (edgemag = (short *) malloc(r*c*sizeof(short))) == NULL
+       || (edgenms = (unsigned char *) malloc(r*c)) == NULL)
+    {
+        fprintf(stderr, "Error allocating the smooth scene.\n");
+        exit(1);
+    }
+    for(pos = 0; pos < r*c; pos++)
+    {
+        v = SMOOTHED_MAX / 2 + SMOOTHED_MAX / 4 * (sin((pos % c) / 17.0) * cos((pos / c) / 23.0)
+            + sin((pos % c + pos / c) / 41.0)) + rand() % 5;
+        smoothed[pos] = (uint16_t)((v < 0) ? 0 : (v > SMOOTHED_MAX) ? SMOOTHED_MAX : v);
+    }
+    derrivative_x_y(smoothed, r, c, &dx, &dy);
+    magnitude_x_y(dx, dy, r, c, edgemag);
+    non_max_supp(edgemag, dx, dy, r, c, edgenms);
+    for(pos = 0; pos < rows*cols; pos++)
+    {
+        mag[pos] = edgemag[(pos / cols) * c + pos % cols];
+        nms[pos] = edgenms[(pos / cols) * c + pos % cols];
+    }
+    free(edgenms);
+    free(edgemag);
+    free(dy);
+    free(dx);
+    free(smoothed);
+}
+
+/*******************************************************************************
+* PROCEDURE: hysteresis_times
+* PURPOSE: Run the hysteresis of the run n times and store the times, in
+* microseconds, in t.
+*******************************************************************************/
+static void *hysteresis_times(void *arg)
+{
+    Hyst_Run *run = (Hyst_Run *) arg;
+    double start;
+    int i;
+
+    for(i = 0; i < run->n; i++)
+    {
+        start = bench_now_us();
+        run->f(run->mag, run->nms, run->rows, run->cols, TLOW, THIGH, run->edge);
+        run->t[i] = bench_now_us() - start;
+    }
+    bench_sort(run->t, run->n);
+    return NULL;
+}
+
+/*******************************************************************************
+* PROCEDURE: run_reference
+* PURPOSE: hysteresis_times for the reference, in a thread whose stack holds
+* a recursion through every candidate of the frame. Returns 0 when that thread
+* cannot be made.
+*******************************************************************************/
+static int run_reference(Hyst_Run *run)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+    size_t stack;
+    int ok;
+
+    stack = (size_t) run->rows * run->cols * FRAME_BYTES + (1 << 20);
+    pthread_attr_init(&attr);
+    ok = pthread_attr_setstacksize(&attr, stack) == 0
+         && pthread_create(&thread, &attr, hysteresis_times, run) == 0;
+    pthread_attr_destroy(&attr);
+    if(ok) pthread_join(thread, NULL);
+    return ok;
+}
+
+/*******************************************************************************
+* PROCEDURE: same_edges
+* PURPOSE: Apply the hysteresis to the scene in every mode and with the
+* reference and compare the edge maps. Returns 1 when they agree, or when the
+* reference could not run.
+*******************************************************************************/
+static int same_edges(short *mag, unsigned char *nms, int rows, int cols,
+                      unsigned char *edge, unsigned char *ref, const char *what)
+{
+    Hyst_Run run;
+    double t;
+    int i;
+
+    run.f = apply_hysteresis_reference;
+    run.mag = mag;
+    run.nms = nms;
+    run.edge = ref;
+    run.rows = rows;
+    run.cols = cols;
+    run.n = 1;
+    run.t = &t;
+    if(!run_reference(&run))
+    {
+        printf("No stack for the reference on the %dx%d %s frame, not checked.\n", cols, rows, what);
+        return 1;
+    }
+
+    hysteresisMode = HYST_FOLLOW;
+    apply_hysteresis(mag, nms, rows, cols, TLOW, THIGH, edge);
+    if(memcmp(edge, ref, rows*cols) != 0)
+    {
+        fprintf(stderr, "The followed edges of the %dx%d %s frame differ.\n", cols, rows, what);
+        return 0;
+    }
+    hysteresisMode = HYST_LABEL;
+    for(i = 0; i < NUM_CHECK_THREADS; i++)
+    {
+        hysteresisThreads = checkThreads[i];
+        apply_hysteresis(mag, nms, rows, cols, TLOW, THIGH, edge);
+        if(memcmp(edge, ref, rows*cols) != 0)
+        {
+            fprintf(stderr, "The edges of the %dx%d %s frame labelled on %d threads differ.\n",
+                    cols, rows, what, checkThreads[i]);
+            return 0;
+        }
+    }
+    hysteresisMode = HYST_BITS;
+    apply_hysteresis(mag, nms, rows, cols, TLOW, THIGH, edge);
+    if(memcmp(edge, ref, rows*cols) != 0)
+    {
+        fprintf(stderr, "The edges of the %dx%d %s frame found on bitplanes differ.\n", cols, rows, what);
+        return 0;
+    }
+    hysteresisMode = HYST_FOLLOW;
+    return 1;
+}
+
+/* A line of the table, with the speedup over following the edges */
+static void report(const char *version, int rows, int cols, double *t, int n, double byFollow)
+{
+    double p50 = bench_percentile(t, n, 50);
+
+    bench_report(version, rows, cols, t, n);
+    if(p50 > 0) printf(" %8.2fx\n", byFollow / p50);
+    else printf(" %9s\n", "-");
+}
+
+int main(int argc, char *argv[])
+{
+    int n = 20, checkOnly = 0, opt, i, k, s, rows, cols, edges, threads, processors;
+    short *mag;
+    unsigned char *nms, *edge, *ref;
+    char version[16];
+    double *t, byFollow;
+    size_t pixels;
+    Hyst_Run run;
+
+    while((opt = getopt(argc, argv, "n:c")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': n = atoi(optarg); break;
+            case 'c': checkOnly = 1; break;
+            default: n = 0; break;
+        }
+    }
+    if(n <= 0 || argc > optind)
+    {
+        fprintf(stderr,"\n<USAGE> %s [-n iterations] [-c]\n",argv[0]);
+        fprintf(stderr,"\n      -n:  Repetitions of every measurement (20).\n");
+        fprintf(stderr,"      -c:  Only check that both versions agree.\n");
+        exit(1);
+    }
+
+    pixels = (size_t) benchRows[BENCH_NUM_SIZES-1] * benchCols[BENCH_NUM_SIZES-1];
+    mag = (short *) malloc(pixels*sizeof(short));
+    nms = (unsigned char *) malloc(pixels);
+    edge = (unsigned char *) malloc(pixels);
+    ref = (unsigned char *) malloc(pixels);
+    t = (double *) malloc(n*sizeof(double));
+    if(mag == NULL || nms == NULL || edge == NULL || ref == NULL || t == NULL)
+    {
+        fprintf(stderr, "Error allocating the benchmark buffers.\n");
+        exit(1);
+    }
+
+    /****************************************************************************
+    * Every scene at every small size, down to the ones without an inside, and
+    * at the timed ones.
+    ****************************************************************************/
+    srand(1);
+    for(s = 0; s < NUM_SCENES; s++)
+    {
+        for(rows = 1; rows <= CHECK_MAX; rows++)
+        {
+            for(cols = 1; cols <= CHECK_MAX; cols++)
+            {
+                make_scene(s, rows, cols, mag, nms);
+                if(!same_edges(mag, nms, rows, cols, edge, ref, sceneName[s])) exit(1);
+            }
+        }
+        for(k = 0; k < BENCH_NUM_SIZES; k++)
+        {
+            make_scene(s, benchRows[k], benchCols[k], mag, nms);
+            if(!same_edges(mag, nms, benchRows[k], benchCols[k], edge, ref, sceneName[s])) exit(1);
+        }
+    }
+    printf("The edges agree for every scene and size up to %dx%d and the timed ones.\n",
+           CHECK_MAX, CHECK_MAX);
+    if(checkOnly) return 0;
+
+    processors = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    printf("%d samples per line, times in usec, %d processors\n", n, processors);
+    for(s = 0; s < NUM_SCENES; s++)
+    {
+        printf("\n%s scene\n", sceneName[s]);
+        printf("%-9s %11s %9s %9s %9s %9s %9s %9s\n", "version", "frame", "min", "p50", "p90", "max",
+               "Mpix/s", "speedup");
+        for(k = 0; k < BENCH_NUM_SIZES; k++)
+        {
+            rows = benchRows[k];
+            cols = benchCols[k];
+            make_scene(s, rows, cols, mag, nms);
+            run.f = apply_hysteresis;
+            run.mag = mag;
+            run.nms = nms;
+            run.edge = edge;
+            run.rows = rows;
+            run.cols = cols;
+            run.n = n;
+            run.t = t;
+            hysteresisMode = HYST_FOLLOW;
+            hysteresis_times(&run);
+            byFollow = bench_percentile(t, n, 50);
+            report("follow", rows, cols, t, n, byFollow);
+            for(i = 0, edges = 0; i < rows*cols; i++) edges += (edge[i] == EDGE);
+
+            hysteresisMode = HYST_LABEL;
+            for(threads = 1; threads <= processors; threads = (2*threads > processors && threads < processors) ? processors : 2*threads)
+            {
+                hysteresisThreads = threads;
+                hysteresis_times(&run);
+                sprintf(version, "label/%d", threads);
+                report(version, rows, cols, t, n, byFollow);
+            }
+            hysteresisMode = HYST_BITS;
+            hysteresis_times(&run);
+            report("bits", rows, cols, t, n, byFollow);
+            hysteresisMode = HYST_FOLLOW;
+
+            run.f = apply_hysteresis_reference;
+            run.edge = ref;
+            if(run_reference(&run)) report("recursive", rows, cols, t, n, byFollow);
+            else printf("%-9s %5dx%-5d no stack for it\n", "recursive", cols, rows);
+            printf("%-9s %5dx%-5d %9d edge pixels\n", "edges", cols, rows, edges);
+        }
+    }
+
+    free(t);
+    free(ref);
+    free(edge);
+    free(nms);
+    free(mag);
+    return 0;
+}
@@ -6,7 +6,18 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+/* ----------------------Arm Neon Library for SIMD registers and instructions */
+#if defined (__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "markers.h"
+#include "magnitude.h"
+#include "derivative.h"
+#include "hysteresis.h"
 
 #define VERBOSE 0
 
@@ -14,15 +25,48 @@
 #define POSSIBLE_EDGE 128
 #define EDGE 0
 
+void non_max_supp(short *mag, short *gradx, short *grady, int nrows, int ncols,
+        unsigned char *result);
+void label_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
+        float tlow, float thigh, unsigned char *edge, int threads);
+void bits_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
+        float tlow, float thigh, unsigned char *edge);
+
+int hysteresisMode = HYST_FOLLOW;
+int hysteresisThreads = 0;
+
+static const char *modeNames[HYST_NUM_MODES] = {"follow", "label", "bits"};
+
 /*******************************************************************************
-* PROCEDURE: follow_edges
+* PROCEDURE: hysteresis_mode
+* PURPOSE: The mode called name, or -1 when there is none.
+*******************************************************************************/
+int hysteresis_mode(const char *name)
+{
+    int mode;
+
+    for(mode=0; mode<HYST_NUM_MODES; mode++)
+    {
+        if(strcmp(name, modeNames[mode]) == 0) return mode;
+    }
+    return -1;
+}
+
+const char *hysteresis_mode_name(int mode)
+{
+    return (mode >= 0 && mode < HYST_NUM_MODES) ? modeNames[mode] : NULL;
+}
+
+/*******************************************************************************
+* PROCEDURE: follow_edges_reference
 * PURPOSE: This procedure edges is a recursive routine that traces edgs along
 * all paths whose magnitude values remain above some specifyable lower
-* threshhold.
+* threshhold. It recurses once per pixel of the edge, so apply_hysteresis uses
+* follow_edges instead; apply_hysteresis_reference keeps it for hyst_bench.
 * NAME: Mike Heath
 * DATE: 2/15/96
 *******************************************************************************/
-void follow_edges(unsigned char *edgemapptr, short *edgemagptr, short lowval, int cols)
+static void follow_edges_reference(unsigned char *edgemapptr, short *edgemagptr, short lowval, int cols)
 {
     short *tempmagptr;
     unsigned char *tempmapptr;
@@ -38,25 +82,118 @@ void follow_edges(unsigned char *edgemapptr, short *edgemagptr, short lowval, in
         if((*tempmapptr == POSSIBLE_EDGE) && (*tempmagptr > lowval))
         {
             *tempmapptr = (unsigned char) EDGE;
-            follow_edges(tempmapptr,tempmagptr, lowval, cols);
+            follow_edges_reference(tempmapptr,tempmagptr, lowval, cols);
         }
     }
 }
 
 /*******************************************************************************
-* PROCEDURE: apply_hysteresis
-* PURPOSE: This routine finds edges that are above some high threshhold or
-* are connected to a high pixel by a path of pixels greater than a low
-* threshold.
+* PROCEDURE: follow_edges
+* PURPOSE: Trace the edges from the pixel at pos, already marked EDGE, along
+* all paths whose magnitude values remain above lowval, as
+* follow_edges_reference does but with an explicit stack of the pixels still
+* to look around. A pixel is marked before it is pushed, so it is pushed at
+* most once and a stack with room for every possible edge never overflows. The
+* pixels reached are the same whatever the order, so is the edge map.
+*******************************************************************************/
+static void follow_edges(unsigned char *edge, short *mag, int pos, short lowval,
+                         int cols, int *stack)
+{
+    int offset[8], top = 0, i, p;
+
+    offset[0] = 1;
+    offset[1] = 1 - cols;
+    offset[2] = -cols;
+    offset[3] = -1 - cols;
+    offset[4] = -1;
+    offset[5] = -1 + cols;
+    offset[6] = cols;
+    offset[7] = 1 + cols;
+
+    stack[top++] = pos;
+    while(top > 0)
+    {
+        pos = stack[--top];
+        for(i=0; i<8; i++)
+        {
+            p = pos + offset[i];
+            if((edge[p] == POSSIBLE_EDGE) && (mag[p] > lowval))
+            {
+                edge[p] = (unsigned char) EDGE;
+                stack[top++] = p;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+* PROCEDURE: hysteresis_thresholds
+* PURPOSE: Compute the low and high thresholds from the histogram of the
+* magnitudes of the possible edges, 32768 bins.
 * NAME: Mike Heath
 * DATE: 2/15/96
 *******************************************************************************/
-void apply_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
-                      float tlow, float thigh, unsigned char *edge)
+void hysteresis_thresholds(int *hist, float tlow, float thigh,
+                           int *lowthreshold, int *highthreshold)
 {
-    int r, c, pos, numedges, highcount, lowthreshold, highthreshold, hist[32768];
+    int r, numedges, highcount;
     short int maximum_mag=0;
 
+    /****************************************************************************
+    * Compute the number of pixels that passed the nonmaximal suppression.
+    ****************************************************************************/
+    for(r=1,numedges=0; r<32768; r++)
+    {
+        if(hist[r] != 0) maximum_mag = r;
+        numedges += hist[r];
+    }
+
+    highcount = (int)(numedges * thigh + 0.5);
+
+    /****************************************************************************
+    * Compute the high threshold value as the (100 * thigh) percentage point
+    * in the magnitude of the gradient histogram of all the pixels that passes
+    * non-maximal suppression. Then calculate the low threshold as a fraction
+    * of the computed high threshold value. John Canny said in his paper
+    * "A Computational Approach to Edge Detection" that "The ratio of the
+    * high to low threshold in the implementation is in the range two or three
+    * to one." That means that in terms of this implementation, we should
+    * choose tlow ~= 0.5 or 0.33333.
+    ****************************************************************************/
+    r = 1;
+    numedges = hist[1];
+    while((r<(maximum_mag-1)) && (numedges < highcount))
+    {
+        r++;
+        numedges += hist[r];
+    }
+    *highthreshold = r;
+    *lowthreshold = (int)(*highthreshold * tlow + 0.5);
+
+    if(VERBOSE)
+    {
+        printf("The input low and high fractions of %f and %f computed to\n",
+               tlow, thigh);
+        printf("magnitude of the gradient threshold values of: %d %d\n",
+               *lowthreshold, *highthreshold);
+    }
+}
+
+/*******************************************************************************
+* PROCEDURE: hysteresis_setup
+* PURPOSE: The part of apply_hysteresis before the edges are followed: mark
+* the possible edges in the edge map and compute the low and high thresholds
+* from the histogram of their magnitudes. Returns the number of possible
+* edges.
+* NAME: Mike Heath
+* DATE: 2/15/96
+*******************************************************************************/
+static int hysteresis_setup(short int *mag, unsigned char *nms, int rows, int cols,
+                            float tlow, float thigh, unsigned char *edge,
+                            int *lowthreshold, int *highthreshold)
+{
+    int r, c, pos, numedges, hist[32768];
+
     /****************************************************************************
     * Initialize the edge map to possible edges everywhere the non-maximal
     * suppression suggested there could be an edge except for the border. At
@@ -98,44 +235,49 @@ void apply_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
                 hist[mag[pos]]++;
         }
     }
+    hysteresis_thresholds(hist, tlow, thigh, lowthreshold, highthreshold);
 
-    /****************************************************************************
-    * Compute the number of pixels that passed the nonmaximal suppression.
-    ****************************************************************************/
-    for(r=1,numedges=0; r<32768; r++)
+    for(r=0,numedges=0; r<32768; r++) numedges += hist[r];
+    return numedges;
+}
+
+/*******************************************************************************
+* PROCEDURE: apply_hysteresis
+* PURPOSE: This routine finds edges that are above some high threshhold or
+* are connected to a high pixel by a path of pixels greater than a low
+* threshold. In the mode hysteresisMode; HYST_LABEL gives the same edges with
+* label_hysteresis, on hysteresisThreads threads, and HYST_BITS with
+* bits_hysteresis.
+* NAME: Mike Heath
+* DATE: 2/15/96
+*******************************************************************************/
+void apply_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
+                      float tlow, float thigh, unsigned char *edge)
+{
+    int r, c, pos, candidates, lowthreshold, highthreshold;
+    int *stack;
+
+    if(hysteresisMode == HYST_LABEL)
     {
-        if(hist[r] != 0) maximum_mag = r;
-        numedges += hist[r];
+        label_hysteresis(mag, nms, rows, cols, tlow, thigh, edge, hysteresisThreads);
+        return;
+    }
+    if(hysteresisMode == HYST_BITS)
+    {
+        bits_hysteresis(mag, nms, rows, cols, tlow, thigh, edge);
+        return;
     }
 
-    highcount = (int)(numedges * thigh + 0.5);
+    candidates = hysteresis_setup(mag, nms, rows, cols, tlow, thigh, edge,
+                                  &lowthreshold, &highthreshold);
 
     /****************************************************************************
-    * Compute the high threshold value as the (100 * thigh) percentage point
-    * in the magnitude of the gradient histogram of all the pixels that passes
-    * non-maximal suppression. Then calculate the low threshold as a fraction
-    * of the computed high threshold value. John Canny said in his paper
-    * "A Computational Approach to Edge Detection" that "The ratio of the
-    * high to low threshold in the implementation is in the range two or three
-    * to one." That means that in terms of this implementation, we should
-    * choose tlow ~= 0.5 or 0.33333.
+    * The stack of follow_edges, one entry for every possible edge.
     ****************************************************************************/
-    r = 1;
-    numedges = hist[1];
-    while((r<(maximum_mag-1)) && (numedges < highcount))
+    if((stack = (int *) malloc((candidates+1) * sizeof(int))) == NULL)
     {
-        r++;
-        numedges += hist[r];
-    }
-    highthreshold = r;
-    lowthreshold = (int)(highthreshold * tlow + 0.5);
-
-    if(VERBOSE)
-    {
-        printf("The input low and high fractions of %f and %f computed to\n",
-               tlow, thigh);
-        printf("magnitude of the gradient threshold values of: %d %d\n",
-               lowthreshold, highthreshold);
+        fprintf(stderr, "Error allocating the edge following stack.\n");
+        exit(1);
     }
 
     /****************************************************************************
@@ -149,10 +291,11 @@ void apply_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
             if((edge[pos] == POSSIBLE_EDGE) && (mag[pos] >= highthreshold))
             {
                 edge[pos] = EDGE;
-                follow_edges((edge+pos), (mag+pos), lowthreshold, cols);
+                follow_edges(edge, mag, pos, lowthreshold, cols, stack);
             }
         }
     }
+    free(stack);
 
     /****************************************************************************
     * Set all the remaining possible edges to non-edges.
@@ -163,14 +306,487 @@ void apply_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
     }
 }
 
+/*******************************************************************************
+* PROCEDURE: apply_hysteresis_reference
+* PURPOSE: apply_hysteresis with the recursive follow_edges_reference, which
+* hyst_bench checks it against. A long edge can overflow the stack.
+* NAME: Mike Heath
+* DATE: 2/15/96
+*******************************************************************************/
+void apply_hysteresis_reference(short int *mag, unsigned char *nms, int rows, int cols,
+                                float tlow, float thigh, unsigned char *edge)
+{
+    int r, c, pos, lowthreshold, highthreshold;
+
+    hysteresis_setup(mag, nms, rows, cols, tlow, thigh, edge,
+                     &lowthreshold, &highthreshold);
+
+    for(r=0,pos=0; r<rows; r++)
+    {
+        for(c=0; c<cols; c++,pos++)
+        {
+            if((edge[pos] == POSSIBLE_EDGE) && (mag[pos] >= highthreshold))
+            {
+                edge[pos] = EDGE;
+                follow_edges_reference((edge+pos), (mag+pos), lowthreshold, cols);
+            }
+        }
+    }
+
+    for(r=0,pos=0; r<rows; r++)
+    {
+        for(c=0; c<cols; c++,pos++) if(edge[pos] != EDGE) edge[pos] = NOEDGE;
+    }
+}
+
+/*******************************************************************************
+* Values non_max_supp carries from one pixel to the next, from the end of a row
+* to the start of the next one too. gx and gy choose the neighbours; px, py and
+* pm are the derivatives and the magnitude of the last pixel with a non-zero
+* magnitude, which the float version divided into xperp and yperp. A pixel with
+* a zero magnitude reuses them, and gy is reloaded for it when gx < 0, so every
+* caller must suppress the rows in the same order.
+*******************************************************************************/
+typedef struct
+{
+    short gx, gy;
+    short px, py, pm;
+} Nms_State;
+
+/*******************************************************************************
+* PROCEDURE: round_significand
+* PURPOSE: n rounded to the 24 bit significand of a float, ties to even,
+* returning the significand and adding its exponent to *e.
+*******************************************************************************/
+static uint64_t round_significand(uint64_t n, int *e)
+{
+    int s = 0;
+    uint64_t rem, half;
+
+    while((n >> s) >= ((uint64_t)1 << 24)) s++;
+    if(s == 0) return n;
+    rem = n & (((uint64_t)1 << s) - 1);
+    half = (uint64_t)1 << (s-1);
+    n >>= s;
+    if(rem > half || (rem == half && (n & 1))) n++;
+    *e += s;
+    return n;
+}
+
+/*******************************************************************************
+* PROCEDURE: float_quotient
+* PURPOSE: The float quotient p/m of p >= 0 and m > 0, as a significand and its
+* exponent in *e. Two more bits of the quotient and one for any remainder
+* round like the exact quotient.
+*******************************************************************************/
+static uint64_t float_quotient(uint32_t p, uint32_t m, int *e)
+{
+    uint64_t num, q;
+    int k = 0;
+
+    *e = 0;
+    if(p == 0) return 0;
+    while(((uint64_t)p << k) < ((uint64_t)m << 25)) k++;
+    num = (uint64_t)p << k;
+    q = ((num / m) << 1) | ((num % m) != 0);
+    *e = -k-1;
+    return round_significand(q, e);
+}
+
+/*******************************************************************************
+* PROCEDURE: float_product
+* PURPOSE: The float product of a and the float sign * q * 2^e, as a signed
+* significand and its exponent in *pe.
+*******************************************************************************/
+static int64_t float_product(int a, int sign, uint64_t q, int e, int *pe)
+{
+    uint64_t m;
+
+    *pe = e;
+    m = round_significand((uint64_t)abs(a) * q, pe);
+    return ((a < 0) != (sign < 0)) ? -(int64_t)m : (int64_t)m;
+}
+
+/*******************************************************************************
+* PROCEDURE: nms_sign
+* PURPOSE: The sign of a*xperp + b*yperp as the float version computes it,
+* with xperp = -px/pm and yperp = py/pm. Only the sign of e = -a*px + b*py, an
+* exact integer, matters. The float rounding of the quotients, the products
+* and the sum is below 2^-22 of s = |a*px| + |b*py| over pm, so it can only
+* flip the sign when |e| is within s >> 22 of zero; then the quotients and the
+* products are rounded in integers as floats round them, as on the DSP. The sum
+* of two floats is only zero when they cancel, so its sign is the exact one.
+* When s is 0 both products are exactly 0.
+*******************************************************************************/
+int nms_sign(int a, int b, int px, int py, int pm)
+{
+    int e = -a*px + b*py, ex, ey, ea, eb;
+    unsigned int s;
+    uint64_t qx, qy;
+    int64_t ma, mb;
+
+    /* s < 2^31, so beyond 512 the sign is always certain */
+    if(e > 512) return 1;
+    if(e < -512) return -1;
+    s = (unsigned int)abs(a*px) + (unsigned int)abs(b*py);
+    if(s == 0) return 0;
+    if((unsigned int)abs(e) > (s >> 22) + 1) return (e > 0) - (e < 0);
+
+    qx = float_quotient(abs(px), pm, &ex);
+    qy = float_quotient(abs(py), pm, &ey);
+    ma = float_product(a, -px, qx, ex, &ea);
+    mb = float_product(b, py, qy, ey, &eb);
+    if(ma == 0 || mb == 0) return (ma + mb > 0) - (ma + mb < 0);
+    /* Significands up to 2^24 shifted by up to 38 bits stay within 63 */
+    if(ea - eb > 38) return (ma > 0) - (ma < 0);
+    if(eb - ea > 38) return (mb > 0) - (mb < 0);
+    if(ea > eb) ma <<= ea - eb;
+    else mb <<= eb - ea;
+    return (ma + mb > 0) - (ma + mb < 0);
+}
+
+/*******************************************************************************
+* PROCEDURE: non_max_supp_pixels
+* PURPOSE: Suppress the non-maximum points of n pixels of a row, one by one,
+* in integers. The eight interpolation cases of the float version come down to
+* one sector: along x when |gx| >= |gy| (strictly greater when both are
+* negative), the first neighbour on the side -gx and the diagonal one towards
+* -gx, -gy; the second pair is opposite. Up to the sign each case gives its
+* terms, a*xperp + b*yperp is then
+*
+*         along x:  (m00 - z1)*xperp + (z2 - z1)*yperp
+*         along y:  (z1 - z2)*xperp  + (z1 - m00)*yperp
+*
+* times the sign of gx in the first term and of gy in the second. A point is a
+* possible edge when the first is not positive and the second negative.
+*******************************************************************************/
+static void non_max_supp_pixels(short *magptr, short *gxptr, short *gyptr, int n,
+                                int ncols, unsigned char *resultptr, Nms_State *st)
+{
+    int i, m00, hx, vy, sx, sy, z1, z2, y1, y2, sign1, sign2;
+    int gx = st->gx, gy = st->gy, px = st->px, py = st->py, pm = st->pm;
+
+    for(i=0; i<n; i++,magptr++,gxptr++,gyptr++,resultptr++)
+    {
+        m00 = *magptr;
+        if(m00 != 0)
+        {
+            gx = px = *gxptr;
+            gy = py = *gyptr;
+            pm = m00;
+        }
+        else if(gx < 0) gy = *gyptr;
+
+        sx = (gx >= 0) ? 1 : -1;
+        sy = (gy >= 0) ? 1 : -1;
+        hx = -sx;
+        vy = -sy * ncols;
+        if((sx > 0 || sy > 0) ? abs(gx) >= abs(gy) : abs(gx) > abs(gy))
+        {
+            z1 = magptr[hx];
+            z2 = magptr[vy+hx];
+            y1 = magptr[-hx];
+            y2 = magptr[-vy-hx];
+            sign1 = nms_sign(sx*(m00 - z1), sy*(z2 - z1), px, py, pm);
+            sign2 = nms_sign(sx*(m00 - y1), sy*(y2 - y1), px, py, pm);
+        }
+        else
+        {
+            z1 = magptr[vy];
+            z2 = magptr[vy+hx];
+            y1 = magptr[-vy];
+            y2 = magptr[-vy-hx];
+            sign1 = nms_sign(sx*(z1 - z2), sy*(z1 - m00), px, py, pm);
+            sign2 = nms_sign(sx*(y1 - y2), sy*(y1 - m00), px, py, pm);
+        }
+        *resultptr = (sign1 <= 0 && sign2 < 0) ? (unsigned char) POSSIBLE_EDGE
+                                               : (unsigned char) NOEDGE;
+    }
+    st->gx = gx;
+    st->gy = gy;
+    st->px = px;
+    st->py = py;
+    st->pm = pm;
+}
+
+#if defined (__ARM_NEON__)
+/*******************************************************************************
+* PROCEDURE: nms_e_neon
+* PURPOSE: e of nms_sign for four lanes, from the differences dz = z2 - z1 and
+* dm = z1 - m00 of one neighbour pair. ok is cleared in the lanes where the
+* sign of e is not certain.
+*******************************************************************************/
+static inline int32x4_t nms_e_neon(int16x4_t major, int16x4_t minor, int16x4_t dz,
+                                   int16x4_t dm, uint32x4_t *ok)
+{
+    int32x4_t e = vmlal_s16(vmull_s16(dz, minor), dm, major);
+    uint32x4_t s = vreinterpretq_u32_s32(vmlal_s16(vmull_s16(vabs_s16(dz), minor),
+                                                   vabs_s16(dm), major));
+    uint32x4_t sure = vcgtq_u32(vreinterpretq_u32_s32(vabsq_s32(e)),
+                                vaddq_u32(vshrq_n_u32(s, 22), vdupq_n_u32(1)));
+
+    *ok = vandq_u32(*ok, vorrq_u32(sure, vceqq_u32(s, vdupq_n_u32(0))));
+    return e;
+}
+
+/*******************************************************************************
+* PROCEDURE: nms_neon
+* PURPOSE: non_max_supp_pixels of eight pixels, all with a non-zero magnitude
+* so none reuses the state. The neighbours are picked per lane from the eight
+* around it; in |gx| and |gy| both sectors give
+*
+*         e = (z2 - z1)*minor + (z1 - m00)*major
+*
+* with major the derivative along the sector. Returns 0, having written
+* nothing, when some lane has a zero magnitude, a derivative of -32768 or a
+* sign nms_sign would have to round out.
+*******************************************************************************/
+static int nms_neon(short *magptr, short *gxptr, short *gyptr, int ncols,
+                    unsigned char *resultptr)
+{
+    int16x8_t m, gx, gy, ax, ay, major, minor, z1, z2, y1, y2, dz1, dm1, dz2, dm2;
+    uint16x8_t hx, vy, xmaj, bad, pos;
+    int32x4_t e1lo, e1hi, e2lo, e2hi;
+    uint32x4_t oklo = vdupq_n_u32(~0u), okhi = vdupq_n_u32(~0u);
+
+    m = vld1q_s16(magptr);
+    gx = vld1q_s16(gxptr);
+    gy = vld1q_s16(gyptr);
+    ax = vabsq_s16(gx);
+    ay = vabsq_s16(gy);
+    bad = vorrq_u16(vceqq_s16(m, vdupq_n_s16(0)),
+                    vorrq_u16(vcltq_s16(ax, vdupq_n_s16(0)), vcltq_s16(ay, vdupq_n_s16(0))));
+    if(vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(bad)), 0) != 0) return 0;
+
+    /* The sides of -gx and -gy, and whether the sector runs along x */
+    hx = vcgeq_s16(gx, vdupq_n_s16(0));
+    vy = vcgeq_s16(gy, vdupq_n_s16(0));
+    xmaj = vbslq_u16(vorrq_u16(hx, vy), vcgeq_s16(ax, ay), vcgtq_s16(ax, ay));
+    major = vbslq_s16(xmaj, ax, ay);
+    minor = vbslq_s16(xmaj, ay, ax);
+
+    /* z1, z2 on the side of -g, y1, y2 opposite */
+    z2 = vbslq_s16(vy, vbslq_s16(hx, vld1q_s16(magptr-ncols-1), vld1q_s16(magptr-ncols+1)),
+                       vbslq_s16(hx, vld1q_s16(magptr+ncols-1), vld1q_s16(magptr+ncols+1)));
+    y2 = vbslq_s16(vy, vbslq_s16(hx, vld1q_s16(magptr+ncols+1), vld1q_s16(magptr+ncols-1)),
+                       vbslq_s16(hx, vld1q_s16(magptr-ncols+1), vld1q_s16(magptr-ncols-1)));
+    z1 = vbslq_s16(xmaj, vbslq_s16(hx, vld1q_s16(magptr-1), vld1q_s16(magptr+1)),
+                         vbslq_s16(vy, vld1q_s16(magptr-ncols), vld1q_s16(magptr+ncols)));
+    y1 = vbslq_s16(xmaj, vbslq_s16(hx, vld1q_s16(magptr+1), vld1q_s16(magptr-1)),
+                         vbslq_s16(vy, vld1q_s16(magptr+ncols), vld1q_s16(magptr-ncols)));
+    dz1 = vsubq_s16(z2, z1);
+    dm1 = vsubq_s16(z1, m);
+    dz2 = vsubq_s16(y2, y1);
+    dm2 = vsubq_s16(y1, m);
+
+    e1lo = nms_e_neon(vget_low_s16(major), vget_low_s16(minor), vget_low_s16(dz1), vget_low_s16(dm1), &oklo);
+    e1hi = nms_e_neon(vget_high_s16(major), vget_high_s16(minor), vget_high_s16(dz1), vget_high_s16(dm1), &okhi);
+    e2lo = nms_e_neon(vget_low_s16(major), vget_low_s16(minor), vget_low_s16(dz2), vget_low_s16(dm2), &oklo);
+    e2hi = nms_e_neon(vget_high_s16(major), vget_high_s16(minor), vget_high_s16(dz2), vget_high_s16(dm2), &okhi);
+    bad = vmvnq_u16(vcombine_u16(vmovn_u32(oklo), vmovn_u32(okhi)));
+    if(vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(bad)), 0) != 0) return 0;
+
+    /* A possible edge when e1 <= 0 and e2 < 0 */
+    pos = vcombine_u16(vmovn_u32(vandq_u32(vcleq_s32(e1lo, vdupq_n_s32(0)), vcltq_s32(e2lo, vdupq_n_s32(0)))),
+                       vmovn_u32(vandq_u32(vcleq_s32(e1hi, vdupq_n_s32(0)), vcltq_s32(e2hi, vdupq_n_s32(0)))));
+    vst1_u8(resultptr, vbsl_u8(vmovn_u16(pos), vdup_n_u8(POSSIBLE_EDGE), vdup_n_u8(NOEDGE)));
+    return 1;
+}
+#elif defined (__SSE2__)
+static inline __m128i select_si128(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/*******************************************************************************
+* PROCEDURE: nms_e_sse2
+* PURPOSE: e of nms_sign for four lanes, from the interleaved major, minor and
+* dm, dz of one neighbour pair. ok is cleared in the lanes where the sign of e
+* is not certain.
+*******************************************************************************/
+static inline __m128i nms_e_sse2(__m128i g, __m128i d, __m128i *ok)
+{
+    __m128i e = _mm_madd_epi16(d, g), sign, abse, s, zero = _mm_setzero_si128();
+
+    sign = _mm_srai_epi16(d, 15);
+    s = _mm_madd_epi16(_mm_sub_epi16(_mm_xor_si128(d, sign), sign), g);
+    sign = _mm_srai_epi32(e, 31);
+    abse = _mm_sub_epi32(_mm_xor_si128(e, sign), sign);
+    *ok = _mm_and_si128(*ok, _mm_or_si128(_mm_cmpeq_epi32(s, zero),
+                        _mm_cmpgt_epi32(abse, _mm_add_epi32(_mm_srli_epi32(s, 22), _mm_set1_epi32(1)))));
+    return e;
+}
+
+/*******************************************************************************
+* PROCEDURE: nms_sse2
+* PURPOSE: non_max_supp_pixels of eight pixels, as nms_neon on the board.
+*******************************************************************************/
+static int nms_sse2(short *magptr, short *gxptr, short *gyptr, int ncols,
+                    unsigned char *resultptr)
+{
+    __m128i m, gx, gy, ax, ay, hx, vy, xmaj, major, minor, z1, z2, y1, y2, dz1, dm1, dz2, dm2;
+    __m128i g, e1lo, e1hi, e2lo, e2hi, oklo, okhi, zero = _mm_setzero_si128();
+
+#define LOAD(offset) _mm_loadu_si128((__m128i *)(magptr + (offset)))
+    m = LOAD(0);
+    gx = _mm_loadu_si128((__m128i *)gxptr);
+    gy = _mm_loadu_si128((__m128i *)gyptr);
+    ax = _mm_max_epi16(gx, _mm_sub_epi16(zero, gx));
+    ay = _mm_max_epi16(gy, _mm_sub_epi16(zero, gy));
+    if(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi16(m, zero),
+                         _mm_or_si128(_mm_cmplt_epi16(ax, zero), _mm_cmplt_epi16(ay, zero)))) != 0)
+        return 0;
+
+    /* The sides of -gx and -gy, and whether the sector runs along x */
+    hx = _mm_cmpgt_epi16(gx, _mm_set1_epi16(-1));
+    vy = _mm_cmpgt_epi16(gy, _mm_set1_epi16(-1));
+    xmaj = select_si128(_mm_or_si128(hx, vy), _mm_xor_si128(_mm_cmpgt_epi16(ay, ax), _mm_set1_epi16(-1)),
+                        _mm_cmpgt_epi16(ax, ay));
+    major = select_si128(xmaj, ax, ay);
+    minor = select_si128(xmaj, ay, ax);
+
+    /* z1, z2 on the side of -g, y1, y2 opposite */
+    z2 = select_si128(vy, select_si128(hx, LOAD(-ncols-1), LOAD(-ncols+1)),
+                          select_si128(hx, LOAD(ncols-1), LOAD(ncols+1)));
+    y2 = select_si128(vy, select_si128(hx, LOAD(ncols+1), LOAD(ncols-1)),
+                          select_si128(hx, LOAD(-ncols+1), LOAD(-ncols-1)));
+    z1 = select_si128(xmaj, select_si128(hx, LOAD(-1), LOAD(1)),
+                            select_si128(vy, LOAD(-ncols), LOAD(ncols)));
+    y1 = select_si128(xmaj, select_si128(hx, LOAD(1), LOAD(-1)),
+                            select_si128(vy, LOAD(ncols), LOAD(-ncols)));
+#undef LOAD
+    dz1 = _mm_sub_epi16(z2, z1);
+    dm1 = _mm_sub_epi16(z1, m);
+    dz2 = _mm_sub_epi16(y2, y1);
+    dm2 = _mm_sub_epi16(y1, m);
+
+    /* e = dz*minor + dm*major, pairwise with madd */
+    oklo = okhi = _mm_set1_epi32(-1);
+    g = _mm_unpacklo_epi16(minor, major);
+    e1lo = nms_e_sse2(g, _mm_unpacklo_epi16(dz1, dm1), &oklo);
+    e2lo = nms_e_sse2(g, _mm_unpacklo_epi16(dz2, dm2), &oklo);
+    g = _mm_unpackhi_epi16(minor, major);
+    e1hi = nms_e_sse2(g, _mm_unpackhi_epi16(dz1, dm1), &okhi);
+    e2hi = nms_e_sse2(g, _mm_unpackhi_epi16(dz2, dm2), &okhi);
+    if(_mm_movemask_epi8(_mm_packs_epi32(oklo, okhi)) != 0xFFFF) return 0;
+
+    /* A possible edge when e1 <= 0 and e2 < 0 */
+    g = _mm_packs_epi32(_mm_andnot_si128(_mm_cmpgt_epi32(e1lo, zero), _mm_cmplt_epi32(e2lo, zero)),
+                        _mm_andnot_si128(_mm_cmpgt_epi32(e1hi, zero), _mm_cmplt_epi32(e2hi, zero)));
+    g = _mm_packs_epi16(g, g);
+    _mm_storel_epi64((__m128i *)resultptr,
+                     _mm_xor_si128(_mm_set1_epi8((char)NOEDGE),
+                                   _mm_and_si128(g, _mm_set1_epi8((char)(NOEDGE ^ POSSIBLE_EDGE)))));
+    return 1;
+}
+#endif
+
+/*******************************************************************************
+* PROCEDURE: non_max_supp_row
+* PURPOSE: Suppress the non-maximum points of one row, from its second column
+* to its last but two, eight at a time where no pixel reuses the state. The
+* pointers point at the second column; the magnitude must hold the rows above
+* and below it.
+*******************************************************************************/
+static void non_max_supp_row(short *magrowptr, short *gxrowptr, short *gyrowptr,
+                             int ncols, unsigned char *resultrowptr, Nms_State *st)
+{
+    int c = 0, n = ncols - 3;
+
+#if defined (__ARM_NEON__) || defined (__SSE2__)
+    for(; c+8<=n; c+=8)
+    {
+#if defined (__ARM_NEON__)
+        if(nms_neon(magrowptr+c, gxrowptr+c, gyrowptr+c, ncols, resultrowptr+c))
+#else
+        if(nms_sse2(magrowptr+c, gxrowptr+c, gyrowptr+c, ncols, resultrowptr+c))
+#endif
+        {
+            st->gx = st->px = gxrowptr[c+7];
+            st->gy = st->py = gyrowptr[c+7];
+            st->pm = magrowptr[c+7];
+        }
+        else non_max_supp_pixels(magrowptr+c, gxrowptr+c, gyrowptr+c, 8, ncols,
+                                 resultrowptr+c, st);
+    }
+#endif
+    if(c < n) non_max_supp_pixels(magrowptr+c, gxrowptr+c, gyrowptr+c, n-c, ncols,
+                                  resultrowptr+c, st);
+}
+
 /*******************************************************************************
 * PROCEDURE: non_max_supp
 * PURPOSE: This routine applies non-maximal suppression to the magnitude of
-* the gradient image.
+* the gradient image, in integers (see non_max_supp_pixels), with the result
+* of the float version.
 * NAME: Mike Heath
 * DATE: 2/15/96
 *******************************************************************************/
 void non_max_supp(short *mag, short *gradx, short *grady, int nrows, int ncols, unsigned char *result)
+{
+    int rowcount,count;
+    short *magrowptr,*gxrowptr,*gyrowptr;
+    Nms_State st = {0, 0, 0, 0, 1};
+    unsigned char *resultrowptr, *resultptr;
+
+
+    /****************************************************************************
+    * Zero the edges of the result image.
+    ****************************************************************************/
+    for(count=0,resultrowptr=result,resultptr=result+ncols*(nrows-1);
+            count<ncols; resultptr++,resultrowptr++,count++)
+    {
+        *resultrowptr = *resultptr = (unsigned char) 0;
+    }
+
+    for(count=0,resultptr=result,resultrowptr=result+ncols-1;
+            count<nrows; count++,resultptr+=ncols,resultrowptr+=ncols)
+    {
+        *resultptr = *resultrowptr = (unsigned char) 0;
+    }
+
+    /****************************************************************************
+    * The loops below stop short of the last row and column but one. Zero them
+    * too rather than leaving them uninitialized.
+    ****************************************************************************/
+    if(nrows > 2)
+    {
+        for(count=0,resultptr=result+ncols*(nrows-2); count<ncols; count++,resultptr++)
+        {
+            *resultptr = (unsigned char) 0;
+        }
+    }
+    if(ncols > 2)
+    {
+        for(count=0,resultptr=result+ncols-2; count<nrows; count++,resultptr+=ncols)
+        {
+            *resultptr = (unsigned char) 0;
+        }
+    }
+
+    /****************************************************************************
+    * Suppress non-maximum points.
+    ****************************************************************************/
+    for(rowcount=1,magrowptr=mag+ncols+1,gxrowptr=gradx+ncols+1,
+            gyrowptr=grady+ncols+1,resultrowptr=result+ncols+1;
+            rowcount<nrows-2;
+            rowcount++,magrowptr+=ncols,gyrowptr+=ncols,gxrowptr+=ncols,
+            resultrowptr+=ncols)
+    {
+        non_max_supp_row(magrowptr, gxrowptr, gyrowptr, ncols, resultrowptr, &st);
+    }
+}
+
+/*******************************************************************************
+* PROCEDURE: non_max_supp_reference
+* PURPOSE: This routine applies non-maximal suppression to the magnitude of
+* the gradient image. It is the float version that non_max_supp replaces and
+* nms_bench checks it against.
+* NAME: Mike Heath
+* DATE: 2/15/96
+*******************************************************************************/
+void non_max_supp_reference(short *mag, short *gradx, short *grady, int nrows, int ncols,
+                           unsigned char *result)
 {
     int rowcount, colcount,count;
     short *magrowptr,*magptr;
@@ -196,6 +812,25 @@ void non_max_supp(short *mag, short *gradx, short *grady, int nrows, int ncols,
         *resultptr = *resultrowptr = (unsigned char) 0;
     }
 
+    /****************************************************************************
+    * The loops below stop short of the last row and column but one. Zero them
+    * too rather than leaving them uninitialized.
+    ****************************************************************************/
+    if(nrows > 2)
+    {
+        for(count=0,resultptr=result+ncols*(nrows-2); count<ncols; count++,resultptr++)
+        {
+            *resultptr = (unsigned char) 0;
+        }
+    }
+    if(ncols > 2)
+    {
+        for(count=0,resultptr=result+ncols-2; count<nrows; count++,resultptr+=ncols)
+        {
+            *resultptr = (unsigned char) 0;
+        }
+    }
+
     /****************************************************************************
     * Suppress non-maximum points.
     ****************************************************************************/
@@ -375,3 +1010,71 @@ void non_max_supp(short *mag, short *gradx, short *grady, int nrows, int ncols,
         }
     }
 }
+
+/*******************************************************************************
+* PROCEDURE: gradient_nms
+* PURPOSE: The derivatives, the magnitude of the gradient and the non-maximal
+* suppression of the smoothed image in one sweep down its rows. Only the rows
+* of the derivatives that the suppression still needs are kept, the current
+* one and the one above it, so neither derivative image is ever written out.
+* The magnitude and the result are the ones derrivative_x_y, magnitude_x_y
+* and non_max_supp give.
+*******************************************************************************/
+void gradient_nms(uint16_t *smoothedim, int rows, int cols, short *mag,
+                  unsigned char *result)
+{
+    int r, c, cur;
+    short *dx, *dy;
+    uint16_t *up, *down;
+    Nms_State st = {0, 0, 0, 0, 1};
+
+    /****************************************************************************
+    * An image one pixel wide or high has no rows to suppress; the derivatives
+    * of it are left to the whole image version.
+    ****************************************************************************/
+    if(rows < 2 || cols < 2)
+    {
+        derrivative_x_y(smoothedim, rows, cols, &dx, &dy);
+        magnitude_x_y(dx, dy, rows, cols, mag);
+        non_max_supp(mag, dx, dy, rows, cols, result);
+        free(dx);
+        free(dy);
+        return;
+    }
+
+    if((dx = (short *) malloc(4*cols*sizeof(short))) == NULL)
+    {
+        fprintf(stderr, "Error allocating the derivative rows.\n");
+        exit(1);
+    }
+    dy = dx + 2*cols;
+
+    for(r=0; r<rows; r++)
+    {
+        cur = (r & 1) * cols;
+        up = smoothedim + ((r > 0) ? r-1 : r) * cols;
+        down = smoothedim + ((r < rows-1) ? r+1 : r) * cols;
+        derrivative_x_y_row(up, smoothedim + r*cols, down, cols, dx+cur, dy+cur);
+        magnitude_x_y(dx+cur, dy+cur, 1, cols, mag + r*cols);
+
+        /************************************************************************
+        * The magnitude of row r completes the neighbourhood of row r-1. The
+        * rows and columns non_max_supp zeroes are zeroed the same way.
+        ************************************************************************/
+        if(r-1 >= 1 && r-1 < rows-2)
+        {
+            cur = ((r-1) & 1) * cols;
+            result[(r-1)*cols] = (unsigned char) 0;
+            for(c=(cols-2 > 1) ? cols-2 : 1; c<cols; c++) result[(r-1)*cols+c] = (unsigned char) 0;
+            non_max_supp_row(mag + (r-1)*cols + 1, dx+cur+1, dy+cur+1, cols,
+                             result + (r-1)*cols + 1, &st);
+        }
+        else if(r-1 >= 0)
+        {
+            memset(result + (r-1)*cols, 0, cols);
+        }
+    }
+    memset(result + (rows-1)*cols, 0, cols);
+
+    free(dx);
+}
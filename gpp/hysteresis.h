@@ -0,0 +1,25 @@
+#ifndef HYSTERESIS_H
+#define HYSTERESIS_H
+
+/* Ways of applying the hysteresis, see hysteresis.c */
+#define HYST_FOLLOW    0    /* follow the edges from every strong pixel */
+#define HYST_LABEL     1    /* label the weak components in parallel bands */
+#define HYST_BITS      2    /* dilate the strong pixels within the weak ones, on bitplanes */
+#define HYST_NUM_MODES 3
+
+/* The mode apply_hysteresis() uses, HYST_FOLLOW unless changed */
+extern int hysteresisMode;
+/* Threads of HYST_LABEL, 0 for one per online processor */
+extern int hysteresisThreads;
+
+int hysteresis_mode(const char *name);
+const char *hysteresis_mode_name(int mode);
+void apply_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
+                      float tlow, float thigh, unsigned char *edge);
+void apply_hysteresis_reference(short int *mag, unsigned char *nms, int rows, int cols,
+                                float tlow, float thigh, unsigned char *edge);
+
+/* The sign of the float interpolation of the suppression, in integers */
+int nms_sign(int a, int b, int px, int py, int pm);
+
+#endif
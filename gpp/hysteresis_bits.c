@@ -0,0 +1,372 @@
+/*******************************************************************************
+* FILE: hysteresis_bits.c
+* Hysteresis by morphological reconstruction on bitplanes, for HYST_BITS. The
+* weak pixels (the possible edges above the low threshold, and the strong ones)
+* and the strong pixels are packed 64 to a word. The edges are the strong set,
+* dilated over and over with the 8-neighbourhood and masked with the weak set
+* until it stops growing: exactly the pixels follow_edges reaches. A row takes
+* the dilation of the row above or below it and spreads it along its own runs
+* of weak pixels, a word at a time, with no branch per pixel. The frame is cut
+* into strips of BITS_STRIP_ROWS rows; a strip is swept down and up until it
+* settles, and only the strips next to a border row that changed are swept
+* again in the next round.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+/* ----------------------Arm Neon Library for SIMD registers and instructions */
+#if defined (__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define NOEDGE 255
+#define POSSIBLE_EDGE 128
+#define EDGE 0
+
+/* Rows of a strip, the part of the frame that is skipped when nothing next to it changed */
+#define BITS_STRIP_ROWS 32
+
+void hysteresis_thresholds(int *hist, float tlow, float thigh,
+        int *lowthreshold, int *highthreshold);
+
+/*******************************************************************************
+* PROCEDURE: fill_up
+* PURPOSE: Spread the bits of gen towards bit 63 along the runs of bits of
+* pro, in six doubling steps.
+*******************************************************************************/
+static inline uint64_t fill_up(uint64_t gen, uint64_t pro)
+{
+    gen |= pro & (gen << 1);
+    pro &= pro << 1;
+    gen |= pro & (gen << 2);
+    pro &= pro << 2;
+    gen |= pro & (gen << 4);
+    pro &= pro << 4;
+    gen |= pro & (gen << 8);
+    pro &= pro << 8;
+    gen |= pro & (gen << 16);
+    pro &= pro << 16;
+    return gen | (pro & (gen << 32));
+}
+
+/* fill_up towards bit 0 */
+static inline uint64_t fill_down(uint64_t gen, uint64_t pro)
+{
+    gen |= pro & (gen >> 1);
+    pro &= pro >> 1;
+    gen |= pro & (gen >> 2);
+    pro &= pro >> 2;
+    gen |= pro & (gen >> 4);
+    pro &= pro >> 4;
+    gen |= pro & (gen >> 8);
+    pro &= pro >> 8;
+    gen |= pro & (gen >> 16);
+    pro &= pro >> 16;
+    return gen | (pro & (gen >> 32));
+}
+
+#if defined (__ARM_NEON__)
+/* The bit of each byte within its half, for the masks NEON has no instruction for */
+static const uint8_t byteBits[16] = {1,2,4,8,16,32,64,128,1,2,4,8,16,32,64,128};
+
+/* One bit for each all-ones byte of x, byte 0 in bit 0 */
+static inline unsigned movemask_neon(uint8x16_t x)
+{
+    uint8x16_t b = vandq_u8(x, vld1q_u8(byteBits));
+    uint8x8_t p = vpadd_u8(vget_low_u8(b), vget_high_u8(b));
+
+    p = vpadd_u8(p, p);
+    p = vpadd_u8(p, p);
+    return vget_lane_u8(p, 0) | (vget_lane_u8(p, 1) << 8);
+}
+#endif
+
+/*******************************************************************************
+* PROCEDURE: pack_word
+* PURPOSE: The weak and the strong bits of the n pixels of a word, at most 64,
+* from their suppression map and magnitudes; the weak ones take the strong
+* ones in. A whole word goes 16 pixels at a time with NEON or SSE2.
+*******************************************************************************/
+static void pack_word(const unsigned char *nms, const short *mag, int n, int low, int high,
+                      uint64_t *weakBits, uint64_t *strongBits)
+{
+    uint64_t weak = 0, strong = 0;
+    int c = 0, m;
+#if defined (__ARM_NEON__)
+    int16x8_t vlow = vdupq_n_s16((short)((low > 32767) ? 32767 : (low < -32768) ? -32768 : low));
+    int16x8_t vhigh = vdupq_n_s16((short)(high - 1));
+    uint8x16_t cand, s, wk;
+    int16x8_t m0, m1;
+
+    for(; n == 64 && c < 64; c += 16)
+    {
+        cand = vceqq_u8(vld1q_u8(nms+c), vdupq_n_u8(POSSIBLE_EDGE));
+        m0 = vld1q_s16(mag+c);
+        m1 = vld1q_s16(mag+c+8);
+        s = vandq_u8(cand, vcombine_u8(vmovn_u16(vcgtq_s16(m0, vhigh)), vmovn_u16(vcgtq_s16(m1, vhigh))));
+        wk = vandq_u8(cand, vcombine_u8(vmovn_u16(vcgtq_s16(m0, vlow)), vmovn_u16(vcgtq_s16(m1, vlow))));
+        strong |= (uint64_t)movemask_neon(s) << c;
+        weak |= (uint64_t)movemask_neon(vorrq_u8(wk, s)) << c;
+    }
+#elif defined (__SSE2__)
+    __m128i vlow = _mm_set1_epi16((short)((low > 32767) ? 32767 : (low < -32768) ? -32768 : low));
+    __m128i vhigh = _mm_set1_epi16((short)(high - 1));
+    __m128i cand, s, wk, m0, m1;
+
+    for(; n == 64 && c < 64; c += 16)
+    {
+        cand = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(nms+c)), _mm_set1_epi8((char)POSSIBLE_EDGE));
+        m0 = _mm_loadu_si128((const __m128i *)(mag+c));
+        m1 = _mm_loadu_si128((const __m128i *)(mag+c+8));
+        s = _mm_and_si128(cand, _mm_packs_epi16(_mm_cmpgt_epi16(m0, vhigh), _mm_cmpgt_epi16(m1, vhigh)));
+        wk = _mm_and_si128(cand, _mm_packs_epi16(_mm_cmpgt_epi16(m0, vlow), _mm_cmpgt_epi16(m1, vlow)));
+        strong |= (uint64_t)_mm_movemask_epi8(s) << c;
+        weak |= (uint64_t)_mm_movemask_epi8(_mm_or_si128(wk, s)) << c;
+    }
+#endif
+    for(; c < n; c++)
+    {
+        if(nms[c] != POSSIBLE_EDGE) continue;
+        m = mag[c];
+        if(m >= high) strong |= (uint64_t)1 << c;
+        if(m > low || m >= high) weak |= (uint64_t)1 << c;
+    }
+    *weakBits = weak;
+    *strongBits = strong;
+}
+
+/*******************************************************************************
+* PROCEDURE: unpack_word
+* PURPOSE: Write the n pixels of a word of edges, EDGE for the set bits and
+* NOEDGE for the others.
+*******************************************************************************/
+static void unpack_word(uint64_t bits, unsigned char *edge, int n)
+{
+    int c = 0;
+
+    if(bits == 0)
+    {
+        memset(edge, NOEDGE, n);
+        return;
+    }
+#if defined (__ARM_NEON__)
+    for(; n == 64 && c < 64; c += 16)
+    {
+        vst1q_u8(edge+c, vmvnq_u8(vtstq_u8(vcombine_u8(vdup_n_u8((uint8_t)(bits >> c)),
+                                                       vdup_n_u8((uint8_t)(bits >> (c+8)))),
+                                           vld1q_u8(byteBits))));
+    }
+#elif defined (__SSE2__)
+    for(; n == 64 && c < 64; c += 16)
+    {
+        _mm_storeu_si128((__m128i *)(edge+c),
+                         _mm_cmpeq_epi8(_mm_and_si128(_mm_unpacklo_epi64(_mm_set1_epi8((char)(bits >> c)),
+                                                                         _mm_set1_epi8((char)(bits >> (c+8)))),
+                                                      _mm_set_epi8(-128,64,32,16,8,4,2,1,-128,64,32,16,8,4,2,1)),
+                                        _mm_setzero_si128()));
+    }
+#endif
+    for(; c < n; c++) edge[c] = ((bits >> c) & 1) ? EDGE : NOEDGE;
+}
+
+/*******************************************************************************
+* PROCEDURE: close_row
+* PURPOSE: Spread the edges e of a row along its runs of weak pixels w, up
+* the words and back down, carrying across them.
+*******************************************************************************/
+static void close_row(uint64_t *e, const uint64_t *w, int words)
+{
+    int i;
+    uint64_t carry = 0;
+
+    for(i=0; i<words; i++)
+    {
+        if(e[i] | carry) e[i] = fill_up(e[i] | (carry & w[i]), w[i]);
+        carry = e[i] >> 63;
+    }
+    carry = 0;
+    for(i=words-1; i>=0; i--)
+    {
+        if(e[i] | carry) e[i] = fill_down(e[i] | ((carry << 63) & w[i]), w[i]);
+        carry = e[i] & 1;
+    }
+}
+
+/*******************************************************************************
+* PROCEDURE: spread_row
+* PURPOSE: Add to the edges e of a row its weak pixels w next to the edges b
+* of the row above or below it, and spread them along the row. Returns 1 when
+* the row changed.
+*******************************************************************************/
+static int spread_row(uint64_t *e, const uint64_t *w, const uint64_t *b, int words)
+{
+    int i, changed = 0;
+    uint64_t d, add;
+
+    for(i=0; i<words; i++)
+    {
+        d = b[i] | (b[i] << 1) | (b[i] >> 1);
+        if(i > 0) d |= b[i-1] >> 63;
+        if(i < words-1) d |= b[i+1] << 63;
+        add = d & w[i] & ~e[i];
+        if(add)
+        {
+            e[i] |= add;
+            changed = 1;
+        }
+    }
+    if(changed) close_row(e, w, words);
+    return changed;
+}
+
+/*******************************************************************************
+* PROCEDURE: settle_strip
+* PURPOSE: Sweep the rows first to last - 1 down and up, each row taking the
+* edges of the one before it, until a sweep changes nothing. Returns 1 when
+* the top row changed and 2 when the bottom one did, or both, as the strips on
+* those sides have to be swept again.
+*******************************************************************************/
+static int settle_strip(uint64_t *e, const uint64_t *w, int words, int first, int last)
+{
+    int r, changed, sides = 0;
+
+    do
+    {
+        changed = 0;
+        for(r=first; r<last; r++)
+        {
+            if(spread_row(e + r*words, w + r*words, e + (r-1)*words, words))
+            {
+                changed = 1;
+                if(r == first) sides |= 1;
+                if(r == last-1) sides |= 2;
+            }
+        }
+        for(r=last-1; r>=first; r--)
+        {
+            if(spread_row(e + r*words, w + r*words, e + (r+1)*words, words))
+            {
+                changed = 1;
+                if(r == first) sides |= 1;
+                if(r == last-1) sides |= 2;
+            }
+        }
+    } while(changed);
+    return sides;
+}
+
+/*******************************************************************************
+* PROCEDURE: bits_hysteresis
+* PURPOSE: The edges of apply_hysteresis, found by reconstructing the strong
+* pixels within the weak ones on bitplanes.
+*******************************************************************************/
+void bits_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
+                     float tlow, float thigh, unsigned char *edge)
+{
+    int r, c, i, s, pos, words, strips, first, last, sides, any, down, hist[32768];
+    int lowthreshold, highthreshold;
+    uint64_t *e, *w;
+    unsigned char *active;
+
+    /****************************************************************************
+    * The thresholds, from the histogram of the possible edges off the border.
+    ****************************************************************************/
+    memset(hist, 0, sizeof(hist));
+    for(r=1; r<rows-1; r++)
+    {
+        for(c=1,pos=r*cols+1; c<cols-1; c++,pos++)
+        {
+            if(nms[pos] == POSSIBLE_EDGE) hist[mag[pos]]++;
+        }
+    }
+    hysteresis_thresholds(hist, tlow, thigh, &lowthreshold, &highthreshold);
+
+    words = (cols + 63) / 64;
+    strips = (rows + BITS_STRIP_ROWS - 1) / BITS_STRIP_ROWS;
+    e = (uint64_t *) calloc(rows * words, sizeof(uint64_t));
+    w = (uint64_t *) calloc(rows * words, sizeof(uint64_t));
+    active = (unsigned char *) calloc(strips, 1);
+    if(e == NULL || w == NULL || active == NULL)
+    {
+        fprintf(stderr, "Error allocating the hysteresis bitplanes.\n");
+        exit(1);
+    }
+
+    /****************************************************************************
+    * Pack the planes. The border is never weak, so no dilation leaves the
+    * frame. A strong pixel at or below the low threshold, which only happens
+    * when that is not below the high one, is taken as weak too: then no other
+    * pixel is weak and the strong pixels are the edges.
+    ****************************************************************************/
+    for(r=1; r<rows-1; r++)
+    {
+        for(i=0; i<words; i++)
+        {
+            pos = r*cols + i*64;
+            pack_word(nms + pos, mag + pos, (cols - i*64 < 64) ? cols - i*64 : 64,
+                      lowthreshold, highthreshold, &w[r*words + i], &e[r*words + i]);
+        }
+        w[r*words] &= ~(uint64_t)1;
+        e[r*words] &= ~(uint64_t)1;
+        w[r*words + (cols-1)/64] &= ~((uint64_t)1 << ((cols-1) & 63));
+        e[r*words + (cols-1)/64] &= ~((uint64_t)1 << ((cols-1) & 63));
+    }
+
+    /****************************************************************************
+    * Spread the strong pixels along their rows and mark the strips of those
+    * rows and of the rows beside them for the first round.
+    ****************************************************************************/
+    for(r=1; r<rows-1; r++)
+    {
+        for(i=0; i<words && e[r*words + i] == 0; i++);
+        if(i == words) continue;
+        close_row(e + r*words, w + r*words, words);
+        active[(r-1) / BITS_STRIP_ROWS] = 1;
+        active[r / BITS_STRIP_ROWS] = 1;
+        active[(r+1) / BITS_STRIP_ROWS] = 1;
+    }
+
+    /****************************************************************************
+    * Settle the marked strips, a round down the frame and the next one back
+    * up, until none is marked. A strip marked ahead in the round is settled in
+    * the same one.
+    ****************************************************************************/
+    down = 1;
+    do
+    {
+        any = 0;
+        for(i=0; i<strips; i++)
+        {
+            s = down ? i : strips-1-i;
+            if(!active[s]) continue;
+            active[s] = 0;
+            any = 1;
+            first = (s == 0) ? 1 : s*BITS_STRIP_ROWS;
+            last = ((s+1)*BITS_STRIP_ROWS < rows-1) ? (s+1)*BITS_STRIP_ROWS : rows-1;
+            if(first >= last) continue;
+            sides = settle_strip(e, w, words, first, last);
+            if((sides & 1) && s > 0) active[s-1] = 1;
+            if((sides & 2) && s < strips-1) active[s+1] = 1;
+        }
+        down = !down;
+    } while(any);
+
+    /****************************************************************************
+    * Unpack the edges.
+    ****************************************************************************/
+    for(r=0,pos=0; r<rows; r++,pos+=cols)
+    {
+        for(i=0; i<words; i++)
+        {
+            unpack_word(e[r*words + i], edge + pos + i*64, (cols - i*64 < 64) ? cols - i*64 : 64);
+        }
+    }
+
+    free(active);
+    free(w);
+    free(e);
+}
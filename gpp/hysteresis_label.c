@@ -0,0 +1,343 @@
+/*******************************************************************************
+* FILE: hysteresis_label.c
+* Hysteresis by connected component labelling, for HYST_LABEL. The frame is
+* cut into bands of rows, one per thread. Each thread marks the possible edges
+* of its band and histograms their magnitudes; the thresholds come from the sum
+* of the histograms. Each thread then labels the components of the weak pixels
+* of its band, the possible edges above the low threshold, with union-find,
+* noting on every root whether the component holds a strong pixel. The
+* components are merged across the seams between the bands, and every weak
+* pixel of a strong component is an edge. Those are exactly the pixels
+* follow_edges reaches from the strong ones, whatever the order.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define NOEDGE 255
+#define POSSIBLE_EDGE 128
+#define EDGE 0
+
+/* What a weak pixel is marked with; STRONG is or-ed into the root of its component */
+#define WEAK   1
+#define STRONG 2
+
+void hysteresis_thresholds(int *hist, float tlow, float thigh,
+        int *lowthreshold, int *highthreshold);
+
+/* The frame all the bands work on */
+typedef struct
+{
+    short *mag;
+    unsigned char *nms, *edge;
+    int rows, cols;
+    float tlow, thigh;
+    int lowthreshold, highthreshold;
+    int numBands;
+    int *hist;                  /* A histogram of 32768 bins per band */
+    int *maxMag;                /* The largest magnitude in each band */
+    int *count;                 /* The possible edges in each band */
+    int *candidates;            /* Their positions, each band's from its first pixel on */
+    int *parent;                /* Union-find parents of the weak pixels */
+    unsigned char *weak;        /* WEAK, with STRONG on the roots, or 0 */
+    pthread_barrier_t barrier;
+} Label_Frame;
+
+/* A band and its frame */
+typedef struct
+{
+    Label_Frame *frame;
+    int band;
+} Label_Band;
+
+/*******************************************************************************
+* PROCEDURE: find_root
+* PURPOSE: The root of the component of p, halving the path to it.
+*******************************************************************************/
+static int find_root(int *parent, int p)
+{
+    while(parent[p] != p)
+    {
+        parent[p] = parent[parent[p]];
+        p = parent[p];
+    }
+    return p;
+}
+
+/*******************************************************************************
+* PROCEDURE: unite
+* PURPOSE: Join the components of a and b under the smaller root, which then
+* holds a strong pixel if either did.
+*******************************************************************************/
+static void unite(int *parent, unsigned char *weak, int a, int b)
+{
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    if(a == b) return;
+    if(a > b)
+    {
+        parent[a] = b;
+        weak[b] |= weak[a];
+    }
+    else
+    {
+        parent[b] = a;
+        weak[a] |= weak[b];
+    }
+}
+
+/*******************************************************************************
+* PROCEDURE: unite_above
+* PURPOSE: Join the weak pixel p to the weak pixels among its three neighbours
+* in the row above. When the one straight above is weak the diagonal ones are
+* its neighbours, so they are in its component already.
+*******************************************************************************/
+static void unite_above(int *parent, unsigned char *weak, int p, int cols)
+{
+    if(weak[p-cols])
+    {
+        unite(parent, weak, p, p-cols);
+        return;
+    }
+    if(weak[p-cols-1]) unite(parent, weak, p, p-cols-1);
+    if(weak[p-cols+1]) unite(parent, weak, p, p-cols+1);
+}
+
+/*******************************************************************************
+* PROCEDURE: mark_band
+* PURPOSE: Mark the possible edges of band b, the border excepted, list them
+* in frame order and histogram their magnitudes.
+*******************************************************************************/
+static void mark_band(Label_Frame *f, int b, int first, int last)
+{
+    int r, c, pos, m, top = 0, n = 0;
+    int rows = f->rows, cols = f->cols;
+    int *hist = f->hist + b*32768, *list = f->candidates + first*cols;
+
+    memset(hist, 0, 32768*sizeof(int));
+    for(r=first; r<last; r++)
+    {
+        pos = r*cols;
+        if(r == 0 || r == rows-1)
+        {
+            memset(f->edge+pos, NOEDGE, cols);
+            continue;
+        }
+        f->edge[pos] = NOEDGE;
+        for(c=1,pos++; c<cols-1; c++,pos++)
+        {
+            if(f->nms[pos] == POSSIBLE_EDGE)
+            {
+                f->edge[pos] = POSSIBLE_EDGE;
+                list[n++] = pos;
+                m = f->mag[pos];
+                hist[m]++;
+                if(m > top) top = m;
+            }
+            else f->edge[pos] = NOEDGE;
+        }
+        if(cols > 1) f->edge[pos] = NOEDGE;
+    }
+    f->maxMag[b] = top;
+    f->count[b] = n;
+}
+
+/*******************************************************************************
+* PROCEDURE: label_band
+* PURPOSE: Label the weak pixels among the possible edges of band b, rows
+* first to last - 1, joining each to its weak neighbours before it in the band.
+*******************************************************************************/
+static void label_band(Label_Frame *f, int b, int first, int last)
+{
+    int i, pos, top, low = f->lowthreshold, high = f->highthreshold;
+    int cols = f->cols, *parent = f->parent, *list = f->candidates + first*cols;
+    unsigned char *weak = f->weak;
+    short *mag = f->mag;
+
+    /****************************************************************************
+    * Pixels from top on have the row above in the band.
+    ****************************************************************************/
+    top = (first+1) * cols;
+    memset(weak + first*cols, 0, (last-first) * cols);
+    for(i=0; i<f->count[b]; i++)
+    {
+        pos = list[i];
+        if(mag[pos] <= low) continue;
+        weak[pos] = (mag[pos] >= high) ? (WEAK | STRONG) : WEAK;
+        parent[pos] = pos;
+
+        /************************************************************************
+        * The border is never weak, so the neighbours are all in the frame.
+        * The left one is a neighbour of the one above, which joins it.
+        ************************************************************************/
+        if(pos >= top && weak[pos-cols])
+        {
+            unite(parent, weak, pos, pos-cols);
+            continue;
+        }
+        if(weak[pos-1]) unite(parent, weak, pos, pos-1);
+        else if(pos >= top && weak[pos-cols-1]) unite(parent, weak, pos, pos-cols-1);
+        if(pos >= top && weak[pos-cols+1]) unite(parent, weak, pos, pos-cols+1);
+    }
+}
+
+/*******************************************************************************
+* PROCEDURE: merge_seams
+* PURPOSE: Join the components of the bands across the seams between them.
+*******************************************************************************/
+static void merge_seams(Label_Frame *f)
+{
+    int b, r, c, pos;
+
+    for(b=1; b<f->numBands; b++)
+    {
+        r = b * f->rows / f->numBands;
+        if(r < 1 || r >= f->rows-1) continue;
+        for(c=1,pos=r*f->cols+1; c<f->cols-1; c++,pos++)
+        {
+            if(f->weak[pos]) unite_above(f->parent, f->weak, pos, f->cols);
+        }
+    }
+}
+
+/*******************************************************************************
+* PROCEDURE: resolve_band
+* PURPOSE: Write the edges among the possible edges of band b, the others
+* being NOEDGE already: a weak pixel is an edge when its component holds a
+* strong one. When the low threshold is not below the high one every weak
+* pixel is strong and the strong pixels are the edges, some of which are not
+* weak.
+*******************************************************************************/
+static void resolve_band(Label_Frame *f, int b, int first)
+{
+    int i, pos, root, *parent = f->parent, *list = f->candidates + first*f->cols;
+    unsigned char *weak = f->weak, *edge = f->edge;
+
+    if(f->lowthreshold >= f->highthreshold)
+    {
+        for(i=0; i<f->count[b]; i++)
+        {
+            pos = list[i];
+            edge[pos] = (f->mag[pos] >= f->highthreshold) ? EDGE : NOEDGE;
+        }
+        return;
+    }
+    for(i=0; i<f->count[b]; i++)
+    {
+        pos = list[i];
+        if(weak[pos])
+        {
+            for(root=parent[pos]; parent[root] != root; root=parent[root]);
+            edge[pos] = (weak[root] & STRONG) ? EDGE : NOEDGE;
+        }
+        else edge[pos] = NOEDGE;
+    }
+}
+
+/*******************************************************************************
+* PROCEDURE: hysteresis_band
+* PURPOSE: The work of one thread on its band. Band 0, on the calling thread,
+* also does the parts that need all the bands: the thresholds and the seams.
+*******************************************************************************/
+static void *hysteresis_band(void *arg)
+{
+    Label_Band *band = (Label_Band *) arg;
+    Label_Frame *f = band->frame;
+    int b = band->band, first, last, r, i;
+
+    first = b * f->rows / f->numBands;
+    last = (b+1) * f->rows / f->numBands;
+
+    mark_band(f, b, first, last);
+    pthread_barrier_wait(&f->barrier);
+    if(b == 0)
+    {
+        for(i=1; i<f->numBands; i++)
+        {
+            for(r=0; r<=f->maxMag[i]; r++) f->hist[r] += f->hist[i*32768 + r];
+        }
+        hysteresis_thresholds(f->hist, f->tlow, f->thigh, &f->lowthreshold, &f->highthreshold);
+    }
+    pthread_barrier_wait(&f->barrier);
+    if(f->lowthreshold < f->highthreshold)
+    {
+        label_band(f, b, first, last);
+        pthread_barrier_wait(&f->barrier);
+        if(b == 0) merge_seams(f);
+        pthread_barrier_wait(&f->barrier);
+    }
+    resolve_band(f, b, first);
+    return NULL;
+}
+
+/*******************************************************************************
+* PROCEDURE: label_hysteresis
+* PURPOSE: The edges of apply_hysteresis, found by labelling the weak
+* components on threads threads, or one per online processor when it is 0.
+*******************************************************************************/
+void label_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
+                      float tlow, float thigh, unsigned char *edge, int threads)
+{
+    Label_Frame f;
+    Label_Band *bands;
+    pthread_t *ids;
+    int b;
+
+    if(threads <= 0) threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if(threads > rows) threads = rows;
+    if(threads < 1) threads = 1;
+
+    f.mag = mag;
+    f.nms = nms;
+    f.edge = edge;
+    f.rows = rows;
+    f.cols = cols;
+    f.tlow = tlow;
+    f.thigh = thigh;
+    f.numBands = threads;
+    f.hist = (int *) malloc(threads * 32768 * sizeof(int));
+    f.maxMag = (int *) malloc(threads * sizeof(int));
+    f.count = (int *) malloc(threads * sizeof(int));
+    f.candidates = (int *) malloc(rows * cols * sizeof(int));
+    f.parent = (int *) malloc(rows * cols * sizeof(int));
+    f.weak = (unsigned char *) malloc(rows * cols);
+    bands = (Label_Band *) malloc(threads * sizeof(Label_Band));
+    ids = (pthread_t *) malloc(threads * sizeof(pthread_t));
+    if(f.hist == NULL || f.maxMag == NULL || f.count == NULL || f.candidates == NULL
+       || f.parent == NULL || f.weak == NULL
+       || bands == NULL || ids == NULL)
+    {
+        fprintf(stderr, "Error allocating the hysteresis labels.\n");
+        exit(1);
+    }
+    pthread_barrier_init(&f.barrier, NULL, threads);
+
+    for(b=0; b<threads; b++)
+    {
+        bands[b].frame = &f;
+        bands[b].band = b;
+    }
+    for(b=1; b<threads; b++)
+    {
+        if(pthread_create(&ids[b], NULL, hysteresis_band, &bands[b]) != 0)
+        {
+            fprintf(stderr, "Error starting a hysteresis thread.\n");
+            exit(1);
+        }
+    }
+    hysteresis_band(&bands[0]);
+    for(b=1; b<threads; b++) pthread_join(ids[b], NULL);
+
+    pthread_barrier_destroy(&f.barrier);
+    free(ids);
+    free(bands);
+    free(f.weak);
+    free(f.parent);
+    free(f.candidates);
+    free(f.count);
+    free(f.maxMag);
+    free(f.hist);
+}
@@ -0,0 +1,191 @@
+/*******************************************************************************
+* FILE: ipc_bench.c
+* Microbenchmark of the GPP - DSP transport pool_notify is built on: the round
+* trip of a command notification, and the cache maintenance on both sides and
+* the GPP copy as a function of the payload size. Every measurement is repeated
+* and reported as percentiles, so the cost of offloading a small frame to the
+* DSP can be read off directly.
+*
+* USAGE: ipc_bench [-n iterations] [-m max_bytes] [dsp_executable]
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+/*  ----------------------------------- DSP/BIOS Link                 */
+#include <dsplink.h>
+/*  ----------------------------------- Application Header            */
+#include <pool_notify.h>
+#include "bench_util.h"
+
+#define MIN_SIZE 64          /* Smallest payload, the sizes double up to the largest */
+#define MAX_SIZES 32
+
+/* Median of each measurement per payload size, for the frame overhead table */
+static double rttMedian;
+static double gppWbMedian[MAX_SIZES], gppInvMedian[MAX_SIZES];
+static double dspInvMedian[MAX_SIZES], dspWbMedian[MAX_SIZES];
+
+/*******************************************************************************
+* PROCEDURE: report
+* PURPOSE: Sort the n samples of t, in microseconds, print their percentiles
+* and the bandwidth at the median, and return the median.
+*******************************************************************************/
+static double report(const char *what, Uint32 size, double *t, int n)
+{
+    double p50;
+
+    bench_sort(t, n);
+    p50 = bench_percentile(t, n, 50);
+    printf("%-12s %9u %9.1f %9.1f %9.1f %9.1f %9.1f", what, (unsigned)size,
+           t[0], p50, bench_percentile(t, n, 90), bench_percentile(t, n, 99), t[n-1]);
+    if(size > 0 && p50 > 0) printf(" %9.1f\n", size / p50);
+    else printf(" %9s\n", "-");
+    return p50;
+}
+
+/* Round trip of a CMD_BENCH command, in microseconds */
+static double dsp_round_trip(Uint32 steps, Uint32 size)
+{
+    double start = bench_now_us();
+
+    if(!pool_notify_bench(steps, size, ID_PROCESSOR))
+    {
+        fprintf(stderr, "The DSP failed a benchmark command.\n");
+        exit(1);
+    }
+    return bench_now_us() - start;
+}
+
+/*******************************************************************************
+* PROCEDURE: bench_size
+* PURPOSE: Measure the GPP copy, writeback and invalidate and the DSP
+* invalidate and writeback of size bytes. The DSP times are net of the median
+* round trip of a command that does nothing, the DSP writeback also of the
+* median time of writing the bytes on the DSP.
+*******************************************************************************/
+static void bench_size(int k, Uint32 size, Uint8 *buf, Uint8 *src, double *t, int n)
+{
+    double start, fill;
+    volatile Uint32 sum = 0;
+    Uint32 j;
+    int i;
+
+    for(i = 0; i < n; i++)
+    {
+        start = bench_now_us();
+        memcpy(buf, src, size);
+        t[i] = bench_now_us() - start;
+    }
+    report("gpp_copy", size, t, n);
+
+    for(i = 0; i < n; i++)
+    {
+        memset(buf, i, size); /* Every line dirty, as after a copy */
+        start = bench_now_us();
+        pool_notify_writeback(buf, size, ID_PROCESSOR);
+        t[i] = bench_now_us() - start;
+    }
+    gppWbMedian[k] = report("gpp_wb", size, t, n);
+
+    for(i = 0; i < n; i++)
+    {
+        for(j = 0; j < size; j += 32) sum += buf[j]; /* Every line cached */
+        start = bench_now_us();
+        pool_notify_invalidate(buf, size, ID_PROCESSOR);
+        t[i] = bench_now_us() - start;
+    }
+    gppInvMedian[k] = report("gpp_inv", size, t, n);
+
+    for(i = 0; i < n; i++)
+    {
+        t[i] = dsp_round_trip(CMD_BENCH_INV, size) - rttMedian;
+        if(t[i] < 0) t[i] = 0;
+    }
+    dspInvMedian[k] = report("dsp_inv", size, t, n);
+
+    for(i = 0; i < n; i++) t[i] = dsp_round_trip(CMD_BENCH_FILL, size);
+    bench_sort(t, n);
+    fill = bench_percentile(t, n, 50);
+    for(i = 0; i < n; i++)
+    {
+        t[i] = dsp_round_trip(CMD_BENCH_FILL | CMD_BENCH_WB, size) - fill;
+        if(t[i] < 0) t[i] = 0;
+    }
+    dspWbMedian[k] = report("dsp_wb", size, t, n);
+    /* The DSP wrote the buffer, drop the stale GPP lines before the next size */
+    pool_notify_invalidate(buf, size, ID_PROCESSOR);
+}
+
+int main(int argc, char *argv[])
+{
+    char *dspExecutable = "pool_notify.out";
+    char strBufferSize[32];
+    int n = 200;
+    Uint32 maxSize = MEM_SIZE, bufSize, size, sizes[MAX_SIZES];
+    int numSizes = 0, opt, i, k;
+    Uint8 *buf, *src;
+    double *t, overhead;
+
+    while((opt = getopt(argc, argv, "n:m:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': n = atoi(optarg); break;
+            case 'm': maxSize = (Uint32) strtoul(optarg, NULL, 0); break;
+            default: n = 0; break;
+        }
+    }
+    if(n <= 0 || maxSize < MIN_SIZE || argc - optind > 1)
+    {
+        fprintf(stderr,"\n<USAGE> %s [-n iterations] [-m max_bytes] [dsp_executable]\n",argv[0]);
+        fprintf(stderr,"\n      -n:  Repetitions of every measurement (200).\n");
+        fprintf(stderr,"      -m:  Largest payload in bytes (%d).\n", MEM_SIZE);
+        exit(1);
+    }
+    if(optind < argc) dspExecutable = argv[optind];
+
+    for(size = MIN_SIZE; size < maxSize && numSizes < MAX_SIZES-1; size *= 2) sizes[numSizes++] = size;
+    sizes[numSizes++] = maxSize;
+    if((t = (double *) malloc(n*sizeof(double))) == NULL || (src = (Uint8 *) malloc(maxSize)) == NULL)
+    {
+        fprintf(stderr, "Error allocating the benchmark buffers.\n");
+        exit(1);
+    }
+    memset(src, 0x5A, maxSize);
+
+    sprintf(strBufferSize, "%u", (unsigned) maxSize);
+    pool_notify_Main(dspExecutable, strBufferSize, 1, 1);
+    buf = pool_notify_benchBuffer(&bufSize);
+    if(bufSize < maxSize)
+    {
+        fprintf(stderr, "The data buffer holds only %u bytes.\n", (unsigned) bufSize);
+        exit(1);
+    }
+
+    printf("%d samples per line, times in usec, bandwidth in MB/s at the median\n", n);
+    printf("%-12s %9s %9s %9s %9s %9s %9s %9s\n", "op", "bytes", "min", "p50", "p90", "p99", "max", "MB/s");
+    for(i = 0; i < n; i++) t[i] = dsp_round_trip(0, 0);
+    rttMedian = report("notify_rtt", 0, t, n);
+    for(k = 0; k < numSizes; k++) bench_size(k, sizes[k], buf, src, t, n);
+
+    /****************************************************************************
+    * What moving a frame of the size costs on top of the DSP smoothing it: a
+    * command round trip, the image (size bytes) written back by the GPP and
+    * invalidated by the DSP, the result (twice the size) written back by the
+    * DSP and invalidated by the GPP.
+    ****************************************************************************/
+    printf("\n%-12s %9s %9s\n", "frame", "bytes", "p50 usec");
+    for(k = 0; k + 1 < numSizes && sizes[k+1] == 2*sizes[k]; k++)
+    {
+        overhead = rttMedian + gppWbMedian[k] + dspInvMedian[k] + dspWbMedian[k+1] + gppInvMedian[k+1];
+        printf("%-12s %9u %9.1f\n", "transport", (unsigned) sizes[k], overhead);
+    }
+
+    pool_notify_Delete(ID_PROCESSOR);
+    free(src);
+    free(t);
+    return 0;
+}
@@ -0,0 +1,306 @@
+/*******************************************************************************
+* FILE: mag_bench.c
+* Benchmark of the magnitude of the gradient on the GPP, and of what its modes
+* do to the edges. Random derivative frames get their magnitude from the float
+* magnitude_x_y_reference() and from magnitude_x_y() in every mode; MAG_EXACT
+* must agree with the float version, and the table gives the times and the
+* speedups over it. Then the images given, or a synthetic scene without any,
+* are smoothed, suppressed and thresholded as canny_edge does with every mode,
+* and the edges each approximation adds to or removes from the exact edge map
+* are counted. Runs without the DSP.
+*
+* USAGE: mag_bench [-n iterations] [-c] [image.pgm ...]
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <stdint.h>
+#include "magnitude.h"
+#include "derivative.h"
+#include "smooth.h"
+#include "bench_util.h"
+
+int read_pgm_image(char *infilename, unsigned char **image, int *rows, int *cols);
+void gradient_nms(uint16_t *smoothedim, int rows, int cols, short *mag,
+                  unsigned char *result);
+void apply_hysteresis(short int *mag, unsigned char *nms, int rows, int cols,
+                      float tlow, float thigh, unsigned char *edge);
+
+/* The smoothed image is scaled by 90 (BOOSTBLURFACTOR) */
+#define SMOOTHED_MAX (255*90)
+
+/* The defaults of canny_edge */
+#define SIGMA 2.5
+#define TLOW  0.5
+#define THIGH 0.5
+
+#define EDGE 0
+
+/* Size of the synthetic scene */
+#define SCENE_ROWS 480
+#define SCENE_COLS 640
+
+/*******************************************************************************
+* PROCEDURE: same_magnitude
+* PURPOSE: Compute the magnitude of n pixels with MAG_EXACT and with the float
+* version and compare them. Returns 1 when they agree.
+*******************************************************************************/
+static int same_magnitude(short *dx, short *dy, int n, short *mag, short *ref)
+{
+    int i;
+
+    magnitudeMode = MAG_EXACT;
+    magnitude_x_y(dx, dy, 1, n, mag);
+    magnitude_x_y_reference(dx, dy, 1, n, ref);
+    for(i = 0; i < n; i++)
+    {
+        if(mag[i] != ref[i])
+        {
+            fprintf(stderr, "The magnitude of (%d, %d) is %d, not %d.\n", dx[i], dy[i], mag[i], ref[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*******************************************************************************
+* PROCEDURE: magnitude_times
+* PURPOSE: Compute the magnitude of the frame n times with f and store the
+* times, in microseconds, in t. Returns the median.
+*******************************************************************************/
+static double magnitude_times(void (*f)(short *, short *, int, int, short *),
+                              short *dx, short *dy, int rows, int cols,
+                              short *mag, double *t, int n)
+{
+    double start;
+    int i;
+
+    for(i = 0; i < n; i++)
+    {
+        start = bench_now_us();
+        f(dx, dy, rows, cols, mag);
+        t[i] = bench_now_us() - start;
+    }
+    bench_sort(t, n);
+    return bench_percentile(t, n, 50);
+}
+
+/*******************************************************************************
+* PROCEDURE: make_scene
+* PURPOSE: A synthetic image with edges of every orientation and contrast:
+* discs and a tilted bar of several gray levels on a shaded, noisy background.
+*******************************************************************************/
+static unsigned char *make_scene(int rows, int cols)
+{
+    unsigned char *image;
+    int r, c, v, k;
+    double x, y, u;
+
+    if((image = (unsigned char *) malloc(rows*cols)) == NULL) return NULL;
+    srand(7);
+    for(r = 0; r < rows; r++)
+    {
+        for(c = 0; c < cols; c++)
+        {
+            v = 40 + (100 * c) / cols + (rand() % 21) - 10;
+            for(k = 0; k < 4; k++)
+            {
+                x = c - cols * (k + 1) / 5.0;
+                y = r - rows * ((k & 1) ? 0.35 : 0.65);
+                if(x*x + y*y < (rows / 8.0) * (rows / 8.0)) v = 60 + 45 * k;
+            }
+            u = (c - cols / 2.0) * 0.8 + (r - rows / 2.0) * 0.6;
+            if(fabs(u) < rows / 20.0) v -= 30;
+            image[r*cols+c] = (unsigned char)((v < 0) ? 0 : (v > 255) ? 255 : v);
+        }
+    }
+    return image;
+}
+
+/*******************************************************************************
+* PROCEDURE: edge_changes
+* PURPOSE: Find the edges of the image with every magnitude mode and report
+* how many of the edges of MAG_EXACT the others move.
+*******************************************************************************/
+static int edge_changes(const char *name, unsigned char *image, int rows, int cols,
+                        uint16_t *kernel, int windowsize)
+{
+    uint16_t *smoothed;
+    short *mag;
+    unsigned char *nms, *edge[MAG_NUM_MODES];
+    int mode, i, edges, added, removed;
+
+    smoothed = (uint16_t *) malloc(rows*cols*sizeof(uint16_t));
+    mag = (short *) malloc(rows*cols*sizeof(short));
+    nms = (unsigned char *) malloc(rows*cols);
+    edge[0] = (unsigned char *) malloc(MAG_NUM_MODES*rows*cols);
+    if(smoothed == NULL || mag == NULL || nms == NULL || edge[0] == NULL
+       || !gaussian_smooth_gpp(image, rows, cols, kernel, windowsize, smoothed, 0, rows))
+    {
+        fprintf(stderr, "Error allocating the buffers for %s.\n", name);
+        return 0;
+    }
+
+    for(mode = 0; mode < MAG_NUM_MODES; mode++)
+    {
+        edge[mode] = edge[0] + mode*rows*cols;
+        magnitudeMode = mode;
+        gradient_nms(smoothed, rows, cols, mag, nms);
+        apply_hysteresis(mag, nms, rows, cols, TLOW, THIGH, edge[mode]);
+    }
+    magnitudeMode = MAG_EXACT;
+
+    for(edges = 0, i = 0; i < rows*cols; i++) edges += (edge[MAG_EXACT][i] == EDGE);
+    for(mode = 0; mode < MAG_NUM_MODES; mode++)
+    {
+        for(added = 0, removed = 0, i = 0; i < rows*cols; i++)
+        {
+            added += (edge[mode][i] == EDGE && edge[MAG_EXACT][i] != EDGE);
+            removed += (edge[mode][i] != EDGE && edge[MAG_EXACT][i] == EDGE);
+        }
+        printf("%-24s %-6s %9d %9d %9d", name, magnitude_mode_name(mode), edges + added - removed,
+               added, removed);
+        if(edges > 0) printf(" %8.2f%%\n", 100.0 * (added + removed) / edges);
+        else printf(" %9s\n", "-");
+    }
+
+    free(edge[0]);
+    free(nms);
+    free(mag);
+    free(smoothed);
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    int n = 50, checkOnly = 0, opt, i, k, mode, rows, cols, windowsize;
+    short *dx, *dy, *mag, *ref;
+    unsigned char *image;
+    uint16_t *smoothed, *kernel;
+    double *t, byFloat, byMode;
+    size_t pixels;
+
+    while((opt = getopt(argc, argv, "n:c")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': n = atoi(optarg); break;
+            case 'c': checkOnly = 1; break;
+            default: n = 0; break;
+        }
+    }
+    if(n <= 0)
+    {
+        fprintf(stderr,"\n<USAGE> %s [-n iterations] [-c] [image.pgm ...]\n",argv[0]);
+        fprintf(stderr,"\n      -n:  Repetitions of every measurement (50).\n");
+        fprintf(stderr,"      -c:  Only check that the exact mode agrees with the float version.\n");
+        fprintf(stderr,"      image.pgm:  Images to find the edges of, a synthetic scene without any.\n");
+        exit(1);
+    }
+
+    pixels = (size_t) benchRows[BENCH_NUM_SIZES-1] * benchCols[BENCH_NUM_SIZES-1];
+    smoothed = (uint16_t *) malloc(pixels*sizeof(uint16_t));
+    mag = (short *) malloc(pixels*sizeof(short));
+    ref = (short *) malloc(pixels*sizeof(short));
+    t = (double *) malloc(n*sizeof(double));
+    if(smoothed == NULL || mag == NULL || ref == NULL || t == NULL)
+    {
+        fprintf(stderr, "Error allocating the benchmark buffers.\n");
+        exit(1);
+    }
+
+    /****************************************************************************
+    * Every dx the smoothed image can give against a sweep of dy, both signs,
+    * then the derivatives of a random smoothed frame.
+    ****************************************************************************/
+    dx = (short *) malloc(2*(SMOOTHED_MAX+1)*sizeof(short));
+    dy = (short *) malloc(2*(SMOOTHED_MAX+1)*sizeof(short));
+    if(dx == NULL || dy == NULL)
+    {
+        fprintf(stderr, "Error allocating the benchmark buffers.\n");
+        exit(1);
+    }
+    for(k = 0; k <= SMOOTHED_MAX; k += 97)
+    {
+        for(i = 0; i <= SMOOTHED_MAX; i++)
+        {
+            dx[2*i] = i;
+            dx[2*i+1] = -i;
+            dy[2*i] = dy[2*i+1] = (i & 1) ? -k : k;
+        }
+        if(!same_magnitude(dx, dy, 2*(SMOOTHED_MAX+1), mag, ref)) exit(1);
+    }
+    free(dx);
+    free(dy);
+
+    srand(1);
+    for(i = 0; i < (int)pixels; i++) smoothed[i] = (uint16_t)(rand() % (SMOOTHED_MAX + 1));
+    rows = benchRows[BENCH_NUM_SIZES-1];
+    cols = benchCols[BENCH_NUM_SIZES-1];
+    derrivative_x_y(smoothed, rows, cols, &dx, &dy);
+    if(!same_magnitude(dx, dy, rows*cols, mag, ref)) exit(1);
+    printf("The exact magnitude agrees with the float version.\n");
+    if(checkOnly) return 0;
+
+    /****************************************************************************
+    * Time the float version and every mode on the same derivatives.
+    ****************************************************************************/
+    printf("%d samples per line, times in usec\n", n);
+    printf("%-9s %11s %9s %9s %9s %9s %9s %9s\n", "mode", "frame", "min", "p50", "p90", "max",
+           "Mpix/s", "speedup");
+    for(k = 0; k < BENCH_NUM_SIZES; k++)
+    {
+        rows = benchRows[k];
+        cols = benchCols[k];
+        byFloat = magnitude_times(magnitude_x_y_reference, dx, dy, rows, cols, ref, t, n);
+        bench_report("float", rows, cols, t, n);
+        printf("\n");
+        for(mode = 0; mode < MAG_NUM_MODES; mode++)
+        {
+            magnitudeMode = mode;
+            byMode = magnitude_times(magnitude_x_y, dx, dy, rows, cols, mag, t, n);
+            bench_report(magnitude_mode_name(mode), rows, cols, t, n);
+            if(byMode > 0) printf(" %8.2fx\n", byFloat / byMode);
+            else printf(" %9s\n", "-");
+        }
+    }
+    magnitudeMode = MAG_EXACT;
+    free(dx);
+    free(dy);
+
+    /****************************************************************************
+    * What the approximations do to the edges.
+    ****************************************************************************/
+    make_gaussian_kernel(SIGMA, &kernel, &windowsize);
+    printf("\nEdges with sigma %.1f, tlow %.1f and thigh %.1f, against the exact mode\n",
+           SIGMA, TLOW, THIGH);
+    printf("%-24s %-6s %9s %9s %9s %9s\n", "image", "mode", "edges", "added", "removed", "changed");
+    if(optind == argc)
+    {
+        if((image = make_scene(SCENE_ROWS, SCENE_COLS)) == NULL
+           || !edge_changes("synthetic", image, SCENE_ROWS, SCENE_COLS, kernel, windowsize))
+        {
+            exit(1);
+        }
+        free(image);
+    }
+    for(i = optind; i < argc; i++)
+    {
+        if(read_pgm_image(argv[i], &image, &rows, &cols) == 0
+           || !edge_changes(argv[i], image, rows, cols, kernel, windowsize))
+        {
+            exit(1);
+        }
+        free(image);
+    }
+
+    free(kernel);
+    free(t);
+    free(ref);
+    free(mag);
+    free(smoothed);
+    return 0;
+}
@@ -0,0 +1,294 @@
+/*******************************************************************************
+* FILE: magnitude.c
+* Magnitude of the gradient on the GPP, in integers, with NEON on the board and
+* SSE2 on the host build. MAG_EXACT gives exactly the values of the float
+* version, magnitude_x_y_reference(); MAG_L1 and MAG_AMBM approximate them
+* with no square root at all. magnitudeMode selects one at run time.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+/* ----------------------Arm Neon Library for SIMD registers and instructions */
+#if defined (__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "magnitude.h"
+
+/* alpha max + beta min with alpha = 246/256 and beta = 102/256, within 4% of
+ * the Euclidean magnitude */
+#define AMBM_ALPHA 246
+#define AMBM_BETA  102
+#define AMBM_SHIFT 8
+
+#define MAG_MAX 32767
+
+int magnitudeMode = MAG_EXACT;
+
+static const char *modeNames[MAG_NUM_MODES] = {"exact", "l1", "ambm"};
+
+/*******************************************************************************
+* PROCEDURE: magnitude_mode
+* PURPOSE: The mode called name, or -1 when there is none.
+*******************************************************************************/
+int magnitude_mode(const char *name)
+{
+    int mode;
+
+    for(mode=0; mode<MAG_NUM_MODES; mode++)
+    {
+        if(strcmp(name, modeNames[mode]) == 0) return mode;
+    }
+    return -1;
+}
+
+const char *magnitude_mode_name(int mode)
+{
+    return (mode >= 0 && mode < MAG_NUM_MODES) ? modeNames[mode] : NULL;
+}
+
+/*******************************************************************************
+* PROCEDURE: round_float
+* PURPOSE: x rounded to the 24 bit significand of a float, ties to even, as
+* the conversion to float rounds it.
+*******************************************************************************/
+static uint32_t round_float(uint32_t x)
+{
+    int s = 0;
+    uint32_t rem, half;
+
+    while((x >> s) >= (1u << 24)) s++;
+    if(s == 0) return x;
+    rem = x & ((1u << s) - 1);
+    half = 1u << (s - 1);
+    x >>= s;
+    if(rem > half || (rem == half && (x & 1))) x++;
+    return x << s;
+}
+
+/*******************************************************************************
+* PROCEDURE: round_sqrt
+* PURPOSE: The square root of n rounded to the nearest integer, computed bit by
+* bit. n can not be k*k + k exactly between two roots, so no ties.
+*******************************************************************************/
+static uint32_t round_sqrt(uint32_t n)
+{
+    uint32_t root = 0, bit = 1u << 30, rem = n;
+
+    while(bit > n) bit >>= 2;
+    while(bit != 0)
+    {
+        if(rem >= root + bit)
+        {
+            rem -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else root >>= 1;
+        bit >>= 2;
+    }
+    /* root = floor(sqrt(n)), rem = n - root*root */
+    return root + (rem > root);
+}
+
+static uint32_t abs_sat(short d)
+{
+    return (d < 0) ? ((d == -32768) ? MAG_MAX : -d) : d;
+}
+
+/*******************************************************************************
+* PROCEDURE: magnitude_pixel
+* PURPOSE: The magnitude of one pixel. In MAG_EXACT the squares and their sum
+* are rounded the way the float version rounds them, which matters from 2^24
+* on, so the rounded integer square root is the same.
+*******************************************************************************/
+static short magnitude_pixel(short dx, short dy, int mode)
+{
+    uint32_t ax, ay, m;
+
+    if(mode == MAG_EXACT)
+    {
+        ax = (uint32_t)((int)dx * (int)dx);
+        ay = (uint32_t)((int)dy * (int)dy);
+        m = round_sqrt(round_float(round_float(ax) + round_float(ay)));
+        return (short)((m > MAG_MAX) ? MAG_MAX : m);
+    }
+    ax = abs_sat(dx);
+    ay = abs_sat(dy);
+    if(mode == MAG_L1) m = ax + ay;
+    else
+    {
+        m = (ax > ay) ? AMBM_ALPHA*ax + AMBM_BETA*ay : AMBM_ALPHA*ay + AMBM_BETA*ax;
+        m = (m + (1 << (AMBM_SHIFT-1))) >> AMBM_SHIFT;
+    }
+    return (short)((m > MAG_MAX) ? MAG_MAX : m);
+}
+
+#if defined (__ARM_NEON__)
+/*******************************************************************************
+* PROCEDURE: exact_neon
+* PURPOSE: MAG_EXACT of four lanes. The sum of the squares is formed in float,
+* as the float version forms it; its square root from two Newton steps of the
+* reciprocal estimate is off by at most one and is corrected against the
+* integer sum, so the result is exact.
+*******************************************************************************/
+static inline int16x4_t exact_neon(int16x4_t dx, int16x4_t dy)
+{
+    uint32x4_t one = vdupq_n_u32(1), n, k;
+    float32x4_t v, vm, e;
+
+    v = vaddq_f32(vcvtq_f32_s32(vmull_s16(dx, dx)), vcvtq_f32_s32(vmull_s16(dy, dy)));
+    n = vcvtq_u32_f32(v);
+    vm = vmaxq_f32(v, vdupq_n_f32(1.0f));
+    e = vrsqrteq_f32(vm);
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(vm, e), e));
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(vm, e), e));
+    k = vcvtq_u32_f32(vaddq_f32(vmulq_f32(v, e), vdupq_n_f32(0.5f)));
+
+    /* k*(k+1) < n: one too small. k*(k-1) >= n and k > 0: one too large. */
+    k = vaddq_u32(k, vandq_u32(vcltq_u32(vmulq_u32(k, vaddq_u32(k, one)), n), one));
+    k = vsubq_u32(k, vandq_u32(vandq_u32(vcgeq_u32(vmulq_u32(k, vsubq_u32(k, one)), n),
+                                         vcgtq_u32(k, vdupq_n_u32(0))), one));
+    return vreinterpret_s16_u16(vmovn_u32(k));
+}
+
+/*******************************************************************************
+* PROCEDURE: magnitude_neon
+* PURPOSE: The magnitude of eight pixels.
+*******************************************************************************/
+static inline int16x8_t magnitude_neon(int16x8_t dx, int16x8_t dy, int mode)
+{
+    int16x8_t ax, ay, mx, mn;
+    int32x4_t lo, hi;
+
+    if(mode == MAG_EXACT)
+    {
+        return vcombine_s16(exact_neon(vget_low_s16(dx), vget_low_s16(dy)),
+                            exact_neon(vget_high_s16(dx), vget_high_s16(dy)));
+    }
+    ax = vqabsq_s16(dx);
+    ay = vqabsq_s16(dy);
+    if(mode == MAG_L1) return vqaddq_s16(ax, ay);
+    mx = vmaxq_s16(ax, ay);
+    mn = vminq_s16(ax, ay);
+    lo = vmull_n_s16(vget_low_s16(mx), AMBM_ALPHA);
+    hi = vmull_n_s16(vget_high_s16(mx), AMBM_ALPHA);
+    lo = vmlal_n_s16(lo, vget_low_s16(mn), AMBM_BETA);
+    hi = vmlal_n_s16(hi, vget_high_s16(mn), AMBM_BETA);
+    return vcombine_s16(vqrshrn_n_s32(lo, AMBM_SHIFT), vqrshrn_n_s32(hi, AMBM_SHIFT));
+}
+#elif defined (__SSE2__)
+/* The low 32 bits of the products of the four lanes */
+static inline __m128i mullo_epi32(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+/*******************************************************************************
+* PROCEDURE: exact_sse2
+* PURPOSE: MAG_EXACT of four lanes, from their squares sq1 and sq2. The float
+* square root of the sum of the squares is rounded and corrected against the
+* integer sum as on NEON.
+*******************************************************************************/
+static inline __m128i exact_sse2(__m128i sq1, __m128i sq2)
+{
+    __m128i one = _mm_set1_epi32(1), n, k;
+    __m128 v;
+
+    v = _mm_add_ps(_mm_cvtepi32_ps(sq1), _mm_cvtepi32_ps(sq2));
+    n = _mm_cvttps_epi32(v);
+    k = _mm_cvttps_epi32(_mm_add_ps(_mm_sqrt_ps(v), _mm_set1_ps(0.5f)));
+
+    /* k*(k+1) < n: one too small. k*(k-1) >= n and k > 0: one too large. */
+    k = _mm_sub_epi32(k, _mm_cmplt_epi32(mullo_epi32(k, _mm_add_epi32(k, one)), n));
+    k = _mm_add_epi32(k, _mm_andnot_si128(_mm_cmplt_epi32(mullo_epi32(k, _mm_sub_epi32(k, one)), n),
+                                          _mm_cmpgt_epi32(k, _mm_setzero_si128())));
+    return k;
+}
+
+/*******************************************************************************
+* PROCEDURE: magnitude_sse2
+* PURPOSE: The magnitude of eight pixels.
+*******************************************************************************/
+static inline __m128i magnitude_sse2(__m128i dx, __m128i dy, int mode)
+{
+    __m128i zero = _mm_setzero_si128(), lo, hi, ax, ay, mx, mn, w, r;
+
+    if(mode == MAG_EXACT)
+    {
+        lo = _mm_mullo_epi16(dx, dx);
+        hi = _mm_mulhi_epi16(dx, dx);
+        ax = _mm_unpacklo_epi16(lo, hi);
+        ay = _mm_unpackhi_epi16(lo, hi);
+        lo = _mm_mullo_epi16(dy, dy);
+        hi = _mm_mulhi_epi16(dy, dy);
+        return _mm_packs_epi32(exact_sse2(ax, _mm_unpacklo_epi16(lo, hi)),
+                               exact_sse2(ay, _mm_unpackhi_epi16(lo, hi)));
+    }
+    ax = _mm_max_epi16(dx, _mm_subs_epi16(zero, dx));
+    ay = _mm_max_epi16(dy, _mm_subs_epi16(zero, dy));
+    if(mode == MAG_L1) return _mm_adds_epi16(ax, ay);
+    mx = _mm_max_epi16(ax, ay);
+    mn = _mm_min_epi16(ax, ay);
+    w = _mm_set1_epi32((AMBM_BETA << 16) | AMBM_ALPHA);
+    r = _mm_set1_epi32(1 << (AMBM_SHIFT-1));
+    lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(mx, mn), w), r), AMBM_SHIFT);
+    hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(mx, mn), w), r), AMBM_SHIFT);
+    return _mm_packs_epi32(lo, hi);
+}
+#endif
+
+/*******************************************************************************
+* PROCEDURE: magnitude_x_y
+* PURPOSE: Compute the magnitude of the gradient in the mode magnitudeMode.
+*******************************************************************************/
+void magnitude_x_y(short int *delta_x, short int *delta_y, int rows, int cols,
+                   short int *magnitude)
+{
+    int pos = 0, n = rows*cols, mode = magnitudeMode;
+
+#if defined (__ARM_NEON__)
+    for(; pos+8<=n; pos+=8)
+    {
+        vst1q_s16(magnitude+pos, magnitude_neon(vld1q_s16(delta_x+pos), vld1q_s16(delta_y+pos), mode));
+    }
+#elif defined (__SSE2__)
+    for(; pos+8<=n; pos+=8)
+    {
+        _mm_storeu_si128((__m128i *)(magnitude+pos),
+                         magnitude_sse2(_mm_loadu_si128((__m128i *)(delta_x+pos)),
+                                        _mm_loadu_si128((__m128i *)(delta_y+pos)), mode));
+    }
+#endif
+    for(; pos<n; pos++) magnitude[pos] = magnitude_pixel(delta_x[pos], delta_y[pos], mode);
+}
+
+/*******************************************************************************
+* PROCEDURE: magnitude_x_y_reference
+* PURPOSE: Compute the magnitude of the gradient. This is the square root of
+* the sum of the squared derivative values.
+* NAME: Mike Heath
+* DATE: 2/15/96
+*******************************************************************************/
+void magnitude_x_y_reference(short int *delta_x, short int *delta_y, int rows,
+                             int cols, short int *magnitude)
+{
+    int r, c, pos, sq1, sq2;
+
+    for(r=0,pos=0; r<rows; r++)
+    {
+        for(c=0; c<cols; c++,pos++)
+        {
+            sq1 = (int)delta_x[pos] * (int)delta_x[pos];
+            sq2 = (int)delta_y[pos] * (int)delta_y[pos];
+            magnitude[pos] = (short)(0.5 + sqrt((float)sq1 + (float)sq2));
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef MAGNITUDE_H
+#define MAGNITUDE_H
+
+/* Ways of computing the magnitude of the gradient, see magnitude.c */
+#define MAG_EXACT     0     /* (short)(0.5 + sqrt((float)dx*dx + (float)dy*dy)) */
+#define MAG_L1        1     /* |dx| + |dy| */
+#define MAG_AMBM      2     /* alpha max(|dx|,|dy|) + beta min(|dx|,|dy|) */
+#define MAG_NUM_MODES 3
+
+/* The mode magnitude_x_y() uses, MAG_EXACT unless changed */
+extern int magnitudeMode;
+
+int magnitude_mode(const char *name);
+const char *magnitude_mode_name(int mode);
+void magnitude_x_y(short int *delta_x, short int *delta_y, int rows, int cols,
+                   short int *magnitude);
+void magnitude_x_y_reference(short int *delta_x, short int *delta_y, int rows,
+                             int cols, short int *magnitude);
+
+#endif
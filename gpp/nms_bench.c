@@ -0,0 +1,283 @@
+/*******************************************************************************
+* FILE: nms_bench.c
+* Benchmark and check of the non-maximal suppression on the GPP: the integer
+* non_max_supp(), which canny_edge uses, against the float
+* non_max_supp_reference() it replaced. Both must give the same map for random
+* and smooth frames, with the magnitude of every mode, with zeros in the
+* magnitude so that pixels reuse the derivatives of earlier ones, and for a
+* sweep of small sizes, and the signs of the interpolation near ties must be
+* the float ones; the table gives their times and the speedup. Runs
+* without the DSP.
+*
+* USAGE: nms_bench [-n iterations] [-c]
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <stdint.h>
+#include "magnitude.h"
+#include "derivative.h"
+#include "hysteresis.h"
+#include "bench_util.h"
+
+void non_max_supp(short *mag, short *gradx, short *grady, int nrows, int ncols,
+        unsigned char *result);
+void non_max_supp_reference(short *mag, short *gradx, short *grady, int nrows, int ncols,
+        unsigned char *result);
+
+/* The smoothed image is scaled by 90 (BOOSTBLURFACTOR) */
+#define SMOOTHED_MAX (255*90)
+
+/* Sizes up to this are all checked */
+#define CHECK_MAX 24
+
+/* Near ties on which nms_sign is checked */
+#define SIGN_CHECKS 4000000
+
+/*******************************************************************************
+* PROCEDURE: make_smooth
+* PURPOSE: A smoothed frame with gradients of every direction and strength,
+* and a little noise, like the ones the Gaussian gives.
+*******************************************************************************/
+static void make_smooth(uint16_t *smoothed, int rows, int cols)
+{
+    int r, c;
+    double v;
+
+    for(r = 0; r < rows; r++)
+    {
+        for(c = 0; c < cols; c++)
+        {
+            v = SMOOTHED_MAX / 2 + SMOOTHED_MAX / 4 * (sin(c / 17.0) * cos(r / 23.0)
+                + sin((c + r) / 41.0)) + rand() % 5;
+            smoothed[r*cols+c] = (uint16_t)((v < 0) ? 0 : (v > SMOOTHED_MAX) ? SMOOTHED_MAX : v);
+        }
+    }
+}
+
+/*******************************************************************************
+* PROCEDURE: float_sign
+* PURPOSE: The sign of a*xperp + b*yperp as non_max_supp_reference computes it.
+*******************************************************************************/
+static int float_sign(int a, int b, int px, int py, int pm)
+{
+    float xperp = -px/((float)pm), yperp = py/((float)pm), m;
+
+    m = a*xperp + b*yperp;
+    return (m > 0.0) - (m < 0.0);
+}
+
+/*******************************************************************************
+* PROCEDURE: same_signs
+* PURPOSE: Compare nms_sign with the float interpolation where its rounding
+* decides: for random derivatives of every scale and their magnitude, a and b
+* within a few units of a multiple of py and px, so that -a*px + b*py is
+* within a few units of zero. Returns 1 when they agree.
+*******************************************************************************/
+static int same_signs(void)
+{
+    int i, range, px, py, pm, x, y, r, tmax, t, a, b;
+
+    for(i = 0; i < SIGN_CHECKS; i++)
+    {
+        range = (1 << (rand() % 16)) - 1;
+        px = rand() % (2*range + 1) - range;
+        py = rand() % (2*range + 1) - range;
+        pm = (int)(0.5 + sqrt((float)px*px + (float)py*py));
+        if(pm > 32767) pm = 32767;
+        if(pm == 0) continue;
+
+        /* -a*px + b*py is 0 for a, b = t*py/g, t*px/g, with g = gcd(px, py) */
+        for(x = abs(px), y = abs(py); y != 0; r = x % y, x = y, y = r);
+        tmax = 32765 / ((abs(px) > abs(py) ? abs(px) : abs(py)) / x);
+        t = rand() % (2*tmax + 1) - tmax;
+        a = t*(py/x) + rand() % 5 - 2;
+        b = t*(px/x) + rand() % 5 - 2;
+        if(nms_sign(a, b, px, py, pm) != float_sign(a, b, px, py, pm))
+        {
+            fprintf(stderr, "nms_sign(%d, %d, %d, %d, %d) differs from the float sign.\n",
+                    a, b, px, py, pm);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*******************************************************************************
+* PROCEDURE: same_nms
+* PURPOSE: Suppress the rows x cols frame both ways and compare the maps.
+* Returns 1 when they agree.
+*******************************************************************************/
+static int same_nms(short *mag, short *dx, short *dy, int rows, int cols,
+                    unsigned char *nms, unsigned char *ref, const char *what)
+{
+    non_max_supp(mag, dx, dy, rows, cols, nms);
+    non_max_supp_reference(mag, dx, dy, rows, cols, ref);
+    if(memcmp(nms, ref, rows*cols) != 0)
+    {
+        fprintf(stderr, "The suppression of the %dx%d %s frame differs.\n", cols, rows, what);
+        return 0;
+    }
+    return 1;
+}
+
+/*******************************************************************************
+* PROCEDURE: check_frame
+* PURPOSE: Check the frame whose derivatives are dx and dy with the magnitude
+* of every mode, then with every seventh magnitude zeroed, then the small
+* frames cut from its top left corner.
+*******************************************************************************/
+static int check_frame(short *dx, short *dy, int rows, int cols, short *mag,
+                       unsigned char *nms, unsigned char *ref, const char *what)
+{
+    int mode, i, r, c;
+    short *m, *x, *y;
+
+    for(mode = 0; mode < MAG_NUM_MODES; mode++)
+    {
+        magnitudeMode = mode;
+        magnitude_x_y(dx, dy, rows, cols, mag);
+        if(!same_nms(mag, dx, dy, rows, cols, nms, ref, what)) return 0;
+    }
+    magnitudeMode = MAG_EXACT;
+    for(i = 0; i < rows*cols; i += 7) mag[i] = 0;
+    if(!same_nms(mag, dx, dy, rows, cols, nms, ref, what)) return 0;
+
+    m = (short *) malloc(3*CHECK_MAX*CHECK_MAX*sizeof(short));
+    if(m == NULL) return 0;
+    x = m + CHECK_MAX*CHECK_MAX;
+    y = x + CHECK_MAX*CHECK_MAX;
+    for(r = 1; r <= CHECK_MAX; r++)
+    {
+        for(c = 1; c <= CHECK_MAX; c++)
+        {
+            for(i = 0; i < r*c; i++)
+            {
+                m[i] = mag[(i/c)*cols + i%c];
+                x[i] = dx[(i/c)*cols + i%c];
+                y[i] = dy[(i/c)*cols + i%c];
+            }
+            if(!same_nms(m, x, y, r, c, nms, ref, what)) return 0;
+        }
+    }
+    free(m);
+    return 1;
+}
+
+/*******************************************************************************
+* PROCEDURE: nms_times
+* PURPOSE: Suppress the frame n times with f and store the times, in
+* microseconds, in t. Returns the median.
+*******************************************************************************/
+static double nms_times(void (*f)(short *, short *, short *, int, int, unsigned char *),
+                        short *mag, short *dx, short *dy, int rows, int cols,
+                        unsigned char *nms, double *t, int n)
+{
+    double start;
+    int i;
+
+    for(i = 0; i < n; i++)
+    {
+        start = bench_now_us();
+        f(mag, dx, dy, rows, cols, nms);
+        t[i] = bench_now_us() - start;
+    }
+    bench_sort(t, n);
+    return bench_percentile(t, n, 50);
+}
+
+int main(int argc, char *argv[])
+{
+    int n = 50, checkOnly = 0, opt, i, k, rows, cols;
+    uint16_t *smoothed;
+    short *dx, *dy, *mag;
+    unsigned char *nms, *ref;
+    double *t, byInt, byFloat;
+    size_t pixels;
+
+    while((opt = getopt(argc, argv, "n:c")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': n = atoi(optarg); break;
+            case 'c': checkOnly = 1; break;
+            default: n = 0; break;
+        }
+    }
+    if(n <= 0 || argc > optind)
+    {
+        fprintf(stderr,"\n<USAGE> %s [-n iterations] [-c]\n",argv[0]);
+        fprintf(stderr,"\n      -n:  Repetitions of every measurement (50).\n");
+        fprintf(stderr,"      -c:  Only check that both versions agree.\n");
+        exit(1);
+    }
+
+    pixels = (size_t) benchRows[BENCH_NUM_SIZES-1] * benchCols[BENCH_NUM_SIZES-1];
+    smoothed = (uint16_t *) malloc(pixels*sizeof(uint16_t));
+    mag = (short *) malloc(pixels*sizeof(short));
+    nms = (unsigned char *) malloc(pixels);
+    ref = (unsigned char *) malloc(pixels);
+    t = (double *) malloc(n*sizeof(double));
+    if(smoothed == NULL || mag == NULL || nms == NULL || ref == NULL || t == NULL)
+    {
+        fprintf(stderr, "Error allocating the benchmark buffers.\n");
+        exit(1);
+    }
+
+    /****************************************************************************
+    * A random frame, whose gradients point anywhere, and a smooth one at every
+    * timed size.
+    ****************************************************************************/
+    srand(1);
+    if(!same_signs()) exit(1);
+    rows = benchRows[2];
+    cols = benchCols[2];
+    for(i = 0; i < rows*cols; i++) smoothed[i] = (uint16_t)(rand() % (SMOOTHED_MAX + 1));
+    derrivative_x_y(smoothed, rows, cols, &dx, &dy);
+    if(!check_frame(dx, dy, rows, cols, mag, nms, ref, "random")) exit(1);
+    free(dx);
+    free(dy);
+    for(k = 0; k < BENCH_NUM_SIZES; k++)
+    {
+        rows = benchRows[k];
+        cols = benchCols[k];
+        make_smooth(smoothed, rows, cols);
+        derrivative_x_y(smoothed, rows, cols, &dx, &dy);
+        if(!check_frame(dx, dy, rows, cols, mag, nms, ref, "smooth")) exit(1);
+        free(dx);
+        free(dy);
+    }
+    printf("The suppression agrees for %d near ties, random and smooth frames and every size up to %dx%d.\n",
+           SIGN_CHECKS, CHECK_MAX, CHECK_MAX);
+    if(checkOnly) return 0;
+
+    printf("%d samples per line, times in usec\n", n);
+    printf("%-9s %11s %9s %9s %9s %9s %9s\n", "version", "frame", "min", "p50", "p90", "max", "Mpix/s");
+    for(k = 0; k < BENCH_NUM_SIZES; k++)
+    {
+        rows = benchRows[k];
+        cols = benchCols[k];
+        make_smooth(smoothed, rows, cols);
+        derrivative_x_y(smoothed, rows, cols, &dx, &dy);
+        magnitude_x_y(dx, dy, rows, cols, mag);
+        byInt = nms_times(non_max_supp, mag, dx, dy, rows, cols, nms, t, n);
+        bench_report("integer", rows, cols, t, n);
+        printf("\n");
+        byFloat = nms_times(non_max_supp_reference, mag, dx, dy, rows, cols, ref, t, n);
+        bench_report("float", rows, cols, t, n);
+        printf("\n");
+        if(byInt > 0) printf("%-9s %5dx%-5d %9.2fx\n", "speedup", cols, rows, byFloat / byInt);
+        free(dx);
+        free(dy);
+    }
+
+    free(t);
+    free(ref);
+    free(nms);
+    free(mag);
+    free(smoothed);
+    return 0;
+}
@@ -7,6 +7,77 @@
 #include <stdlib.h>
 #include <string.h>
 
+int read_pgm_image_into(char *infilename, unsigned char **image, int *rows,
+                        int *cols, unsigned char *(*alloc)(int rows, int cols),
+                        void (*release)(unsigned char *image));
+
+/******************************************************************************
+* Function: read_pgm_header
+* Purpose: Verifies that fp holds a PGM image, reads in the number of columns
+* and rows in the image and scans past all of the header information. Upon
+* failure, this function returns 0, upon sucess it returns 1.
+******************************************************************************/
+static int read_pgm_header(FILE *fp, char *infilename, int *rows, int *cols)
+{
+    char buf[71];
+
+    if(fgets(buf, 70, fp) == NULL )
+        fprintf(stderr, "fgets error");
+
+    if(strncmp(buf,"P5",2) != 0)
+    {
+        fprintf(stderr, "The file %s is not in PGM format in ", infilename);
+        fprintf(stderr, "read_pgm_image().\n");
+        return(0);
+    }
+    do
+    {
+        if( fgets(buf, 70, fp) == NULL )
+            fprintf(stderr, "fgets error");
+    }
+    while(buf[0] == '#');   /* skip all comment lines */
+    sscanf(buf, "%d %d", cols, rows);
+    do
+    {
+        if( fgets(buf, 70, fp) == NULL )
+            fprintf(stderr, "fgets error");
+    }
+    while(buf[0] == '#');   /* skip all comment lines */
+    return(1);
+}
+
+/******************************************************************************
+* Function: read_pgm_size
+* Purpose: Reads only the number of rows and columns of the PGM image in the
+* file infilename. Upon failure, this function returns 0, upon sucess it
+* returns 1.
+******************************************************************************/
+int read_pgm_size(char *infilename, int *rows, int *cols)
+{
+    FILE *fp;
+    int ok;
+
+    if((fp = fopen(infilename, "r")) == NULL)
+    {
+        fprintf(stderr, "Error reading the file %s in read_pgm_size().\n",
+                infilename);
+        return(0);
+    }
+    ok = read_pgm_header(fp, infilename, rows, cols);
+    fclose(fp);
+    return(ok);
+}
+
+static unsigned char *malloc_image(int rows, int cols)
+{
+    return (unsigned char *) malloc(rows*cols);
+}
+
+static void free_image(unsigned char *image)
+{
+    free(image);
+}
+
 /******************************************************************************
 * Function: read_pgm_image
 * Purpose: This function reads in an image in PGM format. The image can be
@@ -19,9 +90,22 @@
 ******************************************************************************/
 int read_pgm_image(char *infilename, unsigned char **image, int *rows,
                    int *cols)
+{
+    return read_pgm_image_into(infilename, image, rows, cols, malloc_image,
+                               free_image);
+}
+
+/******************************************************************************
+* Function: read_pgm_image_into
+* Purpose: Same as read_pgm_image, but the memory for the image is obtained
+* from alloc(rows, cols) and given back with release() on failure. This lets
+* the caller decode the image straight into a buffer it shares with the DSP.
+******************************************************************************/
+int read_pgm_image_into(char *infilename, unsigned char **image, int *rows,
+                        int *cols, unsigned char *(*alloc)(int rows, int cols),
+                        void (*release)(unsigned char *image))
 {
     FILE *fp;
-    char buf[71];
 
     /***************************************************************************
     * Open the input image file for reading if a filename was given. If no
@@ -38,38 +122,16 @@ int read_pgm_image(char *infilename, unsigned char **image, int *rows,
         }
     }
 
-    /***************************************************************************
-    * Verify that the image is in PGM format, read in the number of columns
-    * and rows in the image and scan past all of the header information.
-    ***************************************************************************/
-    if(fgets(buf, 70, fp) == NULL )
-        fprintf(stderr, "fgets error");
-
-    if(strncmp(buf,"P5",2) != 0)
+    if(read_pgm_header(fp, infilename, rows, cols) == 0)
     {
-        fprintf(stderr, "The file %s is not in PGM format in ", infilename);
-        fprintf(stderr, "read_pgm_image().\n");
         if(fp != stdin) fclose(fp);
         return(0);
     }
-    do
-    {
-        if( fgets(buf, 70, fp) == NULL )
-            fprintf(stderr, "fgets error");
-    }
-    while(buf[0] == '#');   /* skip all comment lines */
-    sscanf(buf, "%d %d", cols, rows);
-    do
-    {
-        if( fgets(buf, 70, fp) == NULL )
-            fprintf(stderr, "fgets error");
-    }
-    while(buf[0] == '#');   /* skip all comment lines */
 
     /***************************************************************************
     * Allocate memory to store the image then read the image from the file.
     ***************************************************************************/
-    if(((*image) = (unsigned char *) malloc((*rows)*(*cols))) == NULL)
+    if(((*image) = alloc(*rows, *cols)) == NULL)
     {
         fprintf(stderr, "Memory allocation failure in read_pgm_image().\n");
         if(fp != stdin) fclose(fp);
@@ -79,7 +141,7 @@ int read_pgm_image(char *infilename, unsigned char **image, int *rows,
     {
         fprintf(stderr, "Error reading the image data in read_pgm_image().\n");
         if(fp != stdin) fclose(fp);
-        free((*image));
+        release((*image));
         return(0);
     }
 
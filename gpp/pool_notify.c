@@ -2,6 +2,9 @@
 #include<stdio.h>
 
 #include <semaphore.h>
+#include <pthread.h>
+#include <errno.h>
+#include <time.h>
 /*  ----------------------------------- DSP/BIOS Link                   */
 #include <dsplink.h>
 
@@ -48,15 +51,50 @@ extern "C" {
  *  @desc   Number of buffer pools to be configured for the allocator.
  *  ============================================================================
  */
-#define NUM_BUF_SIZES                  1
+#define NUM_BUF_SIZES                  4
 
 /** ============================================================================
  *  @const  NUM_BUF_POOL0
  *
- *  @desc   Number of buffers in first buffer pool.
+ *  @desc   Number of buffers in first buffer pool, the data buffers.
  *  ============================================================================
  */
-#define NUM_BUF_POOL0                  1
+#define NUM_BUF_POOL0                  DATA_NUM_BUFS
+
+/** ============================================================================
+ *  @const  NUM_BUF_POOL1
+ *
+ *  @desc   Number of buffers in second buffer pool, the band buffers used by
+ *          pool_notify_stream ().
+ *  ============================================================================
+ */
+#define NUM_BUF_POOL1                  STREAM_NUM_BUFS
+
+/** ============================================================================
+ *  @const  NUM_BUF_POOL2
+ *
+ *  @desc   Number of buffers in third buffer pool, the command buffer.
+ *  ============================================================================
+ */
+#define NUM_BUF_POOL2                  1
+
+/** ============================================================================
+ *  @const  NUM_BUF_POOL3
+ *
+ *  @desc   Number of buffers in fourth buffer pool, the ring buffer holding
+ *          the frame ring and the result ring. The pool is only opened when
+ *          the rings are used.
+ *  ============================================================================
+ */
+#define NUM_BUF_POOL3                  1
+
+/** ============================================================================
+ *  @const  CMD_BUF_SIZE
+ *
+ *  @desc   Size of the command buffer holding the CMD_NUM_SLOTS command blocks.
+ *  ============================================================================
+ */
+#define CMD_BUF_SIZE                   (CMD_NUM_SLOTS * CMD_SLOT_SIZE)
 
 /*  ============================================================================
  *  @const   pool_notify_INVALID_ID
@@ -83,6 +121,15 @@ extern "C" {
  */
 #define pool_notify_IPS_EVENTNO           5
 
+/** ============================================================================
+ *  @const  pool_notify_RING_EVENTNO
+ *
+ *  @desc   The IPS event number both sides ring each other with when they
+ *          have moved a ring counter. Must match dsp/pool_notify_config.h.
+ *  ============================================================================
+ */
+#define pool_notify_RING_EVENTNO          6
+
 
 /*  ============================================================================
  *  @name   pool_notify_BufferSize
@@ -93,14 +140,195 @@ extern "C" {
 STATIC Uint32  pool_notify_BufferSize ;
 
 
+/*  ============================================================================
+ *  @name   pool_notify_StreamBufSize
+ *
+ *  @desc   Size of each band buffer, at least STREAM_BUF_SIZE and large enough
+ *          for STREAM_MIN_BAND_ROWS rows of the widest frame of the session.
+ *  ============================================================================
+ */
+STATIC Uint32  pool_notify_StreamBufSize = STREAM_BUF_SIZE ;
+
+/** ============================================================================
+ *  @const  STREAM_MIN_BAND_ROWS
+ *
+ *  @desc   Fewest rows a band buffer must hold for the widest frame.
+ *  ============================================================================
+ */
+#define STREAM_MIN_BAND_ROWS           8
+
+
 /** ============================================================================
  *  @name   pool_notify_DataBuf
  *
- *  @desc   Pointer to the shared data buffer used by the pool_notify sample
+ *  @desc   Pointers to the shared data buffers used by the pool_notify sample
  *          application.
  *  ============================================================================
  */
-Uint16 * pool_notify_DataBuf = NULL ;
+Uint16 * pool_notify_DataBuf [DATA_NUM_BUFS] ;
+
+
+/** ============================================================================
+ *  @name   pool_notify_StreamBuf, pool_notify_StreamDspBuf
+ *
+ *  @desc   GPP and DSP addresses of the band buffers used to stream a frame
+ *          to the DSP.
+ *  ============================================================================
+ */
+STATIC Uint8 * pool_notify_StreamBuf [STREAM_NUM_BUFS] ;
+STATIC Uint32  pool_notify_StreamDspBuf [STREAM_NUM_BUFS] ;
+
+
+/** ============================================================================
+ *  @name   pool_notify_DataDspBuf, pool_notify_CmdBuf, pool_notify_CmdDspBuf
+ *
+ *  @desc   DSP addresses of the data buffers, and GPP and DSP addresses of
+ *          the command buffer.
+ *  ============================================================================
+ */
+STATIC Uint32  pool_notify_DataDspBuf [DATA_NUM_BUFS] ;
+STATIC Uint8 * pool_notify_CmdBuf = NULL ;
+STATIC Uint32  pool_notify_CmdDspBuf ;
+
+
+/** ============================================================================
+ *  @name   pool_notify_Seq
+ *
+ *  @desc   Sequence number of the last command sent. Zero is never used, the
+ *          DSP notifies zero when its setup is complete.
+ *  ============================================================================
+ */
+STATIC Uint32  pool_notify_Seq = 0 ;
+
+/** ============================================================================
+ *  @name   pool_notify_DoneSeq
+ *
+ *  @desc   Sequence number of the last command the DSP completed, zero once
+ *          its setup is, recorded by pool_notify_Notify () under the queue
+ *          lock. The DSP completes the commands in the order they are sent,
+ *          so every command up to it is complete.
+ *  ============================================================================
+ */
+STATIC Uint32  pool_notify_DoneSeq = (Uint32) -1 ;
+
+
+/** ============================================================================
+ *  @name   pool_notify_KernelId, pool_notify_Kernel, pool_notify_KernelSize
+ *
+ *  @desc   Id and taps of the last kernel sent to the DSP. Commands using the
+ *          same kernel only carry its id.
+ *  ============================================================================
+ */
+STATIC Uint32  pool_notify_KernelId = 0 ;
+STATIC Uint16  pool_notify_Kernel [CMD_KERNEL_MAX] ;
+STATIC int     pool_notify_KernelSize = 0 ;
+
+
+/** ============================================================================
+ *  @name   pool_notify_Running
+ *
+ *  @desc   Set once the DSP-side application has started its command loop.
+ *  ============================================================================
+ */
+STATIC Bool    pool_notify_Running = FALSE ;
+
+
+/** ============================================================================
+ *  @name   pool_notify_BufRefs
+ *
+ *  @desc   Number of holders of each data buffer: an image handed out by
+ *          pool_notify_allocImage (), a request the DSP runs in it and a
+ *          result returned by pool_notify_collect () that has not been
+ *          released yet each hold it. A buffer is free when nothing does.
+ *  ============================================================================
+ */
+STATIC int     pool_notify_BufRefs [DATA_NUM_BUFS] ;
+
+
+/** ============================================================================
+ *  @name   pool_notify_RingSlots, pool_notify_RingBufSize, pool_notify_RingBuf,
+ *          pool_notify_RingDspBuf
+ *
+ *  @desc   Slots of each ring, zero when the session has no rings, and the
+ *          size and GPP and DSP addresses of the ring buffer.
+ *  ============================================================================
+ */
+STATIC int     pool_notify_RingSlots = 0 ;
+STATIC Uint32  pool_notify_RingBufSize = 0 ;
+STATIC Uint8 * pool_notify_RingBuf = NULL ;
+STATIC Uint32  pool_notify_RingDspBuf ;
+
+
+/** ============================================================================
+ *  @name   pool_notify_RingFrames, pool_notify_RingResults
+ *
+ *  @desc   The frame ring, which the GPP produces to, and the result ring,
+ *          which it consumes from, both in the ring buffer.
+ *  ============================================================================
+ */
+STATIC Ring_Header * pool_notify_RingFrames = NULL ;
+STATIC Ring_Header * pool_notify_RingResults = NULL ;
+
+
+/** ============================================================================
+ *  @name   pool_notify_RingAcquired, pool_notify_RingReceived,
+ *          pool_notify_RingRows, pool_notify_RingCols
+ *
+ *  @desc   Set while a frame slot is acquired and not yet sent, and while a
+ *          result slot is received and not yet released. The dimensions of
+ *          the acquired frame.
+ *  ============================================================================
+ */
+STATIC Bool    pool_notify_RingAcquired = FALSE ;
+STATIC Bool    pool_notify_RingReceived = FALSE ;
+STATIC int     pool_notify_RingRows ;
+STATIC int     pool_notify_RingCols ;
+
+
+/** ============================================================================
+ *  @name   pool_notify_RingSem
+ *
+ *  @desc   Posted by pool_notify_RingNotify () for every doorbell of the DSP,
+ *          which rings it whenever it has taken a frame and added a result.
+ *  ============================================================================
+ */
+STATIC sem_t   pool_notify_RingSem ;
+
+/** ============================================================================
+ *  @const  RING_TIMEOUT_MS
+ *
+ *  @desc   Longest time to wait for a free frame slot.
+ *  ============================================================================
+ */
+#define RING_TIMEOUT_MS                10000
+
+/** ============================================================================
+ *  @const  STREAM_TIMEOUT_MS
+ *
+ *  @desc   Longest time to wait for the DSP to smooth a band.
+ *  ============================================================================
+ */
+#define STREAM_TIMEOUT_MS              10000
+
+/** ============================================================================
+ *  @const  COMMAND_TIMEOUT_MS
+ *
+ *  @desc   Longest time to wait for the DSP to finish its setup or a command
+ *          the caller waits for: CMD_CONFIG, CMD_RING_OPEN, CMD_SHUTDOWN and
+ *          the benchmark.
+ *  ============================================================================
+ */
+#define COMMAND_TIMEOUT_MS             10000
+
+/*  ============================================================================
+ *  @name   pool_notify_StreamOwed
+ *
+ *  @desc   Sequence number of the last band of a frame given up on, zero when
+ *          the DSP owes no band. The bands hold their band buffers until the
+ *          DSP completes them.
+ *  ============================================================================
+ */
+STATIC Uint32  pool_notify_StreamOwed = 0 ;
 
 
 /** ============================================================================
@@ -131,8 +359,50 @@ Uint16 * pool_notify_DataBuf = NULL ;
  */
 STATIC Void pool_notify_Notify (Uint32 eventNo, Pvoid arg, Pvoid info) ;
 
+/** ============================================================================
+ *  @func   pool_notify_RingNotify
+ *
+ *  @desc   Event callback of the ring doorbell of the DSP.
+ *  ============================================================================
+ */
+STATIC Void pool_notify_RingNotify (Uint32 eventNo, Pvoid arg, Pvoid info) ;
+
 sem_t sem;
 
+/** ============================================================================
+ *  @name   pool_notify_Queue, pool_notify_QueueLock
+ *
+ *  @desc   Asynchronous requests the DSP has not completed, in submission
+ *          order. The head request is the one the DSP is working on;
+ *          pool_notify_Notify () takes it off when it completes and sends
+ *          the next one if its image is ready in its data buffer.
+ *  ============================================================================
+ */
+STATIC pool_notify_Request * pool_notify_QueueHead = NULL ;
+STATIC pool_notify_Request * pool_notify_QueueTail = NULL ;
+STATIC pthread_mutex_t pool_notify_QueueLock = PTHREAD_MUTEX_INITIALIZER ;
+
+/** ============================================================================
+ *  @name   pool_notify_DoneList
+ *
+ *  @desc   Completed requests whose outputs are still where the DSP wrote
+ *          them, oldest first. The caller's thread takes them out, in place
+ *          when it waits for the request or as copies when a queued request
+ *          needs the data buffer.
+ *  ============================================================================
+ */
+STATIC pool_notify_Request * pool_notify_DoneList = NULL ;
+
+/** ============================================================================
+ *  @name   pool_notify_Completed, pool_notify_Completions
+ *
+ *  @desc   Signalled and counted by pool_notify_Notify () for every request
+ *          the DSP completes, under the queue lock.
+ *  ============================================================================
+ */
+STATIC pthread_cond_t pool_notify_Completed = PTHREAD_COND_INITIALIZER ;
+STATIC Uint32  pool_notify_Completions = 0 ;
+
 /** ============================================================================
  *  @func   pool_notify_Create
  *
@@ -146,45 +416,891 @@ sem_t sem;
 int rows, cols; 
 
 
-//---------------------------FUNCTION THAT SENDS DIMENSIONS TO DSP-----------------------
-void pool_notify_dimensions(void){	
-    NOTIFY_notify (0,pool_notify_IPS_ID,pool_notify_IPS_EVENTNO,(Uint32) rows);
-    NOTIFY_notify (0,pool_notify_IPS_ID,pool_notify_IPS_EVENTNO,(Uint32) cols);    
-}  
-//--------------------------FUNCTION THAT SENDS KERNEL TO DSP-------------------------------------------
+//---------------------------FUNCTION THAT SETS THE DIMENSIONS OF THE NEXT FRAMES--------------------
+void pool_notify_dimensions(int row, int col){
+    rows = row;
+    cols = col;
+}
+//--------------------------FRAMES IN THE DATA BUFFER---------------------------------------------------
+/* The image of a frame is at the start of the data buffer, its smoothed result follows at this offset */
+STATIC Uint32 pool_notify_outOffset(int row, int col){
+    return DSPLINK_ALIGN(row*col, DSPLINK_BUF_ALIGN);
+}
 
-void pool_notify_kernel(uint16_t* kernel,int windowsize, Uint8 processorId){
-	#ifdef prints
-    printf ("Sending Kernel to DSP...\n") ;	
-	#endif
-	
-	memcpy(pool_notify_DataBuf,kernel, windowsize*sizeof(uint16_t));	
-    POOL_writeback (POOL_makePoolId(processorId, SAMPLE_POOL_ID),pool_notify_DataBuf,pool_notify_BufferSize);
-    NOTIFY_notify (processorId,pool_notify_IPS_ID,pool_notify_IPS_EVENTNO,0);
-    sem_wait(&sem);   
-}
-//--------------------------FUNCTION THAT SENDS IMAGE TO DSP--------------------------------------------
-void pool_notify_image(unsigned char* image, int windowsize, Uint8 processorId){
-    #ifdef prints
-    printf ("Sending image to DSP...\n") ;		
-	#endif
-	
-	memcpy(pool_notify_DataBuf,image, rows*cols);	
-    POOL_writeback (POOL_makePoolId(processorId, SAMPLE_POOL_ID),pool_notify_DataBuf,pool_notify_BufferSize);    
-    NOTIFY_notify (processorId,pool_notify_IPS_ID,pool_notify_IPS_EVENTNO,windowsize);
-    sem_wait(&sem);
-}
-//--------------------------FUNCTION THAT RECIEVES PROCESSED IMAGE FROM DSP-----------------------------
-uint16_t* pool_notify_getImage(Uint8 processorId){
-	uint16_t* smoothedim;
+Uint32 pool_notify_frameSize(int row, int col){
+    return pool_notify_outOffset(row, col) + row*col*sizeof(uint16_t);
+}
+
+/* With CMD_EDGES the smoothed image is followed by the magnitude and the suppression map */
+STATIC Uint32 pool_notify_magOffset(int row, int col){
+    return DSPLINK_ALIGN(pool_notify_frameSize(row, col), DSPLINK_BUF_ALIGN);
+}
+
+STATIC Uint32 pool_notify_nmsOffset(int row, int col){
+    return DSPLINK_ALIGN(pool_notify_magOffset(row, col) + row*col*sizeof(short), DSPLINK_BUF_ALIGN);
+}
+
+Uint32 pool_notify_edgeFrameSize(int row, int col){
+    return pool_notify_nmsOffset(row, col) + row*col;
+}
+
+STATIC int pool_notify_fits(int row, int col){
+    return pool_notify_frameSize(row, col) <= pool_notify_BufferSize;
+}
+
+/* Data buffer p points into, -1 when it is not in one */
+STATIC int pool_notify_bufOf(void* p){
+    int i;
+
+    for(i = 0; i < DATA_NUM_BUFS; i++){
+        if(pool_notify_DataBuf[i] != NULL
+           && (Uint8*) p >= (Uint8*) pool_notify_DataBuf[i]
+           && (Uint8*) p < (Uint8*) pool_notify_DataBuf[i] + pool_notify_BufferSize) return i;
+    }
+    return -1;
+}
+
+/* A data buffer other than except that nothing holds, -1 when there is none.
+ * Called with the queue lock held, like the other pool_notify_buf* () functions. */
+STATIC int pool_notify_freeBuf(int except){
+    int i;
+
+    for(i = 0; i < DATA_NUM_BUFS; i++){
+        if(i != except && pool_notify_DataBuf[i] != NULL && pool_notify_BufRefs[i] == 0) return i;
+    }
+    return -1;
+}
+
+STATIC int pool_notify_waitSeq(Uint32 seq, int timeoutMs);
+
+/* Takes a free data buffer, -1 when there is none */
+STATIC int pool_notify_bufAcquire(void){
+    int buf = pool_notify_freeBuf(-1);
+
+    if(buf >= 0) pool_notify_BufRefs[buf] = 1;
+    return buf;
+}
+
+/* Adds a holder to a data buffer already held */
+STATIC void pool_notify_bufRetain(int buf){
+    pool_notify_BufRefs[buf]++;
+}
+
+/* Drops a holder of a data buffer. The request waiting for a buffer, if any, is
+ * started by the next pool_notify_advance (). */
+STATIC void pool_notify_bufRelease(int buf){
+    pool_notify_BufRefs[buf]--;
+}
+
+STATIC void pool_notify_advance(void);
+
+unsigned char* pool_notify_allocImage(int row, int col){
+    int buf = -1;
+
+    pthread_mutex_lock(&pool_notify_QueueLock);
+    if(pool_notify_fits(row, col)) buf = pool_notify_bufAcquire();
+    pthread_mutex_unlock(&pool_notify_QueueLock);
+    if(buf >= 0) return (unsigned char*) pool_notify_DataBuf[buf];
+    return (unsigned char*) malloc(row*col);
+}
+
+void pool_notify_freeImage(unsigned char* image){
+    int buf;
+
+    pthread_mutex_lock(&pool_notify_QueueLock);
+    buf = pool_notify_bufOf(image);
+    if(buf >= 0) pool_notify_bufRelease(buf);
+    pthread_mutex_unlock(&pool_notify_QueueLock);
+    if(buf < 0) free(image);
+    else pool_notify_advance();
+}
+
+void pool_notify_release(uint16_t* result){
+    int buf;
+
+    if(result == NULL) return;
+    pthread_mutex_lock(&pool_notify_QueueLock);
+    buf = pool_notify_bufOf(result);
+    if(buf >= 0) pool_notify_bufRelease(buf);
+    pthread_mutex_unlock(&pool_notify_QueueLock);
+    if(buf < 0) free(result);
+    else pool_notify_advance();
+}
+
+void pool_notify_release_edges(short* magnitude, unsigned char* nms){
+    pool_notify_release((uint16_t*) magnitude);
+    if(nms != NULL && pool_notify_bufOf(nms) < 0) free(nms);
+}
+int pool_notify_rowAlign(int col){
+    int a = DSPLINK_BUF_ALIGN, b = col*sizeof(uint16_t), t;
+
+    while(b != 0){
+        t = a % b;
+        a = b;
+        b = t;
+    }
+    return DSPLINK_BUF_ALIGN / a;
+}
+
+uint16_t* pool_notify_output(pool_notify_Request* req){
+    return (uint16_t*)((Uint8*)pool_notify_DataBuf[req->buf] + pool_notify_outOffset(req->rows, req->cols));
+}
+//--------------------------COMMANDS----------------------------------------------------------------------
+/* Command block in slot. Slot 0 carries whole frames, band N uses slot N % STREAM_NUM_BUFS. */
+STATIC Cmd_Block* pool_notify_cmd(int slot){
+    return (Cmd_Block*)(pool_notify_CmdBuf + slot*CMD_SLOT_SIZE);
+}
+
+/* Fills the parts of cmd common to every opcode */
+STATIC Cmd_Block* pool_notify_fillCommand(Cmd_Block* cmd, Uint32 opcode, int row, int col, uint16_t* kernel, int windowsize){
+    if(++pool_notify_Seq == 0) pool_notify_Seq = 1;
+    memset(cmd, 0, sizeof(Cmd_Block));
+    cmd->opcode = opcode;
+    cmd->seq = pool_notify_Seq;
+    cmd->rows = row;
+    cmd->cols = col;
+    cmd->numRows = row;
+    cmd->windowSize = windowsize;
+    if(kernel == NULL) return cmd;
+
+    /* The DSP keeps the last kernel, send the taps only when they change */
+    if(windowsize != pool_notify_KernelSize || memcmp(kernel, pool_notify_Kernel, windowsize*sizeof(uint16_t)) != 0){
+        if(++pool_notify_KernelId == 0) pool_notify_KernelId = 1;
+        memcpy(pool_notify_Kernel, kernel, windowsize*sizeof(uint16_t));
+        pool_notify_KernelSize = windowsize;
+        memcpy(cmd->kernel, kernel, windowsize*sizeof(uint16_t));
+    }
+    cmd->kernelId = pool_notify_KernelId;
+    return cmd;
+}
+
+/* Fills the parts of the command in slot common to every opcode */
+STATIC Cmd_Block* pool_notify_newCommand(int slot, Uint32 opcode, int row, int col, uint16_t* kernel, int windowsize){
+    return pool_notify_fillCommand(pool_notify_cmd(slot), opcode, row, col, kernel, windowsize);
+}
+
+/* Hands the command in slot to the DSP. A single notification carries it. */
+STATIC void pool_notify_sendCommand(int slot, Uint8 processorId){
+    POOL_writeback (POOL_makePoolId(processorId, SAMPLE_POOL_ID),pool_notify_cmd(slot),CMD_SLOT_SIZE);
+    NOTIFY_notify (processorId,pool_notify_IPS_ID,pool_notify_IPS_EVENTNO,pool_notify_CmdDspBuf + slot*CMD_SLOT_SIZE);
+}
+
+/* Sends the command in slot and waits for the DSP to complete it. Returns 1
+ * when it did within COMMAND_TIMEOUT_MS, its status is then in the slot. */
+STATIC int pool_notify_runCommand(int slot, Uint8 processorId){
+    pool_notify_sendCommand(slot, processorId);
+    if(!pool_notify_waitSeq(pool_notify_cmd(slot)->seq, COMMAND_TIMEOUT_MS)){
+        fprintf(stderr, "The DSP did not complete command %u (opcode %u) within %d ms.\n",
+                (unsigned)pool_notify_cmd(slot)->seq, (unsigned)pool_notify_cmd(slot)->opcode,
+                COMMAND_TIMEOUT_MS);
+        return 0;
+    }
+    return 1;
+}
+
+/* Status the DSP left in the completed command in slot */
+STATIC Uint32 pool_notify_commandStatus(int slot, Uint8 processorId){
+    Cmd_Block* cmd = pool_notify_cmd(slot);
+
+    POOL_invalidate(POOL_makePoolId(processorId, SAMPLE_POOL_ID),cmd,CMD_SLOT_SIZE);
+    if(cmd->status != CMD_STATUS_OK){
+        fprintf(stderr, "DSP command %u (opcode %u) failed with status %u.\n",
+                (unsigned)cmd->seq, (unsigned)cmd->opcode, (unsigned)cmd->status);
+    }
+    return cmd->status;
+}
+//--------------------------FUNCTION THAT STREAMS THE IMAGE TO DSP IN ROW BANDS-------------------------
+/* Copies rows [firstRow, firstRow+numRows) plus their halo rows into band buffer slot and
+ * sends the command that smooths them */
+STATIC void pool_notify_sendBand(unsigned char* image, uint16_t* kernel, int windowsize, int slot,
+                                 int firstRow, int numRows, int halo, Uint8 processorId){
+    Cmd_Block* cmd = pool_notify_newCommand(slot, CMD_SMOOTH_BAND, rows, cols, kernel, windowsize);
+    int haloTop = (firstRow < halo) ? firstRow : halo;
+    int haloBottom = (rows-firstRow-numRows < halo) ? rows-firstRow-numRows : halo;
+    int inRows = haloTop + numRows + haloBottom;
+
+    cmd->firstRow = firstRow;
+    cmd->numRows = numRows;
+    cmd->haloTop = haloTop;
+    cmd->haloBottom = haloBottom;
+    cmd->buf = pool_notify_StreamDspBuf[slot];
+    cmd->inOffset = 0;
+    cmd->outOffset = DSPLINK_ALIGN(inRows*cols, DSPLINK_BUF_ALIGN);
+    memcpy(pool_notify_StreamBuf[slot], image + (firstRow-haloTop)*cols, inRows*cols);
+    POOL_writeback (POOL_makePoolId(processorId, SAMPLE_POOL_ID),pool_notify_StreamBuf[slot],inRows*cols);
+    pool_notify_sendCommand(slot, processorId);
+}
+
+/* Smooths the image on the DSP band by band. Up to STREAM_NUM_BUFS bands are in
+ * flight, so the copy of band N+1 overlaps the DSP computing band N. Returns the
+ * smoothed image, rows x cols values scaled by 90, to be given back with
+ * pool_notify_release(). */
+uint16_t* pool_notify_stream(unsigned char* image, uint16_t* kernel, int windowsize, Uint8 processorId){
+    uint16_t* smoothedim;
+    Cmd_Block* cmd;
+    int halo = windowsize/2;
+    int bandRows, numBands, sent, done, slot, firstRow, failed = 0;
 	#ifdef prints
-    printf ("Receiving processed image from DSP...\n") ;	
+    printf ("Streaming image to DSP...\n") ;
 	#endif
-	
-    smoothedim = (uint16_t *) malloc(rows*cols*sizeof(uint16_t));    
-    POOL_invalidate(POOL_makePoolId(processorId, SAMPLE_POOL_ID),pool_notify_DataBuf,pool_notify_BufferSize);    
-    memcpy(smoothedim, pool_notify_DataBuf, rows*cols*sizeof(uint16_t));  
- return smoothedim;
+
+    if(windowsize > CMD_KERNEL_MAX){
+        fprintf(stderr, "A kernel of %d taps does not fit a DSP command.\n", windowsize);
+        return NULL;
+    }
+    if(windowsize == CMD_KERNEL_IIR){
+        fprintf(stderr, "The recursive Gaussian cannot smooth a frame in bands.\n");
+        return NULL;
+    }
+    /* Largest band whose input (with halo) and output fit in one band buffer */
+    bandRows = ((int)pool_notify_StreamBufSize - DSPLINK_BUF_ALIGN - 2*halo*cols) / (3*cols);
+    if(bandRows < 1){
+        fprintf(stderr, "Image rows of %d pixels do not fit a %d byte band buffer.\n", cols, (int)pool_notify_StreamBufSize);
+        return NULL;
+    }
+    if(bandRows > rows) bandRows = rows;
+    numBands = (rows + bandRows - 1) / bandRows;
+
+    /* The bands of a frame given up on must be done before their buffers are reused */
+    if(pool_notify_StreamOwed != 0){
+        if(!pool_notify_waitSeq(pool_notify_StreamOwed, STREAM_TIMEOUT_MS)){
+            fprintf(stderr, "The DSP has not smoothed the bands of an earlier frame.\n");
+            return NULL;
+        }
+        pool_notify_StreamOwed = 0;
+    }
+
+    smoothedim = (uint16_t *) malloc(rows*cols*sizeof(uint16_t));
+    if(smoothedim == NULL){
+        fprintf(stderr, "Error allocating the smoothed image.\n");
+        return NULL;
+    }
+
+    for(sent = 0, done = 0; done < sent || (!failed && sent < numBands); done++){
+        /* Keep every band buffer busy */
+        while(!failed && sent < numBands && sent - done < STREAM_NUM_BUFS){
+            firstRow = sent*bandRows;
+            pool_notify_sendBand(image, kernel, windowsize, sent % STREAM_NUM_BUFS, firstRow,
+                                 (rows-firstRow < bandRows) ? rows-firstRow : bandRows, halo, processorId);
+            sent++;
+        }
+        /* The DSP completes the bands in order */
+        slot = done % STREAM_NUM_BUFS;
+        if(!pool_notify_waitSeq(pool_notify_cmd(slot)->seq, STREAM_TIMEOUT_MS)){
+            fprintf(stderr, "The DSP did not smooth a band within %d ms.\n", STREAM_TIMEOUT_MS);
+            pool_notify_StreamOwed = pool_notify_cmd((sent-1) % STREAM_NUM_BUFS)->seq;
+            failed = 1;
+            break;
+        }
+        if(pool_notify_commandStatus(slot, processorId) != CMD_STATUS_OK){
+            failed = 1;
+            continue;
+        }
+        cmd = pool_notify_cmd(slot);
+        POOL_invalidate(POOL_makePoolId(processorId, SAMPLE_POOL_ID),
+                        pool_notify_StreamBuf[slot] + cmd->outOffset, cmd->numRows*cols*sizeof(uint16_t));
+        memcpy(smoothedim + cmd->firstRow*cols, pool_notify_StreamBuf[slot] + cmd->outOffset,
+               cmd->numRows*cols*sizeof(uint16_t));
+    }
+    if(failed){
+        free(smoothedim);
+        return NULL;
+    }
+    return smoothedim;
+}
+//--------------------------TRANSPORT BENCHMARK----------------------------------------------------------
+Uint8* pool_notify_benchBuffer(Uint32* size){
+    *size = pool_notify_BufferSize;
+    return (Uint8*) pool_notify_DataBuf[0];
+}
+
+void pool_notify_writeback(void* p, Uint32 size, Uint8 processorId){
+    POOL_writeback (POOL_makePoolId(processorId, SAMPLE_POOL_ID),p,size);
+}
+
+void pool_notify_invalidate(void* p, Uint32 size, Uint8 processorId){
+    POOL_invalidate (POOL_makePoolId(processorId, SAMPLE_POOL_ID),p,size);
+}
+
+/* Runs a CMD_BENCH command on the first data buffer, which must be idle and hold size bytes */
+STATIC int pool_notify_benchCommand(Uint32 steps, int row, int col, Uint32 size,
+                                    uint16_t* kernel, int windowsize, Uint8 processorId){
+    Cmd_Block* cmd;
+    Bool idle;
+
+    pthread_mutex_lock(&pool_notify_QueueLock);
+    idle = pool_notify_QueueHead == NULL && pool_notify_BufRefs[0] == 0;
+    pthread_mutex_unlock(&pool_notify_QueueLock);
+    if(!idle || size > pool_notify_BufferSize){
+        fprintf(stderr, "The first data buffer is in use or smaller than %u bytes.\n", (unsigned)size);
+        return 0;
+    }
+    if(windowsize > CMD_KERNEL_MAX){
+        fprintf(stderr, "A kernel of %d taps does not fit a DSP command.\n", windowsize);
+        return 0;
+    }
+    cmd = pool_notify_newCommand(0, CMD_BENCH, row, col, kernel, windowsize);
+    cmd->buf = pool_notify_DataDspBuf[0];
+    cmd->outOffset = pool_notify_outOffset(row, col);
+    cmd->numRows = steps;
+    return pool_notify_runCommand(0, processorId)
+           && pool_notify_commandStatus(0, processorId) == CMD_STATUS_OK;
+}
+
+int pool_notify_bench(Uint32 steps, Uint32 size, Uint8 processorId){
+    return pool_notify_benchCommand(steps & ~(CMD_BENCH_SMOOTH | CMD_BENCH_COLUMNS | CMD_BENCH_TILES), size, 1, size,
+                                    NULL, 0, processorId);
+}
+
+uint16_t* pool_notify_benchSmooth(Uint32 steps, int row, int col, uint16_t* kernel, int windowsize, Uint8 processorId){
+    if(!pool_notify_benchCommand(steps | CMD_BENCH_SMOOTH, row, col, pool_notify_frameSize(row, col),
+                                 kernel, windowsize, processorId)) return NULL;
+    return (uint16_t*)((Uint8*)pool_notify_DataBuf[0] + pool_notify_outOffset(row, col));
+}
+//--------------------------WAITING FOR THE DSP----------------------------------------------------------
+/* The time timeoutMs milliseconds from now, as sem_timedwait () takes it.
+ * NULL, for no deadline, when timeoutMs is POOL_NOTIFY_WAIT_FOREVER. */
+STATIC struct timespec* pool_notify_deadline(struct timespec* deadline, int timeoutMs){
+    if(timeoutMs < 0) return NULL;
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_sec += timeoutMs / 1000;
+    deadline->tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+    if(deadline->tv_nsec >= 1000000000L){
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+    return deadline;
+}
+
+/* Waits until deadline, or forever when it is NULL, for s to be posted.
+ * Returns 1 when it was. */
+STATIC int pool_notify_semWaitUntil(sem_t* s, const struct timespec* deadline){
+    int ret;
+
+    if(deadline == NULL){
+        do ret = sem_wait(s); while(ret != 0 && errno == EINTR);
+    }
+    else{
+        do ret = sem_timedwait(s, deadline); while(ret != 0 && errno == EINTR);
+    }
+    return ret == 0;
+}
+
+/* Waits until deadline, or forever when it is NULL, for the DSP to complete a
+ * request. Called with the queue lock held. Returns 0 at the deadline. */
+STATIC int pool_notify_completionUntil(const struct timespec* deadline){
+    if(deadline == NULL) return pthread_cond_wait(&pool_notify_Completed, &pool_notify_QueueLock) == 0;
+    return pthread_cond_timedwait(&pool_notify_Completed, &pool_notify_QueueLock, deadline) != ETIMEDOUT;
+}
+
+/* Whether the DSP has completed the command seq, zero standing for its setup */
+STATIC int pool_notify_seqDone(Uint32 seq){
+    Int32 ahead;
+
+    pthread_mutex_lock(&pool_notify_QueueLock);
+    ahead = (Int32)(pool_notify_DoneSeq - seq);
+    pthread_mutex_unlock(&pool_notify_QueueLock);
+    return ahead >= 0;
+}
+
+/* Waits at most timeoutMs milliseconds in all for the DSP to complete the
+ * command seq. sem is posted for every command outside the request queue,
+ * so the completion of an earlier one, such as a band given up on, only
+ * wakes the wait up. Returns 1 when seq completed. */
+STATIC int pool_notify_waitSeq(Uint32 seq, int timeoutMs){
+    struct timespec deadline;
+    struct timespec* until = pool_notify_deadline(&deadline, timeoutMs);
+
+    while(!pool_notify_seqDone(seq)){
+        if(!pool_notify_semWaitUntil(&sem, until)) return pool_notify_seqDone(seq);
+    }
+    return 1;
+}
+//--------------------------STREAMING RINGS--------------------------------------------------------------
+/* A frame slot holds a command block and the image, a result slot a command block and the smoothed image */
+STATIC Uint32 pool_notify_frameSlotSize(int row, int col){
+    return CMD_SLOT_SIZE + DSPLINK_ALIGN(row*col, DSPLINK_BUF_ALIGN);
+}
+
+STATIC Uint32 pool_notify_resultSlotSize(int row, int col){
+    return CMD_SLOT_SIZE + DSPLINK_ALIGN(row*col*sizeof(uint16_t), DSPLINK_BUF_ALIGN);
+}
+
+/* The result ring follows the frame ring in the ring buffer */
+STATIC Uint32 pool_notify_ringOffset(int row, int col){
+    return RING_HEADER_SIZE + pool_notify_RingSlots * pool_notify_frameSlotSize(row, col);
+}
+
+/* Lays out both rings, empty, for frames of the session dimensions */
+STATIC void pool_notify_ringInit(void){
+    pool_notify_RingFrames = (Ring_Header*) pool_notify_RingBuf;
+    pool_notify_RingResults = (Ring_Header*) (pool_notify_RingBuf + pool_notify_ringOffset(rows, cols));
+    memset(pool_notify_RingFrames, 0, RING_HEADER_SIZE);
+    pool_notify_RingFrames->numSlots = pool_notify_RingSlots;
+    pool_notify_RingFrames->slotSize = pool_notify_frameSlotSize(rows, cols);
+    memset(pool_notify_RingResults, 0, RING_HEADER_SIZE);
+    pool_notify_RingResults->numSlots = pool_notify_RingSlots;
+    pool_notify_RingResults->slotSize = pool_notify_resultSlotSize(rows, cols);
+    POOL_writeback (POOL_makePoolId(ID_PROCESSOR, SAMPLE_POOL_ID),pool_notify_RingFrames,RING_HEADER_SIZE);
+    POOL_writeback (POOL_makePoolId(ID_PROCESSOR, SAMPLE_POOL_ID),pool_notify_RingResults,RING_HEADER_SIZE);
+}
+
+/* Slot count % numSlots of ring */
+STATIC Cmd_Block* pool_notify_ringSlot(Ring_Header* ring, Uint32 count){
+    return (Cmd_Block*)((Uint8*)ring + RING_HEADER_SIZE + (count % ring->numSlots) * ring->slotSize);
+}
+
+/* Reads a counter the DSP moves */
+STATIC Uint32 pool_notify_ringRead(Uint32* counter){
+    POOL_invalidate (POOL_makePoolId(ID_PROCESSOR, SAMPLE_POOL_ID),counter,RING_LINE);
+    return *counter;
+}
+
+/* Moves a counter of the GPP on by one and rings the DSP */
+STATIC void pool_notify_ringAdvance(Uint32* counter){
+    (*counter)++;
+    POOL_writeback (POOL_makePoolId(ID_PROCESSOR, SAMPLE_POOL_ID),counter,RING_LINE);
+    NOTIFY_notify (ID_PROCESSOR,pool_notify_IPS_ID,pool_notify_RING_EVENTNO,*counter);
+}
+
+void pool_notify_ringSlots(int numSlots){
+    pool_notify_RingSlots = numSlots;
+}
+
+unsigned char* pool_notify_ring_allocImage(int row, int col){
+    Ring_Header* ring = pool_notify_RingFrames;
+    struct timespec deadline;
+    struct timespec* until;
+
+    if(ring == NULL || pool_notify_RingAcquired || CMD_SLOT_SIZE + (Uint32)(row*col) > ring->slotSize) return NULL;
+    /* Back-pressure: wait for the DSP to take a frame off a full ring. Every
+     * result wakes the wait up, so it is bounded by one deadline. */
+    until = pool_notify_deadline(&deadline, RING_TIMEOUT_MS);
+    while(ring->writeCount - pool_notify_ringRead(&ring->readCount) >= ring->numSlots){
+        if(!pool_notify_semWaitUntil(&pool_notify_RingSem, until)
+           && ring->writeCount - pool_notify_ringRead(&ring->readCount) >= ring->numSlots){
+            fprintf(stderr, "The DSP took no frame off the ring within %d ms.\n", RING_TIMEOUT_MS);
+            return NULL;
+        }
+    }
+    pool_notify_RingAcquired = TRUE;
+    pool_notify_RingRows = row;
+    pool_notify_RingCols = col;
+    return (Uint8*) pool_notify_ringSlot(ring, ring->writeCount) + CMD_SLOT_SIZE;
+}
+
+void pool_notify_ring_freeImage(unsigned char* image){
+    (void) image; /* The slot is simply not sent */
+    pool_notify_RingAcquired = FALSE;
+}
+
+Uint32 pool_notify_ring_send(uint16_t* kernel, int windowsize){
+    Ring_Header* ring = pool_notify_RingFrames;
+    Cmd_Block* cmd;
+
+    if(!pool_notify_RingAcquired) return 0;
+    if(windowsize > CMD_KERNEL_MAX){
+        fprintf(stderr, "A kernel of %d taps does not fit a DSP command.\n", windowsize);
+        return 0;
+    }
+    cmd = pool_notify_ringSlot(ring, ring->writeCount);
+    pool_notify_fillCommand(cmd, CMD_SMOOTH, pool_notify_RingRows, pool_notify_RingCols, kernel, windowsize);
+    /* The DSP may see the frames and the commands in any order, so the taps always travel with a frame */
+    memcpy(cmd->kernel, kernel, windowsize*sizeof(uint16_t));
+    POOL_writeback (POOL_makePoolId(ID_PROCESSOR, SAMPLE_POOL_ID),cmd,
+                    CMD_SLOT_SIZE + pool_notify_RingRows*pool_notify_RingCols);
+    pool_notify_RingAcquired = FALSE;
+    pool_notify_ringAdvance(&ring->writeCount);
+    return cmd->seq;
+}
+
+/* Waits at most timeoutMs milliseconds in all, however often the doorbell
+ * rings meanwhile. */
+Bool pool_notify_ring_wait(int timeoutMs){
+    Ring_Header* ring = pool_notify_RingResults;
+    struct timespec deadline;
+    struct timespec* until = pool_notify_deadline(&deadline, timeoutMs);
+
+    if(ring == NULL) return FALSE;
+    while(pool_notify_ringRead(&ring->writeCount) == ring->readCount){
+        if(!pool_notify_semWaitUntil(&pool_notify_RingSem, until)){
+            return pool_notify_ringRead(&ring->writeCount) != ring->readCount;
+        }
+    }
+    return TRUE;
+}
+
+uint16_t* pool_notify_ring_receive(int* row, int* col, int timeoutMs){
+    Ring_Header* ring = pool_notify_RingResults;
+    Cmd_Block* result;
+
+    if(pool_notify_RingReceived || !pool_notify_ring_wait(timeoutMs)) return NULL;
+    result = pool_notify_ringSlot(ring, ring->readCount);
+    POOL_invalidate (POOL_makePoolId(ID_PROCESSOR, SAMPLE_POOL_ID),result,CMD_SLOT_SIZE);
+    *row = result->rows;
+    *col = result->cols;
+    if(result->status != CMD_STATUS_OK){
+        fprintf(stderr, "DSP frame %u failed with status %u.\n",
+                (unsigned)result->seq, (unsigned)result->status);
+        pool_notify_ringAdvance(&ring->readCount);
+        return NULL;
+    }
+    POOL_invalidate (POOL_makePoolId(ID_PROCESSOR, SAMPLE_POOL_ID),(Uint8*)result + CMD_SLOT_SIZE,
+                     result->rows*result->cols*sizeof(uint16_t));
+    pool_notify_RingReceived = TRUE;
+    return (uint16_t*)((Uint8*)result + CMD_SLOT_SIZE);
+}
+
+void pool_notify_ring_release(void){
+    if(!pool_notify_RingReceived) return;
+    pool_notify_RingReceived = FALSE;
+    pool_notify_ringAdvance(&pool_notify_RingResults->readCount);
+}
+//--------------------------ASYNCHRONOUS REQUESTS---------------------------------------------------------
+STATIC pool_notify_Request* pool_notify_enqueue(unsigned char* image, uint16_t* kernel, int windowsize,
+                                                int dspRows, Bool edges, Uint8 processorId);
+
+/* Copies the image of a request into its data buffer, unless it was decoded
+ * there, and cleans it and what the DSP writes from the cache. Runs on the
+ * caller's thread without the queue lock: the buffer is the request's already
+ * and nothing sends the request before it is ready. */
+STATIC void pool_notify_prepareRequest(pool_notify_Request* req){
+    Uint8* data = (Uint8*) pool_notify_DataBuf[req->buf];
+
+    if(req->image != data) memcpy(data,req->image, req->rows*req->cols);
+    POOL_writeback (POOL_makePoolId(req->processorId, SAMPLE_POOL_ID),data,req->rows*req->cols);
+    /* Clean what the DSP writes, so no line the GPP dirtied is evicted over it */
+    if(req->edges){
+        POOL_writeback (POOL_makePoolId(req->processorId, SAMPLE_POOL_ID),pool_notify_output(req),
+                        pool_notify_edgeFrameSize(req->rows, req->cols) - pool_notify_outOffset(req->rows, req->cols));
+    }
+    else{
+        POOL_writeback (POOL_makePoolId(req->processorId, SAMPLE_POOL_ID),pool_notify_output(req),req->dspRows*req->cols*sizeof(uint16_t));
+    }
+}
+
+/* Sends the command of a request whose image is ready in its data buffer. The
+ * DSP must not be working on another request. Called with the queue lock held. */
+STATIC void pool_notify_sendRequest(pool_notify_Request* req){
+    Cmd_Block* cmd;
+
+    cmd = pool_notify_newCommand(0, req->edges ? CMD_EDGES : CMD_SMOOTH, req->rows, req->cols, req->kernel, req->windowsize);
+    cmd->buf = pool_notify_DataDspBuf[req->buf];
+    cmd->outOffset = pool_notify_outOffset(req->rows, req->cols);
+    cmd->magOffset = pool_notify_magOffset(req->rows, req->cols);
+    cmd->nmsOffset = pool_notify_nmsOffset(req->rows, req->cols);
+    cmd->numRows = req->dspRows;
+    req->seq = cmd->seq;
+    req->stage = POOL_NOTIFY_STAGE_RUNNING;
+    clock_gettime(CLOCK_MONOTONIC, &req->sent);
+    pool_notify_sendCommand(0, req->processorId);
+}
+
+/* Takes the outputs of a completed request out of its data buffer: in place,
+ * the buffer then staying held until they are released, or as copies, the
+ * buffer then being given up. Runs on the caller's thread without the queue
+ * lock, once the request is off pool_notify_DoneList. */
+STATIC void pool_notify_takeOutputs(pool_notify_Request* req, Bool keep){
+    Uint8* data = (Uint8*) pool_notify_DataBuf[req->buf];
+    Uint8* out = (Uint8*) pool_notify_output(req);
+    Uint8* mag = data + pool_notify_magOffset(req->rows, req->cols);
+    Uint8* nms = data + pool_notify_nmsOffset(req->rows, req->cols);
+    Uint32 size = req->rows*req->cols;
+
+    req->result = NULL;
+    req->magnitude = NULL;
+    req->nms = NULL;
+    if(req->status != CMD_STATUS_OK){
+        keep = FALSE;
+    }
+    else if(req->edges){
+        POOL_invalidate(POOL_makePoolId(req->processorId, SAMPLE_POOL_ID),mag,size*sizeof(short));
+        POOL_invalidate(POOL_makePoolId(req->processorId, SAMPLE_POOL_ID),nms,size);
+        if(keep){
+            req->magnitude = (short*) mag;
+            req->nms = nms;
+        }
+        else if((req->magnitude = (short*) malloc(size*sizeof(short))) != NULL
+                && (req->nms = (unsigned char*) malloc(size)) != NULL){
+            memcpy(req->magnitude, mag, size*sizeof(short));
+            memcpy(req->nms, nms, size);
+        }
+        else{
+            free(req->magnitude);
+            req->magnitude = NULL;
+        }
+    }
+    else{
+        /* Only the DSP rows: the GPP may still be writing the others */
+        POOL_invalidate(POOL_makePoolId(req->processorId, SAMPLE_POOL_ID),out,req->dspRows*req->cols*sizeof(uint16_t));
+        if(keep){
+            /* Hand out the result where the DSP wrote it */
+            req->result = (uint16_t*) out;
+        }
+        else if((req->result = (uint16_t*) malloc(size*sizeof(uint16_t))) != NULL){
+            memcpy(req->result, out, size*sizeof(uint16_t));
+        }
+    }
+    if(!keep){
+        pthread_mutex_lock(&pool_notify_QueueLock);
+        pool_notify_bufRelease(req->buf);
+        pthread_mutex_unlock(&pool_notify_QueueLock);
+    }
+}
+
+/* Removes req from pool_notify_DoneList. Returns FALSE when it was not on it,
+ * its outputs were then copied out already. Called with the queue lock held. */
+STATIC Bool pool_notify_unlinkDone(pool_notify_Request* req){
+    pool_notify_Request** p;
+
+    for(p = &pool_notify_DoneList; *p != NULL; p = &(*p)->next){
+        if(*p == req){
+            *p = req->next;
+            req->next = NULL;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* The oldest completed request whose outputs alone hold its data buffer, NULL
+ * when there is none. Called with the queue lock held. */
+STATIC pool_notify_Request* pool_notify_evictable(void){
+    pool_notify_Request* req;
+
+    for(req = pool_notify_DoneList; req != NULL; req = req->next){
+        if(pool_notify_BufRefs[req->buf] == 1) return req;
+    }
+    return NULL;
+}
+
+/* Takes the head request off the queue after the DSP finished its command and
+ * sends the next one if its image is ready. Nothing is copied here, this runs
+ * in the NOTIFY callback. Called with the queue lock held. */
+STATIC void pool_notify_completeRequest(void){
+    pool_notify_Request* req = pool_notify_QueueHead;
+    pool_notify_Request** p;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    req->dspTime = (now.tv_sec - req->sent.tv_sec) * 1000.0 + (now.tv_nsec - req->sent.tv_nsec) / 1000000.0;
+    req->status = pool_notify_commandStatus(0, req->processorId);
+    req->stage = POOL_NOTIFY_STAGE_DONE;
+
+    pool_notify_QueueHead = req->next;
+    if(pool_notify_QueueHead == NULL) pool_notify_QueueTail = NULL;
+    req->next = NULL;
+    for(p = &pool_notify_DoneList; *p != NULL; p = &(*p)->next);
+    *p = req;
+    if(pool_notify_QueueHead != NULL && pool_notify_QueueHead->stage == POOL_NOTIFY_STAGE_READY){
+        pool_notify_sendRequest(pool_notify_QueueHead);
+    }
+    pool_notify_Completions++;
+    pthread_cond_broadcast(&pool_notify_Completed);
+}
+
+/* Moves the queue on from the caller's thread: gives the first request without
+ * a data buffer one, copying the outputs of completed requests out of theirs
+ * if it must, prepares its image and sends it if the DSP is free. Requests are
+ * readied in submission order, so pool_notify_Notify () sends every ready one
+ * in turn. Called without the queue lock. */
+STATIC void pool_notify_advance(void){
+    pool_notify_Request* req;
+    pool_notify_Request* victim;
+    int buf;
+
+    for(;;){
+        pthread_mutex_lock(&pool_notify_QueueLock);
+        req = pool_notify_QueueHead;
+        while(req != NULL && req->stage != POOL_NOTIFY_STAGE_QUEUED) req = req->next;
+        if(req == NULL){
+            pthread_mutex_unlock(&pool_notify_QueueLock);
+            return;
+        }
+        buf = pool_notify_bufOf(req->image);
+        if(buf >= 0) pool_notify_bufRetain(buf);
+        else buf = pool_notify_bufAcquire();
+        if(buf < 0){
+            /* Every data buffer is held, free one that only completed outputs hold */
+            victim = pool_notify_evictable();
+            if(victim != NULL) pool_notify_unlinkDone(victim);
+            pthread_mutex_unlock(&pool_notify_QueueLock);
+            if(victim == NULL) return;
+            pool_notify_takeOutputs(victim, FALSE);
+            continue;
+        }
+        req->buf = buf;
+        pthread_mutex_unlock(&pool_notify_QueueLock);
+
+        pool_notify_prepareRequest(req);
+
+        pthread_mutex_lock(&pool_notify_QueueLock);
+        req->stage = POOL_NOTIFY_STAGE_READY;
+        if(req == pool_notify_QueueHead) pool_notify_sendRequest(req);
+        pthread_mutex_unlock(&pool_notify_QueueLock);
+    }
+}
+
+/* Takes the outputs of a completed request in place, unless a queued request
+ * needed its data buffer and they were copied out already. */
+STATIC void pool_notify_finish(pool_notify_Request* req){
+    Bool inPlace;
+
+    pthread_mutex_lock(&pool_notify_QueueLock);
+    inPlace = pool_notify_unlinkDone(req);
+    pthread_mutex_unlock(&pool_notify_QueueLock);
+    if(inPlace) pool_notify_takeOutputs(req, TRUE);
+    req->completed = 1;
+}
+
+pool_notify_Request* pool_notify_submit(unsigned char* image, uint16_t* kernel, int windowsize, Uint8 processorId){
+    return pool_notify_submit_rows(image, kernel, windowsize, rows, processorId);
+}
+
+pool_notify_Request* pool_notify_submit_rows(unsigned char* image, uint16_t* kernel, int windowsize, int dspRows, Uint8 processorId){
+    return pool_notify_enqueue(image, kernel, windowsize, dspRows, FALSE, processorId);
+}
+
+pool_notify_Request* pool_notify_submit_edges(unsigned char* image, uint16_t* kernel, int windowsize, Uint8 processorId){
+    return pool_notify_enqueue(image, kernel, windowsize, rows, TRUE, processorId);
+}
+
+/* Queues a request for the current frame dimensions. The DSP smooths its rows
+ * [0, dspRows), or computes the edge planes of the whole frame with edges. */
+STATIC pool_notify_Request* pool_notify_enqueue(unsigned char* image, uint16_t* kernel, int windowsize,
+                                                int dspRows, Bool edges, Uint8 processorId){
+    pool_notify_Request* req;
+    int split = dspRows < rows;
+    Uint32 size = edges ? pool_notify_edgeFrameSize(rows, cols) : pool_notify_frameSize(rows, cols);
+
+    if(windowsize > CMD_KERNEL_MAX){
+        fprintf(stderr, "A kernel of %d taps does not fit a DSP command.\n", windowsize);
+        return NULL;
+    }
+    if(size > pool_notify_BufferSize){
+        fprintf(stderr, "A %dx%d image does not fit the %d byte data buffer.\n", cols, rows, (int)pool_notify_BufferSize);
+        return NULL;
+    }
+    if(dspRows < 0 || dspRows > rows || (split && dspRows % pool_notify_rowAlign(cols) != 0)
+       || (split && windowsize == CMD_KERNEL_IIR)){
+        fprintf(stderr, "The DSP cannot smooth %d of the %d rows on its own.\n", dspRows, rows);
+        return NULL;
+    }
+    req = (pool_notify_Request*) calloc(1, sizeof(pool_notify_Request));
+    if(req == NULL) return NULL;
+    req->kernel = (uint16_t*) malloc(windowsize*sizeof(uint16_t));
+    if(req->kernel == NULL){
+        free(req);
+        return NULL;
+    }
+    memcpy(req->kernel, kernel, windowsize*sizeof(uint16_t));
+    req->image = image;
+    req->rows = rows;
+    req->cols = cols;
+    req->windowsize = windowsize;
+    req->dspRows = dspRows;
+    req->edges = edges;
+    req->processorId = processorId;
+    req->buf = -1;
+    req->stage = POOL_NOTIFY_STAGE_QUEUED;
+
+    pthread_mutex_lock(&pool_notify_QueueLock);
+    if(pool_notify_QueueTail != NULL && (split || pool_notify_QueueTail->dspRows < pool_notify_QueueTail->rows)){
+        /* The result of a split request must stay in the data buffer until it is collected */
+        pthread_mutex_unlock(&pool_notify_QueueLock);
+        fprintf(stderr, "A split request cannot share the queue with other requests.\n");
+        free(req->kernel);
+        free(req);
+        return NULL;
+    }
+    if(pool_notify_QueueTail == NULL && pool_notify_bufOf(image) < 0
+       && pool_notify_freeBuf(-1) < 0 && pool_notify_evictable() == NULL){
+        /* Nothing queued could release a data buffer */
+        pthread_mutex_unlock(&pool_notify_QueueLock);
+        fprintf(stderr, "Every data buffer is still held, release one before submitting.\n");
+        free(req->kernel);
+        free(req);
+        return NULL;
+    }
+    if(pool_notify_QueueTail == NULL) pool_notify_QueueHead = req;
+    else pool_notify_QueueTail->next = req;
+    pool_notify_QueueTail = req;
+    pthread_mutex_unlock(&pool_notify_QueueLock);
+    pool_notify_advance();
+    return req;
+}
+
+pool_notify_Request* pool_notify_submit_stream(unsigned char* image, uint16_t* kernel, int windowsize, Uint8 processorId){
+    pool_notify_Request* req;
+
+    req = (pool_notify_Request*) calloc(1, sizeof(pool_notify_Request));
+    if(req == NULL) return NULL;
+    req->result = pool_notify_stream(image, kernel, windowsize, processorId);
+    if(req->result == NULL){
+        free(req);
+        return NULL;
+    }
+    req->stage = POOL_NOTIFY_STAGE_DONE;
+    req->completed = 1;
+    return req;
+}
+
+int pool_notify_poll(pool_notify_Request* req){
+    Bool done;
+
+    if(req->completed) return 1;
+    pool_notify_advance();
+    pthread_mutex_lock(&pool_notify_QueueLock);
+    done = req->stage == POOL_NOTIFY_STAGE_DONE;
+    pthread_mutex_unlock(&pool_notify_QueueLock);
+    if(done) pool_notify_finish(req);
+    return req->completed;
+}
+
+/* Moves the queue on whenever the DSP completes a request, as the request
+ * waited for may need a data buffer that only the caller's thread can free. */
+int pool_notify_wait(pool_notify_Request* req, int timeoutMs){
+    struct timespec deadline;
+    struct timespec* until;
+    Uint32 completions;
+    Bool done = FALSE;
+    Bool timedOut = FALSE;
+
+    if(req->completed) return 1;
+    until = pool_notify_deadline(&deadline, timeoutMs);
+    while(!done && !timedOut){
+        pthread_mutex_lock(&pool_notify_QueueLock);
+        completions = pool_notify_Completions;
+        pthread_mutex_unlock(&pool_notify_QueueLock);
+        pool_notify_advance();
+        pthread_mutex_lock(&pool_notify_QueueLock);
+        if(req->stage != POOL_NOTIFY_STAGE_DONE && completions == pool_notify_Completions){
+            timedOut = !pool_notify_completionUntil(until);
+        }
+        done = req->stage == POOL_NOTIFY_STAGE_DONE;
+        pthread_mutex_unlock(&pool_notify_QueueLock);
+    }
+    if(done) pool_notify_finish(req);
+    return req->completed;
+}
+
+int pool_notify_collect_edges(pool_notify_Request* req, short** magnitude, unsigned char** nms){
+    pool_notify_wait(req, POOL_NOTIFY_WAIT_FOREVER);
+    *magnitude = req->magnitude;
+    *nms = req->nms;
+    free(req->kernel);
+    free(req);
+    return *magnitude != NULL;
+}
+
+uint16_t* pool_notify_collect(pool_notify_Request* req){
+    uint16_t* smoothedim;
+
+    pool_notify_wait(req, POOL_NOTIFY_WAIT_FOREVER);
+    smoothedim = req->result;
+    free(req->kernel);
+    free(req);
+    return smoothedim;
 }
 //------------------------------------------------------------------------------------------------------
 
@@ -195,8 +1311,13 @@ NORMAL_API DSP_STATUS pool_notify_Create (	IN Char8 * dspExecutable,
     DSP_STATUS      status     = DSP_SOK  ;
     Uint32          numArgs    = NUM_ARGS ;
     Void *          dspDataBuf = NULL ;
-    Uint32          numBufs [NUM_BUF_SIZES] = {NUM_BUF_POOL0, } ;
+    Uint32          numBufs [NUM_BUF_SIZES] = {NUM_BUF_POOL0, NUM_BUF_POOL1,
+                                               NUM_BUF_POOL2, NUM_BUF_POOL3} ;
     Uint32          size    [NUM_BUF_SIZES] ;
+    Void *          dspStreamBuf = NULL ;
+    Void *          dspCmdBuf  = NULL ;
+    Void *          dspRingBuf = NULL ;
+    Uint32          i ;
     SMAPOOL_Attrs   poolAttrs ;
     Char8 *         args [NUM_ARGS] ;
 
@@ -233,9 +1354,12 @@ NORMAL_API DSP_STATUS pool_notify_Create (	IN Char8 * dspExecutable,
     if (DSP_SUCCEEDED (status)) 
 	{
         size [0] = pool_notify_BufferSize ;
+        size [1] = pool_notify_StreamBufSize ;
+        size [2] = CMD_BUF_SIZE ;
+        size [3] = pool_notify_RingBufSize ;
         poolAttrs.bufSizes      = (Uint32 *) &size ;
         poolAttrs.numBuffers    = (Uint32 *) &numBufs ;
-        poolAttrs.numBufPools   = NUM_BUF_SIZES ;
+        poolAttrs.numBufPools   = (pool_notify_RingSlots > 0) ? NUM_BUF_SIZES : NUM_BUF_SIZES - 1 ;
         poolAttrs.exactMatchReq = TRUE ;
         status = POOL_open (POOL_makePoolId(processorId, SAMPLE_POOL_ID), &poolAttrs) ;
         if (DSP_FAILED (status)) 
@@ -245,12 +1369,12 @@ NORMAL_API DSP_STATUS pool_notify_Create (	IN Char8 * dspExecutable,
     }
 
     /*
-     *  Allocate the data buffer to be used for the application.
+     *  Allocate the data buffers to be used for the application.
      */
-    if (DSP_SUCCEEDED (status)) 
+    for (i = 0 ; (i < DATA_NUM_BUFS) && DSP_SUCCEEDED (status) ; i++)
 	{
         status = POOL_alloc (POOL_makePoolId(processorId, SAMPLE_POOL_ID),
-                             (Void **) &pool_notify_DataBuf,
+                             (Void **) &pool_notify_DataBuf [i],
                              pool_notify_BufferSize) ;
 
         /* Get the translated DSP address to be sent to the DSP. */
@@ -260,8 +1384,9 @@ NORMAL_API DSP_STATUS pool_notify_Create (	IN Char8 * dspExecutable,
                                    POOL_makePoolId(processorId, SAMPLE_POOL_ID),
                                          &dspDataBuf,
                                          AddrType_Dsp,
-                                         (Void *) pool_notify_DataBuf,
+                                         (Void *) pool_notify_DataBuf [i],
                                          AddrType_Usr) ;
+            pool_notify_DataDspBuf [i] = (Uint32) dspDataBuf ;
 
             if (DSP_FAILED (status)) 
 			{
@@ -276,6 +1401,111 @@ NORMAL_API DSP_STATUS pool_notify_Create (	IN Char8 * dspExecutable,
         }
     }
 
+    /*
+     *  Allocate the band buffers used to stream images to the DSP.
+     */
+    for (i = 0 ; (i < STREAM_NUM_BUFS) && DSP_SUCCEEDED (status) ; i++)
+	{
+        status = POOL_alloc (POOL_makePoolId(processorId, SAMPLE_POOL_ID),
+                             (Void **) &pool_notify_StreamBuf [i],
+                             pool_notify_StreamBufSize) ;
+        if (DSP_SUCCEEDED (status)) 
+		{
+            status = POOL_translateAddr (
+                                   POOL_makePoolId(processorId, SAMPLE_POOL_ID),
+                                         &dspStreamBuf,
+                                         AddrType_Dsp,
+                                         (Void *) pool_notify_StreamBuf [i],
+                                         AddrType_Usr) ;
+            pool_notify_StreamDspBuf [i] = (Uint32) dspStreamBuf ;
+            if (DSP_FAILED (status)) 
+			{
+                printf ("POOL_translateAddr () StreamBuf failed."
+                                 " Status = [0x%x]\n",
+                                 (int)status) ;
+            }
+        }
+        else 
+		{
+            printf ("POOL_alloc() StreamBuf failed. Status = [0x%x]\n",(int)status);
+        }
+    }
+
+    /*
+     *  Allocate the command buffer the DSP receives its commands through.
+     */
+    if (DSP_SUCCEEDED (status)) 
+	{
+        status = POOL_alloc (POOL_makePoolId(processorId, SAMPLE_POOL_ID),
+                             (Void **) &pool_notify_CmdBuf,
+                             CMD_BUF_SIZE) ;
+        if (DSP_SUCCEEDED (status)) 
+		{
+            status = POOL_translateAddr (
+                                   POOL_makePoolId(processorId, SAMPLE_POOL_ID),
+                                         &dspCmdBuf,
+                                         AddrType_Dsp,
+                                         (Void *) pool_notify_CmdBuf,
+                                         AddrType_Usr) ;
+            pool_notify_CmdDspBuf = (Uint32) dspCmdBuf ;
+            if (DSP_FAILED (status)) 
+			{
+                printf ("POOL_translateAddr () CmdBuf failed."
+                                 " Status = [0x%x]\n",
+                                 (int)status) ;
+            }
+        }
+        else 
+		{
+            printf ("POOL_alloc() CmdBuf failed. Status = [0x%x]\n",(int)status);
+        }
+    }
+
+    /*
+     *  Allocate the ring buffer and lay the two rings out in it.
+     */
+    if (DSP_SUCCEEDED (status) && (pool_notify_RingSlots > 0))
+	{
+        status = POOL_alloc (POOL_makePoolId(processorId, SAMPLE_POOL_ID),
+                             (Void **) &pool_notify_RingBuf,
+                             pool_notify_RingBufSize) ;
+        if (DSP_SUCCEEDED (status)) 
+		{
+            status = POOL_translateAddr (
+                                   POOL_makePoolId(processorId, SAMPLE_POOL_ID),
+                                         &dspRingBuf,
+                                         AddrType_Dsp,
+                                         (Void *) pool_notify_RingBuf,
+                                         AddrType_Usr) ;
+            pool_notify_RingDspBuf = (Uint32) dspRingBuf ;
+            if (DSP_FAILED (status)) 
+			{
+                printf ("POOL_translateAddr () RingBuf failed."
+                                 " Status = [0x%x]\n",
+                                 (int)status) ;
+            }
+        }
+        else 
+		{
+            printf ("POOL_alloc() RingBuf failed. Status = [0x%x]\n",(int)status);
+        }
+    }
+    if (DSP_SUCCEEDED (status) && (pool_notify_RingSlots > 0))
+	{
+        pool_notify_ringInit () ;
+        sem_init (&pool_notify_RingSem, 0, 0) ;
+        status = NOTIFY_register (processorId,
+                                  pool_notify_IPS_ID,
+                                  pool_notify_RING_EVENTNO,
+                                  (FnNotifyCbck) pool_notify_RingNotify,
+                                  0) ;
+        if (DSP_FAILED (status)) 
+		{
+            printf ("NOTIFY_register () ring failed Status = [0x%x]\n",
+                             (int)status) ;
+        }
+    }
+
     /*
      *  Register for notification that the DSP-side application setup is
      *  complete.
@@ -325,28 +1555,43 @@ NORMAL_API DSP_STATUS pool_notify_Create (	IN Char8 * dspExecutable,
      *  when it is ready to proceed with further execution of the application.
      */
     if (DSP_SUCCEEDED (status)) {
-        // wait for initialization 
-        sem_wait(&sem);
+        // wait for initialization, which the DSP notifies as sequence number zero
+        if (pool_notify_waitSeq (0, COMMAND_TIMEOUT_MS)) {
+            pool_notify_Running = TRUE ;
+        }
+        else {
+            status = DSP_EFAIL ;
+            printf ("The DSP did not complete its setup within %d ms.\n", COMMAND_TIMEOUT_MS) ;
+        }
     }
 
     /*
-     *  Send notifications to the DSP with information about the address of the
-     *  control structure and data buffer to be used by the application.
-     *
+     *  Have the DSP allocate the buffers of the tiles it smooths frames in.
      */
-     
-    #ifdef prints
-	printf("Send data buffer\n"); 
-	#endif
-    status = NOTIFY_notify (processorId,
-                            pool_notify_IPS_ID,
-                            pool_notify_IPS_EVENTNO,
-                            (Uint32) dspDataBuf);
-    if (DSP_FAILED (status)) 
-	{
-        printf ("NOTIFY_notify () DataBuf failed."
-                " Status = [0x%x]\n",
-                 (int)status) ;
+    if (DSP_SUCCEEDED (status)) {
+        pool_notify_newCommand (0, CMD_CONFIG, DSP_TILE_ROWS, DSP_TILE_COLS, NULL, 0) ;
+        if (!pool_notify_runCommand (0, processorId)) {
+            status = DSP_EFAIL ;
+        }
+        else if (pool_notify_commandStatus (0, processorId) != CMD_STATUS_OK) {
+            status = DSP_EMEMORY ;
+            printf ("DSP tile buffers of %dx%d failed.\n", DSP_TILE_COLS, DSP_TILE_ROWS) ;
+        }
+    }
+
+    /*
+     *  Hand the rings to the DSP.
+     */
+    if (DSP_SUCCEEDED (status) && (pool_notify_RingSlots > 0)) {
+        pool_notify_newCommand (0, CMD_RING_OPEN, 0, 0, NULL, 0) ;
+        pool_notify_cmd (0)->buf = pool_notify_RingDspBuf ;
+        pool_notify_cmd (0)->outOffset = (Uint8 *) pool_notify_RingResults - pool_notify_RingBuf ;
+        if (!pool_notify_runCommand (0, processorId)) {
+            status = DSP_EFAIL ;
+        }
+        else {
+            pool_notify_commandStatus (0, processorId) ;
+        }
     }
 
  	#ifdef prints
@@ -372,11 +1617,21 @@ NORMAL_API Void pool_notify_Delete (Uint8 processorId)
 {
     DSP_STATUS status    = DSP_SOK ;
     DSP_STATUS tmpStatus = DSP_SOK ;
+    Uint32     i ;
 
 	#ifdef prints
      printf ("Entered pool_notify_Delete ()\n") ;
 	#endif
 
+    /*
+     *  End the command loop of the DSP-side application.
+     */
+    if (pool_notify_Running) {
+        pool_notify_newCommand (0, CMD_SHUTDOWN, 0, 0, NULL, 0) ;
+        pool_notify_runCommand (0, processorId) ; // PROC_stop () stops it either way
+        pool_notify_Running = FALSE ;
+    }
+
     /*
      *  Stop execution on DSP.
      */
@@ -400,17 +1655,57 @@ NORMAL_API Void pool_notify_Delete (Uint8 processorId)
     }
 
     /*
-     *  Free the memory allocated for the data buffer.
+     *  Free the memory allocated for the data buffers.
      */
+    for (i = 0 ; i < DATA_NUM_BUFS ; i++) {
+        tmpStatus = POOL_free (POOL_makePoolId(processorId, SAMPLE_POOL_ID),
+                               (Void *) pool_notify_DataBuf [i],
+                               pool_notify_BufferSize) ;
+        if (DSP_SUCCEEDED (status) && DSP_FAILED (tmpStatus)) {
+            status = tmpStatus ;
+            printf ("POOL_free () DataBuf failed. Status = [0x%x]\n",
+                             (int)status) ;
+        }
+    }
+
+    for (i = 0 ; i < STREAM_NUM_BUFS ; i++) {
+        tmpStatus = POOL_free (POOL_makePoolId(processorId, SAMPLE_POOL_ID),
+                               (Void *) pool_notify_StreamBuf [i],
+                               pool_notify_StreamBufSize) ;
+        if (DSP_SUCCEEDED (status) && DSP_FAILED (tmpStatus)) {
+            status = tmpStatus ;
+            printf ("POOL_free () StreamBuf failed. Status = [0x%x]\n",
+                             (int)status) ;
+        }
+    }
+
     tmpStatus = POOL_free (POOL_makePoolId(processorId, SAMPLE_POOL_ID),
-                           (Void *) pool_notify_DataBuf,
-                           pool_notify_BufferSize) ;
+                           (Void *) pool_notify_CmdBuf,
+                           CMD_BUF_SIZE) ;
     if (DSP_SUCCEEDED (status) && DSP_FAILED (tmpStatus)) {
         status = tmpStatus ;
-        printf ("POOL_free () DataBuf failed. Status = [0x%x]\n",
+        printf ("POOL_free () CmdBuf failed. Status = [0x%x]\n",
                          (int)status) ;
     }
 
+    if (pool_notify_RingBuf != NULL) {
+        NOTIFY_unregister (processorId,
+                           pool_notify_IPS_ID,
+                           pool_notify_RING_EVENTNO,
+                           (FnNotifyCbck) pool_notify_RingNotify,
+                           0) ;
+        sem_destroy (&pool_notify_RingSem) ;
+        tmpStatus = POOL_free (POOL_makePoolId(processorId, SAMPLE_POOL_ID),
+                               (Void *) pool_notify_RingBuf,
+                               pool_notify_RingBufSize) ;
+        if (DSP_SUCCEEDED (status) && DSP_FAILED (tmpStatus)) {
+            status = tmpStatus ;
+            printf ("POOL_free () RingBuf failed. Status = [0x%x]\n",
+                             (int)status) ;
+        }
+        pool_notify_RingBuf = NULL ;
+    }
+
     /*
      *  Close the pool
      */
@@ -471,6 +1766,20 @@ NORMAL_API Void pool_notify_Main (IN Char8 * dspExecutable, IN Char8 * strBuffer
          */
         pool_notify_BufferSize = DSPLINK_ALIGN ( atoi (strBufferSize),
                                              DSPLINK_BUF_ALIGN) ;
+        if (pool_notify_BufferSize != 0 && pool_notify_BufferSize < pool_notify_frameSize (row, col)) {
+            pool_notify_BufferSize = DSPLINK_ALIGN (pool_notify_frameSize (row, col),
+                                                    DSPLINK_BUF_ALIGN) ;
+        }
+        pool_notify_StreamBufSize = DSPLINK_ALIGN (  col * (3 * STREAM_MIN_BAND_ROWS + CMD_KERNEL_MAX)
+                                                   + DSPLINK_BUF_ALIGN,
+                                                   DSPLINK_BUF_ALIGN) ;
+        if (pool_notify_StreamBufSize < STREAM_BUF_SIZE) {
+            pool_notify_StreamBufSize = STREAM_BUF_SIZE ;
+        }
+        if (pool_notify_RingSlots > 0) {
+            pool_notify_RingBufSize = pool_notify_ringOffset (row, col)
+                                    + RING_HEADER_SIZE + pool_notify_RingSlots * pool_notify_resultSlotSize (row, col) ;
+        }
 		#ifdef prints
         printf(" Allocated a buffer of %d bytes\n",(int)pool_notify_BufferSize );
 		#endif
@@ -506,7 +1815,7 @@ NORMAL_API Void pool_notify_Main (IN Char8 * dspExecutable, IN Char8 * strBuffer
  *
  *  @desc   This function implements the event callback registered with the
  *          NOTIFY component to receive notification indicating that the DSP-
- *          side application has completed its setup phase.
+ *          side application has completed its setup phase or a command.
  *
  *  @modif  None
  *  ----------------------------------------------------------------------------
@@ -516,15 +1825,39 @@ STATIC Void pool_notify_Notify (Uint32 eventNo, Pvoid arg, Pvoid info)
 	#ifdef prints
     printf("Notification %8d \n", (int)info);
 	#endif
-    /* Post the semaphore. */
-    if((int)info==0) 
-	{
+    /* Zero announces the end of the DSP setup, anything else is the sequence
+     * number of a completed command. */
+    pthread_mutex_lock(&pool_notify_QueueLock);
+    pool_notify_DoneSeq = (Uint32) info ;
+    if (   (pool_notify_QueueHead != NULL)
+        && (pool_notify_QueueHead->stage == POOL_NOTIFY_STAGE_RUNNING)
+        && (pool_notify_QueueHead->seq == (Uint32) info)) {
+        /* The command belongs to an asynchronous request */
+        pool_notify_completeRequest();
+    }
+    else {
         sem_post(&sem);
-    } 
-    else 
-	{
-        printf(" Result on DSP is %d \n", (int)info);
     }
+    pthread_mutex_unlock(&pool_notify_QueueLock);
+}
+
+
+/** ----------------------------------------------------------------------------
+ *  @func   pool_notify_RingNotify
+ *
+ *  @desc   This function implements the event callback of the ring doorbell.
+ *          The DSP rings it after each frame it has taken off the frame ring
+ *          and added to the result ring.
+ *
+ *  @modif  None
+ *  ----------------------------------------------------------------------------
+ */
+STATIC Void pool_notify_RingNotify (Uint32 eventNo, Pvoid arg, Pvoid info)
+{
+    (Void) eventNo ;
+    (Void) arg ;
+    (Void) info ;
+    sem_post (&pool_notify_RingSem) ;
 }
 
 
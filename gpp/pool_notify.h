@@ -2,6 +2,8 @@
 #define pool_notify_H
 
 #include<stdint.h>
+#include<semaphore.h>
+#include<time.h>
 
 /*  ----------------------------------- DSP/BIOS Link                 */
 #include <dsplink.h>
@@ -14,12 +16,572 @@
  *  ============================================================================
  */
 #define ID_PROCESSOR       0
+
+/** ============================================================================
+ *  @const  MEM_SIZE
+ *
+ *  @desc   Smallest size of the data buffer. Sessions whose frames need more
+ *          allocate a larger one.
+ *  ============================================================================
+ */
 #define MEM_SIZE 425984
-void pool_notify_dimensions(void);
-void pool_notify_kernel(uint16_t* kernel,int windowsize, Uint8 processorId);
-void pool_notify_image(unsigned char* c, int windowsize, Uint8 processorId);
-uint16_t* pool_notify_getImage(Uint8 processorId);
 
+/** ============================================================================
+ *  @const  DATA_NUM_BUFS
+ *
+ *  @desc   Number of data buffers, all of the same size. Images, requests
+ *          and results hold them by reference and a buffer is reused as soon
+ *          as the last holder lets go of it, so while the GPP works on a
+ *          result left in one of them the DSP smooths the next frames in the
+ *          others.
+ *  ============================================================================
+ */
+#define DATA_NUM_BUFS      2
+
+/** ============================================================================
+ *  @const  DSP_TILE_ROWS, DSP_TILE_COLS
+ *
+ *  @desc   Size of the tiles the DSP smooths a frame in. The DSP allocates
+ *          its tile buffers for this size, plus the widest halo, when the
+ *          session is created. Frames of any size are streamed through them
+ *          in strips of DSP_TILE_COLS columns, or processed tile by tile by
+ *          CMD_BENCH_TILES.
+ *  ============================================================================
+ */
+#define DSP_TILE_ROWS      32
+#define DSP_TILE_COLS      128
+
+/** ============================================================================
+ *  @const  STREAM_NUM_BUFS, STREAM_BUF_SIZE
+ *
+ *  @desc   Number and smallest size of the band buffers used by
+ *          pool_notify_stream (). Must match dsp/pool_notify_config.h.
+ *  ============================================================================
+ */
+#define STREAM_NUM_BUFS    2
+#define STREAM_BUF_SIZE    32768
+
+/** ============================================================================
+ *  @const  RING_NUM_SLOTS
+ *
+ *  @desc   Default number of frames in flight on the streaming rings.
+ *  ============================================================================
+ */
+#define RING_NUM_SLOTS     4
+
+/** ============================================================================
+ *  @const  CMD_NUM_SLOTS, CMD_SLOT_SIZE, CMD_KERNEL_MAX
+ *
+ *  @desc   Number of command blocks in the command buffer, the space taken
+ *          by each (one cache line, so a block is written back and
+ *          invalidated on its own) and the largest kernel a command carries.
+ *          Whole frames, the benchmark, CMD_CONFIG and CMD_RING_OPEN use
+ *          slot 0, band N of a streamed frame slot N % STREAM_NUM_BUFS, so
+ *          there must be a slot for every band buffer.
+ *          Must match dsp/pool_notify_config.h.
+ *  ============================================================================
+ */
+#define CMD_NUM_SLOTS      4
+#define CMD_SLOT_SIZE      128
+#define CMD_KERNEL_MAX     32
+
+#if CMD_NUM_SLOTS < STREAM_NUM_BUFS
+#error "Every band buffer needs a command slot of its own"
+#endif
+
+/** ============================================================================
+ *  @const  CMD_KERNEL_IIR, CMD_IIR_FRAC_BITS
+ *
+ *  @desc   A kernel of CMD_KERNEL_IIR taps, which no Gaussian window has,
+ *          carries the recursive (Young - van Vliet) Gaussian used for large
+ *          sigma instead: the weights of the last three outputs, the second
+ *          one subtracted, and the gain of the input, with CMD_IIR_FRAC_BITS
+ *          fraction bits, each as its low and then its high 16 bits. Its
+ *          cost does not grow with sigma. The recursion runs down whole
+ *          columns, so it only smooths whole frames: CMD_SMOOTH of all rows,
+ *          CMD_EDGES and the frame ring, never CMD_SMOOTH_BAND.
+ *  ============================================================================
+ */
+#define CMD_KERNEL_IIR     8
+#define CMD_IIR_FRAC_BITS  24
+
+/** ============================================================================
+ *  @const  CMD_SMOOTH, CMD_SMOOTH_BAND, CMD_SHUTDOWN, CMD_CONFIG, CMD_EDGES,
+ *          CMD_BENCH, CMD_RING_OPEN
+ *
+ *  @desc   Command opcodes. CMD_SMOOTH smooths the rows [firstRow, firstRow +
+ *          numRows) of a whole frame in the data buffer, writing them at their
+ *          place in the result, scaled by 90 and rounded to integers.
+ *          CMD_SMOOTH_BAND smooths the same rows of a frame streamed in bands.
+ *          CMD_SHUTDOWN ends the DSP command loop. CMD_CONFIG is sent once
+ *          when the session is created; its rows and cols give the tile size
+ *          the DSP allocates its working buffers for. CMD_EDGES smooths a
+ *          whole frame into buf + outOffset, which only the DSP uses, and goes
+ *          on with the derivatives, the gradient magnitude and the non-maximal
+ *          suppression. Only the magnitude (shorts at buf + magOffset) and the
+ *          suppression map (bytes at buf + nmsOffset) are returned. CMD_BENCH
+ *          does the CMD_BENCH_* steps set in numRows on the rows x cols bytes
+ *          at buf + inOffset, for timing the transport and the smoothing; with
+ *          no step set it is a plain round trip. CMD_RING_OPEN hands the DSP
+ *          the frame ring at buf and the result ring at buf + outOffset.
+ *  ============================================================================
+ */
+#define CMD_SMOOTH         1
+#define CMD_SMOOTH_BAND    2
+#define CMD_SHUTDOWN       3
+#define CMD_CONFIG         4
+#define CMD_EDGES          5
+#define CMD_BENCH          6
+#define CMD_RING_OPEN      7
+
+/** ============================================================================
+ *  @const  CMD_BENCH_INV, CMD_BENCH_FILL, CMD_BENCH_WB, CMD_BENCH_SMOOTH,
+ *          CMD_BENCH_COLUMNS, CMD_BENCH_TILES
+ *
+ *  @desc   Steps of CMD_BENCH, done in this order: invalidate the region in
+ *          the DSP cache, write every byte of it, write it back, smooth it as
+ *          an image into buf + outOffset with the kernel of the command.
+ *          CMD_BENCH_TILES has the smoothing blur whole tiles in two passes
+ *          instead of streaming the rows through a line buffer, and
+ *          CMD_BENCH_COLUMNS does the same with the vertical pass walking
+ *          the tiles column by column, for comparison.
+ *  ============================================================================
+ */
+#define CMD_BENCH_INV      1
+#define CMD_BENCH_FILL     2
+#define CMD_BENCH_WB       4
+#define CMD_BENCH_SMOOTH   8
+#define CMD_BENCH_COLUMNS  16
+#define CMD_BENCH_TILES    32
+
+/** ============================================================================
+ *  @const  CMD_STATUS_OK, CMD_STATUS_EINVAL, CMD_STATUS_EOPCODE,
+ *          CMD_STATUS_ENOMEM
+ *
+ *  @desc   Completion status the DSP stores in a command block.
+ *  ============================================================================
+ */
+#define CMD_STATUS_OK      0
+#define CMD_STATUS_EINVAL  1
+#define CMD_STATUS_EOPCODE 2
+#define CMD_STATUS_ENOMEM  3
+
+/** ============================================================================
+ *  @name   Cmd_Block
+ *
+ *  @desc   Command sent to the DSP. The GPP fills a block and notifies its
+ *          DSP address; the DSP sets status and notifies seq back when
+ *          the command is complete. The input rows, haloTop rows above
+ *          firstRow up to haloBottom rows below the last row, are read at
+ *          buf + inOffset and the smoothed rows are written at buf + outOffset.
+ *          The kernel taps are only filled in when kernelId changes; the DSP
+ *          keeps the last kernel it received.
+ *          Must match dsp/pool_notify_config.h.
+ *  ============================================================================
+ */
+typedef struct Cmd_Block_tag {
+    Uint32   opcode ;
+    Uint32   seq ;
+    Uint32   status ;
+    Uint32   rows ;
+    Uint32   cols ;
+    Uint32   firstRow ;
+    Uint32   numRows ;
+    Uint32   haloTop ;
+    Uint32   haloBottom ;
+    Uint32   buf ;
+    Uint32   inOffset ;
+    Uint32   outOffset ;
+    Uint32   windowSize ;
+    Uint32   kernelId ;
+    Uint16   kernel [CMD_KERNEL_MAX] ;
+    Uint32   magOffset ;
+    Uint32   nmsOffset ;
+} Cmd_Block ;
+
+/** ============================================================================
+ *  @const  RING_LINE, RING_HEADER_SIZE
+ *
+ *  @desc   Space taken by each field group of a Ring_Header, one cache line
+ *          of either processor, and by the whole header.
+ *  ============================================================================
+ */
+#define RING_LINE          128
+#define RING_HEADER_SIZE   (3 * RING_LINE)
+
+/** ============================================================================
+ *  @name   Ring_Header
+ *
+ *  @desc   Start of a ring of equal slots in the shared pool. The frame ring
+ *          carries images from the GPP to the DSP, the result ring their
+ *          smoothed images back. Each slot holds a Cmd_Block (CMD_SLOT_SIZE
+ *          bytes) followed by the pixels. Only the producer writes
+ *          writeCount and only the consumer readCount, each in a cache line
+ *          of its own; both count slots since the ring was opened, so the
+ *          ring is empty when they are equal and full when they are
+ *          numSlots apart. Must match dsp/pool_notify_config.h.
+ *  ============================================================================
+ */
+typedef struct Ring_Header_tag {
+    Uint32   numSlots ;
+    Uint32   slotSize ;
+    Uint32   pad0 [RING_LINE / 4 - 2] ;
+    Uint32   writeCount ;
+    Uint32   pad1 [RING_LINE / 4 - 1] ;
+    Uint32   readCount ;
+    Uint32   pad2 [RING_LINE / 4 - 1] ;
+} Ring_Header ;
+
+/** ============================================================================
+ *  @name   pool_notify_Request
+ *
+ *  @desc   Handle of an asynchronous smoothing request. Created by
+ *          pool_notify_submit (), marked done from the NOTIFY callback and
+ *          released by pool_notify_collect (). Its image is copied and its
+ *          outputs taken out on the thread that submits and collects.
+ *  ============================================================================
+ */
+typedef struct pool_notify_Request_tag {
+    unsigned char *  image ;       /* Image to smooth, owned by the caller   */
+    int              rows ;
+    int              cols ;
+    uint16_t *       kernel ;      /* Copy of the gaussian kernel            */
+    int              windowsize ;
+    Uint8            processorId ;
+    uint16_t *       result ;      /* Smoothed image, returned by collect    */
+    int              dspRows ;     /* Rows [0, dspRows) are smoothed by the DSP */
+    int              buf ;         /* Data buffer it runs in, once started   */
+    int              edges ;       /* Submitted by pool_notify_submit_edges () */
+    short *          magnitude ;   /* Gradient magnitude, returned by collect */
+    unsigned char *  nms ;         /* Non-maximal suppression map, likewise  */
+    Uint32           seq ;         /* Sequence number of its DSP command     */
+    struct timespec  sent ;        /* When its DSP command was sent          */
+    double           dspTime ;     /* Milliseconds until the DSP completed it */
+    volatile int     stage ;       /* POOL_NOTIFY_STAGE_*                    */
+    Uint32           status ;      /* Status the DSP left in its command     */
+    int              completed ;   /* Outputs taken by poll or wait          */
+    struct pool_notify_Request_tag * next ;
+} pool_notify_Request ;
+
+#define POOL_NOTIFY_STAGE_QUEUED   0     /* Waiting for a data buffer        */
+#define POOL_NOTIFY_STAGE_READY    1     /* Image ready in its data buffer   */
+#define POOL_NOTIFY_STAGE_RUNNING  2
+#define POOL_NOTIFY_STAGE_DONE     3
+
+#define POOL_NOTIFY_WAIT_FOREVER   (-1)
+
+/** ============================================================================
+ *  @func   pool_notify_dimensions
+ *
+ *  @desc   Sets the dimensions of the frames sent from now on. Frames of any
+ *          size that fits the data buffer can share one DSP session.
+ *  ============================================================================
+ */
+void pool_notify_dimensions(int row, int col);
+
+/** ============================================================================
+ *  @func   pool_notify_frameSize
+ *
+ *  @desc   Returns the size of the data buffer a row x col frame needs, its
+ *          image followed by the smoothed result.
+ *  ============================================================================
+ */
+Uint32 pool_notify_frameSize(int row, int col);
+
+/** ============================================================================
+ *  @func   pool_notify_edgeFrameSize
+ *
+ *  @desc   Returns the size of the data buffer a row x col frame needs for
+ *          pool_notify_submit_edges (): its image, the smoothed scratch
+ *          image, the gradient magnitude and the suppression map.
+ *  ============================================================================
+ */
+Uint32 pool_notify_edgeFrameSize(int row, int col);
+
+uint16_t* pool_notify_stream(unsigned char* image, uint16_t* kernel, int windowsize, Uint8 processorId);
+
+/** ============================================================================
+ *  @func   pool_notify_submit
+ *
+ *  @desc   Queues the smoothing of image on the DSP and returns at once. The
+ *          image must stay valid until the request completes. Requests run
+ *          one after the other in submission order, each in a data buffer
+ *          nothing else holds; a request waits for one to be released when
+ *          its image was not decoded into a data buffer and all of them hold
+ *          images or results.
+ *
+ *  @ret    Request handle, NULL when out of memory or when the kernel is
+ *          longer than CMD_KERNEL_MAX.
+ *  ============================================================================
+ */
+pool_notify_Request* pool_notify_submit(unsigned char* image, uint16_t* kernel, int windowsize, Uint8 processorId);
+
+/** ============================================================================
+ *  @func   pool_notify_submit_rows
+ *
+ *  @desc   Like pool_notify_submit (), but the DSP only smooths the first
+ *          dspRows rows of the image. The caller smooths the other rows at
+ *          the same time, writing them at pool_notify_output (). The queue
+ *          must be empty, and no other request can be submitted until
+ *          this one is collected. dspRows must be a multiple of
+ *          pool_notify_rowAlign (), so both sides never write one cache line,
+ *          and all the rows with a CMD_KERNEL_IIR kernel.
+ *  ============================================================================
+ */
+pool_notify_Request* pool_notify_submit_rows(unsigned char* image, uint16_t* kernel, int windowsize, int dspRows, Uint8 processorId);
+
+/** ============================================================================
+ *  @func   pool_notify_rowAlign
+ *
+ *  @desc   Returns the smallest number of rows of col smoothed pixels that
+ *          fill whole cache lines.
+ *  ============================================================================
+ */
+int pool_notify_rowAlign(int col);
+
+/** ============================================================================
+ *  @func   pool_notify_output
+ *
+ *  @desc   Returns where the smoothed image of a request submitted with
+ *          pool_notify_submit_rows () is written in its data buffer.
+ *  ============================================================================
+ */
+uint16_t* pool_notify_output(pool_notify_Request* req);
+
+/** ============================================================================
+ *  @func   pool_notify_submit_edges
+ *
+ *  @desc   Like pool_notify_submit (), but the DSP also computes the
+ *          derivatives, the gradient magnitude and the non-maximal
+ *          suppression of the smoothed image. Only the magnitude and the
+ *          8-bit suppression map come back, collected with
+ *          pool_notify_collect_edges (). The data buffer must hold
+ *          pool_notify_edgeFrameSize () bytes.
+ *  ============================================================================
+ */
+pool_notify_Request* pool_notify_submit_edges(unsigned char* image, uint16_t* kernel, int windowsize, Uint8 processorId);
+
+/** ============================================================================
+ *  @func   pool_notify_submit_stream
+ *
+ *  @desc   Smooths image with pool_notify_stream () and returns a request that
+ *          is already complete, so both paths can be collected the same way.
+ *  ============================================================================
+ */
+pool_notify_Request* pool_notify_submit_stream(unsigned char* image, uint16_t* kernel, int windowsize, Uint8 processorId);
+
+/** ============================================================================
+ *  @func   pool_notify_poll
+ *
+ *  @desc   Returns 1 when req has completed, 0 otherwise. Never blocks.
+ *  ============================================================================
+ */
+int pool_notify_poll(pool_notify_Request* req);
+
+/** ============================================================================
+ *  @func   pool_notify_wait
+ *
+ *  @desc   Waits at most timeoutMs milliseconds, or forever when timeoutMs is
+ *          POOL_NOTIFY_WAIT_FOREVER, for req to complete.
+ *
+ *  @ret    1 when req has completed, 0 on timeout.
+ *  ============================================================================
+ */
+int pool_notify_wait(pool_notify_Request* req, int timeoutMs);
+
+/** ============================================================================
+ *  @func   pool_notify_collect
+ *
+ *  @desc   Waits for req, releases it and returns the smoothed image, rows x
+ *          cols values scaled by 90 and rounded, or NULL when the DSP rejected
+ *          the command. The image is usually the one the DSP wrote into a
+ *          data buffer, so it is not copied; it is only copied out when the
+ *          next request needed that buffer. The caller hands it back with
+ *          pool_notify_release ().
+ *  ============================================================================
+ */
+uint16_t* pool_notify_collect(pool_notify_Request* req);
+
+/** ============================================================================
+ *  @func   pool_notify_collect_edges
+ *
+ *  @desc   Waits for a request of pool_notify_submit_edges (), releases it
+ *          and returns its gradient magnitude and suppression map, in the
+ *          formats of magnitude_x_y () and non_max_supp (). Like the result
+ *          of pool_notify_collect () they are not copied when no other
+ *          request was queued. The caller hands them back with
+ *          pool_notify_release_edges ().
+ *
+ *  @ret    1 on success, 0 when the DSP rejected the command.
+ *  ============================================================================
+ */
+int pool_notify_collect_edges(pool_notify_Request* req, short** magnitude, unsigned char** nms);
+
+/** ============================================================================
+ *  @func   pool_notify_release_edges
+ *
+ *  @desc   Releases the images returned by pool_notify_collect_edges ().
+ *  ============================================================================
+ */
+void pool_notify_release_edges(short* magnitude, unsigned char* nms);
+
+/** ============================================================================
+ *  @func   pool_notify_release
+ *
+ *  @desc   Releases an image returned by pool_notify_collect () or
+ *          pool_notify_stream (). A data buffer holding an unreleased result
+ *          is not used by other requests.
+ *  ============================================================================
+ */
+void pool_notify_release(uint16_t* result);
+
+/** ============================================================================
+ *  @func   pool_notify_allocImage
+ *
+ *  @desc   Returns storage for a row x col image. When a data buffer is
+ *          idle and large enough the image is placed at its start, so the
+ *          frame can be decoded straight into shared memory and the DSP reads
+ *          it without a copy. Otherwise the image is allocated with malloc ().
+ *
+ *  @ret    The image, NULL when out of memory.
+ *  ============================================================================
+ */
+unsigned char* pool_notify_allocImage(int row, int col);
+
+/** ============================================================================
+ *  @func   pool_notify_freeImage
+ *
+ *  @desc   Releases an image returned by pool_notify_allocImage ().
+ *  ============================================================================
+ */
+void pool_notify_freeImage(unsigned char* image);
+
+/** ============================================================================
+ *  @func   pool_notify_bench
+ *
+ *  @desc   Runs a CMD_BENCH command doing steps, a mask of CMD_BENCH_*, on
+ *          the first size bytes of the first data buffer and waits for it.
+ *          Only for benchmarks: no request may be queued and the buffer must
+ *          not hold an image or a result.
+ *
+ *  @ret    1 on success, 0 when the buffer is in use or too small or the
+ *          DSP rejected the command.
+ *  ============================================================================
+ */
+int pool_notify_bench(Uint32 steps, Uint32 size, Uint8 processorId);
+
+/** ============================================================================
+ *  @func   pool_notify_benchSmooth
+ *
+ *  @desc   Runs a CMD_BENCH command smoothing the row x col image at the
+ *          start of the first data buffer with kernel, doing steps as well,
+ *          and waits for it. Like pool_notify_bench () it leaves the cache
+ *          maintenance of the image and the result to the caller.
+ *
+ *  @ret    GPP address of the smoothed image, NULL when the buffer is in use
+ *          or too small or the DSP rejected the command.
+ *  ============================================================================
+ */
+uint16_t* pool_notify_benchSmooth(Uint32 steps, int row, int col, uint16_t* kernel, int windowsize, Uint8 processorId);
+
+/** ============================================================================
+ *  @func   pool_notify_benchBuffer
+ *
+ *  @desc   Returns the GPP address of the buffer pool_notify_bench () works
+ *          on and stores its size in size.
+ *  ============================================================================
+ */
+Uint8* pool_notify_benchBuffer(Uint32* size);
+
+/** ============================================================================
+ *  @func   pool_notify_writeback, pool_notify_invalidate
+ *
+ *  @desc   POOL_writeback () and POOL_invalidate () on size bytes at p in the
+ *          shared pool.
+ *  ============================================================================
+ */
+void pool_notify_writeback(void* p, Uint32 size, Uint8 processorId);
+void pool_notify_invalidate(void* p, Uint32 size, Uint8 processorId);
+
+/** ============================================================================
+ *  @func   pool_notify_ringSlots
+ *
+ *  @desc   Sets up, when numSlots > 0, a frame ring and a result ring of
+ *          numSlots slots each for the pool_notify_ring_* () functions. Must
+ *          be called before pool_notify_Main (). The rings are not meant to
+ *          be mixed with the requests above.
+ *  ============================================================================
+ */
+void pool_notify_ringSlots(int numSlots);
+
+/** ============================================================================
+ *  @func   pool_notify_ring_allocImage
+ *
+ *  @desc   Returns the image storage of the next free slot of the frame ring,
+ *          waiting while the ring is full. Only one slot is held at a time:
+ *          it is handed to the DSP by pool_notify_ring_send () or given back
+ *          by pool_notify_ring_freeImage ().
+ *
+ *  @ret    The image, NULL when the image does not fit a slot or the DSP
+ *          freed no slot in time.
+ *  ============================================================================
+ */
+unsigned char* pool_notify_ring_allocImage(int row, int col);
+
+/** ============================================================================
+ *  @func   pool_notify_ring_freeImage
+ *
+ *  @desc   Gives back, unsent, the slot of pool_notify_ring_allocImage ().
+ *  ============================================================================
+ */
+void pool_notify_ring_freeImage(unsigned char* image);
+
+/** ============================================================================
+ *  @func   pool_notify_ring_send
+ *
+ *  @desc   Hands the held frame slot to the DSP to be smoothed with kernel.
+ *          No reply is awaited: the result arrives on the result ring.
+ *
+ *  @ret    Sequence number of the frame, 0 when no slot is held or the
+ *          kernel is larger than CMD_KERNEL_MAX taps.
+ *  ============================================================================
+ */
+Uint32 pool_notify_ring_send(uint16_t* kernel, int windowsize);
+
+/** ============================================================================
+ *  @func   pool_notify_ring_wait
+ *
+ *  @desc   Waits at most timeoutMs milliseconds, or forever when timeoutMs is
+ *          POOL_NOTIFY_WAIT_FOREVER, for a result on the result ring.
+ *
+ *  @ret    TRUE when there is one, FALSE on timeout or when the ring is not
+ *          open.
+ *  ============================================================================
+ */
+Bool pool_notify_ring_wait(int timeoutMs);
+
+/** ============================================================================
+ *  @func   pool_notify_ring_receive
+ *
+ *  @desc   Waits at most timeoutMs milliseconds, or forever when timeoutMs is
+ *          POOL_NOTIFY_WAIT_FOREVER, for the oldest result on the result ring
+ *          and stores its dimensions in row and col. The result stays valid
+ *          until pool_notify_ring_release ().
+ *
+ *  @ret    The smoothed image, NULL on timeout, when a result is already
+ *          held or when the DSP failed the frame (its slot is then released).
+ *  ============================================================================
+ */
+uint16_t* pool_notify_ring_receive(int* row, int* col, int timeoutMs);
+
+/** ============================================================================
+ *  @func   pool_notify_ring_release
+ *
+ *  @desc   Hands the slot of the result of pool_notify_ring_receive () back
+ *          to the DSP.
+ *  ============================================================================
+ */
+void pool_notify_ring_release(void);
 
 /** ============================================================================
  *  @func   pool_notify_Create
@@ -96,11 +658,9 @@ pool_notify_Delete (IN Uint8 processorId) ;
  *              Name of the DSP executable file.
  *  @arg    strBufferSize
  *              Buffer size to be used for data-transfer in string format.
- *  @arg    strNumIterations
- *              Number of iterations a data buffer is transferred between
- *              GPP and DSP in string format.
- *  @arg    strProcessorId
- *             ID of the DSP Processor in string format. 
+ *  @arg    row, col
+ *              Largest number of rows and columns of the frames of the
+ *              session. The data and band buffers are enlarged to fit them.
  *
  *  @ret    None
  *
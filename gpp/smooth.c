@@ -0,0 +1,237 @@
+/*******************************************************************************
+* FILE: smooth.c
+* Fixed point gaussian smoothing on the GPP. It computes exactly the values of
+* gaussian_smooth_rows() in dsp/task.c, scaled by 90 like them, so the GPP can
+* smooth part of a frame while the DSP smooths the rest of it, and the kernel
+* both of them smooth with.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "smooth.h"
+/* ----------------------Arm Neon Library for SIMD registers and instructions */
+#if defined (__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* ---------------------------FIXED POINT ARITHMETIC, AS ON THE DSP */
+#define INT_FIXED(number) (((uint16_t)number)<<8)
+#define FLOAT_FIXED(number) (uint16_t)(number*256)
+#define MULTIPLICATION(A,B) (uint16_t)(((uint32_t)A*(uint32_t)B+(1<<(7)))>>8)
+#define DIVISION(A,B) (uint16_t)((((uint32_t)A<<8)+(B/2))/B)
+#define BOOST(q) ((uint16_t)(((uint32_t)(q)*90+128)>>8))
+
+#if defined (__ARM_NEON__)
+/*******************************************************************************
+* PROCEDURE: division_neon
+* PURPOSE: DIVISION(dot, d) of four lanes. The float quotient is off by at most
+* one and is corrected with the remainder, so the result is exact.
+*******************************************************************************/
+static inline uint16x4_t division_neon(uint32x4_t dot, uint32_t d, float32x4_t inv)
+{
+    uint32x4_t n = vaddq_u32(vshlq_n_u32(dot, 8), vdupq_n_u32(d/2));
+    uint32x4_t q = vcvtq_u32_f32(vmulq_f32(vcvtq_f32_u32(n), inv));
+    int32x4_t rem = vreinterpretq_s32_u32(vmlsq_u32(n, q, vdupq_n_u32(d)));
+
+    q = vaddq_u32(q, vandq_u32(vcgeq_s32(rem, vdupq_n_s32((int32_t)d)), vdupq_n_u32(1)));
+    q = vsubq_u32(q, vandq_u32(vcltq_s32(rem, vdupq_n_s32(0)), vdupq_n_u32(1)));
+    return vmovn_u32(q);
+}
+#endif
+
+/*******************************************************************************
+* PROCEDURE: blur_x_columns
+* PURPOSE: Blur the columns [c0, c1) of one image row in the x - direction,
+* renormalizing the kernel where it reaches over the border of the row.
+*******************************************************************************/
+static void blur_x_columns(unsigned char *in, int cols, uint16_t *kernel,
+                           int center, uint16_t *temp, int c0, int c1)
+{
+    int c, cc;
+    uint32_t dot, sum;
+
+    for(c=c0; c<c1; c++)
+    {
+        dot = 0;
+        sum = 0;
+        for(cc=(-center); cc<=center; cc++)
+        {
+            if(((c+cc) >= 0) && ((c+cc) < cols))
+            {
+                dot += MULTIPLICATION(INT_FIXED(in[c+cc]), kernel[center+cc]);
+                sum += kernel[center+cc];
+            }
+        }
+        temp[c] = DIVISION(dot,sum);
+    }
+}
+
+/*******************************************************************************
+* PROCEDURE: blur_x
+* PURPOSE: Blur one image row in the x - direction into temp.
+*******************************************************************************/
+static void blur_x(unsigned char *in, int cols, uint16_t *kernel, int center,
+                   uint16_t *temp)
+{
+#if defined (__ARM_NEON__)
+    int c, cc;
+    uint32_t ksum = 0;
+    uint32x4_t lo, hi;
+    uint16x8_t p;
+    float32x4_t inv;
+
+    for(cc=0; cc<=2*center; cc++) ksum += kernel[cc];
+    inv = vdupq_n_f32(1.0f/(float)ksum);
+
+    /* Columns whose window lies inside the row use the whole kernel */
+    for(c=center; c+8+center<=cols; c+=8)
+    {
+        lo = vdupq_n_u32(0);
+        hi = vdupq_n_u32(0);
+        for(cc=(-center); cc<=center; cc++)
+        {
+            p = vmovl_u8(vld1_u8(in+c+cc));
+            lo = vmlal_n_u16(lo, vget_low_u16(p), kernel[center+cc]);
+            hi = vmlal_n_u16(hi, vget_high_u16(p), kernel[center+cc]);
+        }
+        vst1q_u16(temp+c, vcombine_u16(division_neon(lo, ksum, inv),
+                                       division_neon(hi, ksum, inv)));
+    }
+    if(c == center)
+    {
+        blur_x_columns(in, cols, kernel, center, temp, 0, cols);
+    }
+    else
+    {
+        blur_x_columns(in, cols, kernel, center, temp, 0, center);
+        blur_x_columns(in, cols, kernel, center, temp, c, cols);
+    }
+#else
+    blur_x_columns(in, cols, kernel, center, temp, 0, cols);
+#endif
+}
+
+/*******************************************************************************
+* PROCEDURE: blur_y
+* PURPOSE: Blur one row in the y - direction and scale it by 90. temp points at
+* the blurred row r and taps [lo, hi] around it lie inside the image.
+*******************************************************************************/
+static void blur_y(uint16_t *temp, int cols, uint16_t *kernel, int center,
+                   int lo, int hi, uint16_t *out)
+{
+    int c, rr;
+    uint32_t dot, sum = 0;
+#if defined (__ARM_NEON__)
+    uint32x4_t dlo, dhi;
+    uint16x8_t t;
+    float32x4_t inv;
+#endif
+
+    for(rr=lo; rr<=hi; rr++) sum += kernel[center+rr];
+    c = 0;
+#if defined (__ARM_NEON__)
+    inv = vdupq_n_f32(1.0f/(float)sum);
+    for(; c+8<=cols; c+=8)
+    {
+        dlo = vdupq_n_u32(0);
+        dhi = vdupq_n_u32(0);
+        for(rr=lo; rr<=hi; rr++)
+        {
+            t = vld1q_u16(temp+rr*cols+c);
+            dlo = vaddq_u32(dlo, vrshrq_n_u32(vmull_n_u16(vget_low_u16(t), kernel[center+rr]), 8));
+            dhi = vaddq_u32(dhi, vrshrq_n_u32(vmull_n_u16(vget_high_u16(t), kernel[center+rr]), 8));
+        }
+        /* BOOST(): the rounding narrow adds the 128 before the shift */
+        vst1q_u16(out+c, vcombine_u16(vrshrn_n_u32(vmull_n_u16(division_neon(dlo, sum, inv), 90), 8),
+                                      vrshrn_n_u32(vmull_n_u16(division_neon(dhi, sum, inv), 90), 8)));
+    }
+#endif
+    for(; c<cols; c++)
+    {
+        dot = 0;
+        for(rr=lo; rr<=hi; rr++)
+        {
+            dot += MULTIPLICATION(temp[rr*cols+c],kernel[center+rr]);
+        }
+        out[c] = BOOST(DIVISION(dot,sum));
+    }
+}
+
+/*******************************************************************************
+* PROCEDURE: gaussian_smooth_gpp
+* PURPOSE: Smooth the image rows [firstRow, firstRow+numRows) with the fixed
+* point kernel into out, which holds just those rows. Returns 0 when out of
+* memory, 1 otherwise.
+*******************************************************************************/
+int gaussian_smooth_gpp(unsigned char *image, int rows, int cols,
+                        uint16_t *kernel, int windowsize,
+                        uint16_t *out, int firstRow, int numRows)
+{
+    int r, top, bottom, center, lo, hi;
+    uint16_t *tempim;
+
+    if(numRows <= 0) return 1;
+    center = windowsize / 2;
+    top = (firstRow-center > 0) ? firstRow-center : 0;
+    bottom = (firstRow+numRows+center < rows) ? firstRow+numRows+center : rows;
+    if((tempim = (uint16_t *) malloc((bottom-top)*cols*sizeof(uint16_t))) == NULL)
+    {
+        fprintf(stderr, "Error allocating the GPP smoothing buffer.\n");
+        return 0;
+    }
+
+    /****************************************************************************
+    * Blur in the x - direction the rows and the halo the y - direction needs.
+    ****************************************************************************/
+    for(r=top; r<bottom; r++)
+    {
+        blur_x(image+r*cols, cols, kernel, center, tempim+(r-top)*cols);
+    }
+
+    /****************************************************************************
+    * Blur in the y - direction.
+    ****************************************************************************/
+    for(r=firstRow; r<firstRow+numRows; r++)
+    {
+        lo = (r-center >= 0) ? -center : -r;
+        hi = (r+center < rows) ? center : rows-1-r;
+        blur_y(tempim+(r-top)*cols, cols, kernel, center, lo, hi,
+               out+(r-firstRow)*cols);
+    }
+
+    free(tempim);
+    return 1;
+}
+
+/*******************************************************************************
+* PROCEDURE: make_gaussian_kernel
+* PURPOSE: Create a one dimensional gaussian kernel.
+* NAME: Mike Heath
+* DATE: 2/15/96
+*******************************************************************************/
+void make_gaussian_kernel(float sigma, uint16_t **kernel, int *windowsize)
+{
+    int i, center, x;
+    uint32_t fx, sum = 0;
+
+    *windowsize = 1 + 2 * ceil(2.5 * sigma);
+    center = (*windowsize) / 2;
+
+    if((*kernel = (uint16_t *) malloc((*windowsize)* sizeof(uint16_t))) == NULL)
+    {
+        fprintf(stderr, "Error callocing the gaussian kernel array.\n");
+        exit(1);
+    }
+
+    for(i=0; i<(*windowsize); i++)
+    {
+        x = i - center;
+        fx = FLOAT_FIXED(pow(2.71828, -0.5*x*x/(sigma*sigma)) / (sigma * sqrt(6.2831853))); // convert from float to fixed point
+        (*kernel)[i] = fx;
+        sum += fx;
+    }
+
+    for(i=0; i<(*windowsize); i++) (*kernel)[i] = DIVISION((*kernel)[i], sum);
+}
@@ -0,0 +1,14 @@
+#ifndef SMOOTH_H
+#define SMOOTH_H
+
+#include <stdint.h>
+
+/* The fixed point Gaussian kernel of 1 + 2*ceil(2.5*sigma) taps, allocated */
+void make_gaussian_kernel(float sigma, uint16_t **kernel, int *windowsize);
+/* Smooths the rows [firstRow, firstRow+numRows) of the image into out, as the
+ * DSP does; returns 0 when out of memory */
+int gaussian_smooth_gpp(unsigned char *image, int rows, int cols,
+                        uint16_t *kernel, int windowsize,
+                        uint16_t *out, int firstRow, int numRows);
+
+#endif
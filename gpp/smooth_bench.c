@@ -0,0 +1,158 @@
+/*******************************************************************************
+* FILE: smooth_bench.c
+* Benchmark of the DSP Gaussian smoothing: the same frames are smoothed on the
+* DSP in a single pass through a line buffer, as every frame is, and in two
+* passes over tiles with the vertical pass walking each tile row by row and
+* column by column, as it used to. All of them must give the same image; the
+* table gives their times and the speedups of the line buffer.
+*
+* USAGE: smooth_bench [-n iterations] [-s sigma] [dsp_executable]
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+/*  ----------------------------------- DSP/BIOS Link                 */
+#include <dsplink.h>
+/*  ----------------------------------- Application Header            */
+#include <pool_notify.h>
+#include "smooth.h"
+#include "bench_util.h"
+
+/* The sizes of the shared table timed, up to 640x480; the largest of them sizes
+ * the data buffer */
+#define NUM_SIZES 3
+
+/*******************************************************************************
+* PROCEDURE: smooth_times
+* PURPOSE: Smooth the frame in the first data buffer n times with the steps
+* given and store the times, in microseconds net of the median round trip of
+* an empty command, in t. Returns the median.
+*******************************************************************************/
+static double smooth_times(Uint32 steps, int rows, int cols, uint16_t *kernel,
+                           int windowsize, double rtt, double *t, int n)
+{
+    double start;
+    int i;
+
+    for(i = 0; i < n; i++)
+    {
+        start = bench_now_us();
+        if(pool_notify_benchSmooth(steps, rows, cols, kernel, windowsize, ID_PROCESSOR) == NULL)
+        {
+            fprintf(stderr, "The DSP failed to smooth a %dx%d frame.\n", cols, rows);
+            exit(1);
+        }
+        t[i] = bench_now_us() - start - rtt;
+        if(t[i] < 0) t[i] = 0;
+    }
+    bench_sort(t, n);
+    return bench_percentile(t, n, 50);
+}
+
+static void check_same(uint16_t *ref, uint16_t *out, const char *order, int rows, int cols)
+{
+    if(memcmp(ref, out, rows*cols*sizeof(uint16_t)) != 0)
+    {
+        fprintf(stderr, "The %s order and the line buffer smooth the %dx%d frame differently.\n",
+                order, cols, rows);
+        exit(1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    char *dspExecutable = "pool_notify.out";
+    char strBufferSize[32];
+    int n = 50, opt, i, k, rows, cols, windowsize;
+    float sigma = 2.5;
+    uint16_t *kernel, *out, *ref;
+    Uint32 bufSize;
+    Uint8 *buf;
+    double *t, rtt, byLines, byRows, byColumns;
+
+    while((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': n = atoi(optarg); break;
+            case 's': sigma = atof(optarg); break;
+            default: n = 0; break;
+        }
+    }
+    if(n <= 0 || sigma <= 0 || argc - optind > 1)
+    {
+        fprintf(stderr,"\n<USAGE> %s [-n iterations] [-s sigma] [dsp_executable]\n",argv[0]);
+        fprintf(stderr,"\n      -n:  Repetitions of every measurement (50).\n");
+        fprintf(stderr,"      -s:  Standard deviation of the Gaussian kernel (2.5).\n");
+        exit(1);
+    }
+    if(optind < argc) dspExecutable = argv[optind];
+    make_gaussian_kernel(sigma, &kernel, &windowsize);
+    if(windowsize > CMD_KERNEL_MAX)
+    {
+        fprintf(stderr, "The kernel of sigma %.2f does not fit a DSP command.\n", sigma);
+        exit(1);
+    }
+
+    rows = benchRows[NUM_SIZES-1];
+    cols = benchCols[NUM_SIZES-1];
+    if((t = (double *) malloc(n*sizeof(double))) == NULL
+       || (ref = (uint16_t *) malloc(rows*cols*sizeof(uint16_t))) == NULL)
+    {
+        fprintf(stderr, "Error allocating the benchmark buffers.\n");
+        exit(1);
+    }
+    sprintf(strBufferSize, "%u", (unsigned) pool_notify_frameSize(rows, cols));
+    pool_notify_Main(dspExecutable, strBufferSize, rows, cols);
+    buf = pool_notify_benchBuffer(&bufSize);
+
+    for(i = 0; i < n; i++)
+    {
+        t[i] = bench_now_us();
+        pool_notify_bench(0, 0, ID_PROCESSOR);
+        t[i] = bench_now_us() - t[i];
+    }
+    bench_sort(t, n);
+    rtt = bench_percentile(t, n, 50);
+
+    printf("%d samples per line, window %d, times in usec net of a %.1f usec round trip\n", n, windowsize, rtt);
+    printf("%-9s %11s %9s %9s %9s %9s %9s\n", "order", "frame", "min", "p50", "p90", "max", "Mpix/s");
+    for(k = 0; k < NUM_SIZES; k++)
+    {
+        rows = benchRows[k];
+        cols = benchCols[k];
+        srand(k + 1);
+        for(i = 0; i < rows*cols; i++) buf[i] = (Uint8) rand();
+        pool_notify_writeback(buf, rows*cols, ID_PROCESSOR);
+
+        byLines = smooth_times(CMD_BENCH_SMOOTH, rows, cols, kernel, windowsize, rtt, t, n);
+        bench_report("lines", rows, cols, t, n);
+        printf("\n");
+        out = pool_notify_benchSmooth(0, rows, cols, kernel, windowsize, ID_PROCESSOR);
+        pool_notify_invalidate(out, rows*cols*sizeof(uint16_t), ID_PROCESSOR);
+        memcpy(ref, out, rows*cols*sizeof(uint16_t));
+
+        byRows = smooth_times(CMD_BENCH_TILES, rows, cols, kernel, windowsize, rtt, t, n);
+        bench_report("rows", rows, cols, t, n);
+        printf("\n");
+        pool_notify_invalidate(out, rows*cols*sizeof(uint16_t), ID_PROCESSOR);
+        check_same(ref, out, "rows", rows, cols);
+
+        byColumns = smooth_times(CMD_BENCH_COLUMNS, rows, cols, kernel, windowsize, rtt, t, n);
+        bench_report("columns", rows, cols, t, n);
+        printf("\n");
+        pool_notify_invalidate(out, rows*cols*sizeof(uint16_t), ID_PROCESSOR);
+        check_same(ref, out, "columns", rows, cols);
+        if(byLines > 0) printf("%-9s %5dx%-5d %9.2fx %9.2fx\n", "speedup", cols, rows,
+                               byRows / byLines, byColumns / byLines);
+    }
+
+    pool_notify_Delete(ID_PROCESSOR);
+    free(kernel);
+    free(ref);
+    free(t);
+    return 0;
+}
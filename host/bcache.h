@@ -0,0 +1,26 @@
+/** ============================================================================
+ *  @file   bcache.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in for the DSP/BIOS BCACHE module. Host caches are
+ *          coherent, so the maintenance operations have nothing to do.
+ *  ============================================================================
+ */
+
+
+#if !defined (BCACHE_H)
+#define BCACHE_H
+
+#include <std.h>
+
+
+#define BCACHE_inv(blockPtr, byteCnt, wait)                                   \
+            ((Void) (blockPtr), (Void) (byteCnt), (Void) (wait))
+#define BCACHE_wb(blockPtr, byteCnt, wait)                                    \
+            ((Void) (blockPtr), (Void) (byteCnt), (Void) (wait))
+#define BCACHE_wbInv(blockPtr, byteCnt, wait)                                 \
+            ((Void) (blockPtr), (Void) (byteCnt), (Void) (wait))
+
+
+#endif /* !defined (BCACHE_H) */
@@ -0,0 +1,115 @@
+/** ============================================================================
+ *  @file   dsplink.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in for the DSP/BIOS LINK headers. Only the subset of
+ *          the GPP and DSP side interfaces used by pool_notify is provided.
+ *          Both sides of the application are built against these headers
+ *          and linked into a single Linux process: the DSP executable runs
+ *          on a worker thread, the POOL is an ordinary memory mapping and
+ *          NOTIFY events are delivered by calling the registered callback.
+ *  ============================================================================
+ */
+
+
+#if !defined (DSPLINK_H)
+#define DSPLINK_H
+
+#include <stddef.h>
+
+
+#if defined (__cplusplus)
+extern "C" {
+#endif /* defined (__cplusplus) */
+
+
+/*  ============================================================================
+ *  Basic types, shared by the GPP and DSP side of the application.
+ *  ============================================================================
+ */
+typedef void               Void ;
+typedef void *             Pvoid ;
+typedef char               Char8 ;
+typedef signed char        Int8 ;
+typedef unsigned char      Uint8 ;
+typedef short              Int16 ;
+typedef unsigned short     Uint16 ;
+typedef int                Int32 ;
+typedef unsigned int       Uint32 ;
+typedef unsigned short     Bool ;
+
+#define TRUE               1
+#define FALSE              0
+
+#define IN
+#define OUT
+#define OPT
+#define CONST              const
+#define STATIC             static
+#define EXTERN             extern
+#define NORMAL_API
+
+/** ============================================================================
+ *  @name   DSP_STATUS
+ *
+ *  @desc   Status codes returned by the GPP side API. Success codes are
+ *          non-negative so that they compare equal to the DSP side SYS_OK.
+ *  ============================================================================
+ */
+typedef Int32              DSP_STATUS ;
+
+#define DSP_SOK            0
+#define DSP_EFAIL          (-1)
+#define DSP_EINVALIDARG    (-2)
+#define DSP_EMEMORY        (-3)
+#define DSP_ENOTFOUND      (-4)
+#define DSP_EALREADYCONNECTED (-5)
+#define DSP_ERESOURCE      (-6)
+
+#define DSP_SUCCEEDED(status)   ((Int32) (status) >= 0)
+#define DSP_FAILED(status)      (!DSP_SUCCEEDED (status))
+
+/** ============================================================================
+ *  @const  MAX_PROCESSORS, ID_GPP
+ *
+ *  @desc   Processor identifiers. The DSP is processor 0, the GPP is ID_GPP.
+ *  ============================================================================
+ */
+#if !defined (MAX_PROCESSORS)
+#define MAX_PROCESSORS     2
+#endif
+
+#if !defined (ID_GPP)
+#define ID_GPP             1
+#endif
+
+/** ============================================================================
+ *  @const  DSPLINK_BUF_ALIGN, DSPLINK_SEGID
+ *
+ *  @desc   Buffer alignment used by POOL and the memory segment the DSP side
+ *          allocates its private data from.
+ *  ============================================================================
+ */
+#define DSPLINK_BUF_ALIGN  128
+#define DSPLINK_SEGID      0
+
+#define DSPLINK_ALIGN(addr, align)                                            \
+            ((((Uint32) (addr)) + (((Uint32) (align)) - 1))                   \
+             & ~(((Uint32) (align)) - 1))
+
+/** ============================================================================
+ *  @func   DSPLINK_init
+ *
+ *  @desc   DSP side initialization of the link. Nothing to do on the host.
+ *  ============================================================================
+ */
+Void DSPLINK_init (Void) ;
+
+
+#if defined (__cplusplus)
+}
+#endif /* defined (__cplusplus) */
+
+
+#endif /* !defined (DSPLINK_H) */
@@ -0,0 +1,619 @@
+/** ============================================================================
+ *  @file   dsplink_host.c
+ *
+ *  @path   host/
+ *
+ *  @desc   Host implementation of the DSP/BIOS LINK and DSP/BIOS services used
+ *          by pool_notify. The DSP image (dsp/task.c, dsp/dsp_main.c) is
+ *          linked into the GPP executable with its main () renamed to
+ *          DSP_main (); PROC_start () runs it on a worker thread.
+ *  ============================================================================
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+/*  ----------------------------------- Host DSP/BIOS LINK              */
+#include <dsplink.h>
+#include <proc.h>
+#include <pool.h>
+#include <notify.h>
+
+/*  ----------------------------------- Host DSP/BIOS                   */
+#include <std.h>
+#include <sys.h>
+#include <sem.h>
+#include <tsk.h>
+
+
+#if defined (__cplusplus)
+extern "C" {
+#endif /* defined (__cplusplus) */
+
+
+/** ============================================================================
+ *  @const  HOST_MAX_EVENTS
+ *
+ *  @desc   Number of NOTIFY events supported per processor.
+ *  ============================================================================
+ */
+#define HOST_MAX_EVENTS                32
+
+/** ============================================================================
+ *  @const  HOST_MAX_POOLS, HOST_MAX_BUFS
+ *
+ *  @desc   Number of pools that can be open at once and number of buffers
+ *          per pool.
+ *  ============================================================================
+ */
+#define HOST_MAX_POOLS                 4
+#define HOST_MAX_BUFS                  64
+
+/** ============================================================================
+ *  @const  HOST_MAX_ARGS, HOST_MAX_TASKS
+ *
+ *  @desc   Maximum number of arguments passed to the DSP main () and of tasks
+ *          it can create.
+ *  ============================================================================
+ */
+#define HOST_MAX_ARGS                  8
+#define HOST_MAX_TASKS                 4
+
+
+/** ============================================================================
+ *  @func   DSP_main
+ *
+ *  @desc   Entry point of the DSP image, dsp_main.c built with main renamed.
+ *  ============================================================================
+ */
+extern Void DSP_main (Int argc, Char * argv []) ;
+
+
+/*  ============================================================================
+ *  @name   HOST_NotifyEntry
+ *
+ *  @desc   Callback registered for an event on one processor.
+ *  ============================================================================
+ */
+typedef struct HOST_NotifyEntry_tag {
+    FnNotifyCbck fnNotifyCbck ;
+    Pvoid        cbckArg ;
+} HOST_NotifyEntry ;
+
+/*  ============================================================================
+ *  @name   HOST_Pool
+ *
+ *  @desc   State of one open pool: a single mapping carved into buffers.
+ *  ============================================================================
+ */
+typedef struct HOST_Pool_tag {
+    PoolId   poolId ;
+    Bool     isOpen ;
+    Bool     exactMatchReq ;
+    Uint8 *  base ;
+    size_t   length ;
+    Uint32   numBufs ;
+    Uint8 *  bufAddr [HOST_MAX_BUFS] ;
+    Uint32   bufSize [HOST_MAX_BUFS] ;
+    Bool     bufUsed [HOST_MAX_BUFS] ;
+} HOST_Pool ;
+
+
+STATIC pthread_mutex_t  HOST_lock = PTHREAD_MUTEX_INITIALIZER ;
+
+/*  Callbacks indexed by the processor that receives the event. */
+STATIC HOST_NotifyEntry HOST_notifyTable [MAX_PROCESSORS][HOST_MAX_EVENTS] ;
+
+STATIC HOST_Pool        HOST_pools [HOST_MAX_POOLS] ;
+
+STATIC pthread_t        HOST_dspThread ;
+STATIC Bool             HOST_dspRunning = FALSE ;
+STATIC Int              HOST_dspArgc = 0 ;
+STATIC Char *           HOST_dspArgv [HOST_MAX_ARGS + 1] ;
+
+STATIC Fxn              HOST_tasks [HOST_MAX_TASKS] ;
+STATIC Int              HOST_numTasks = 0 ;
+
+
+/*  ============================================================================
+ *  NOTIFY
+ *  ============================================================================
+ */
+
+/*  The processor ID handed to NOTIFY names the remote end. A callback
+ *  registered for events from procId is therefore owned by the other
+ *  processor, and an event sent to procId is delivered to procId itself.
+ */
+STATIC Uint32 HOST_localProc (Uint32 remoteProcId)
+{
+    return (remoteProcId == ID_GPP) ? 0 : ID_GPP ;
+}
+
+DSP_STATUS NOTIFY_register (IN Uint32       procId,
+                            IN Uint32       ipsId,
+                            IN Uint32       eventNo,
+                            IN FnNotifyCbck fnNotifyCbck,
+                            IN Pvoid        cbckArg)
+{
+    HOST_NotifyEntry * entry ;
+
+    (Void) ipsId ;
+    if ((procId >= MAX_PROCESSORS) || (eventNo >= HOST_MAX_EVENTS)
+        || (fnNotifyCbck == NULL)) {
+        return DSP_EINVALIDARG ;
+    }
+
+    pthread_mutex_lock (&HOST_lock) ;
+    entry = &HOST_notifyTable [HOST_localProc (procId)][eventNo] ;
+    entry->fnNotifyCbck = fnNotifyCbck ;
+    entry->cbckArg      = cbckArg ;
+    pthread_mutex_unlock (&HOST_lock) ;
+
+    return DSP_SOK ;
+}
+
+DSP_STATUS NOTIFY_unregister (IN Uint32       procId,
+                              IN Uint32       ipsId,
+                              IN Uint32       eventNo,
+                              IN FnNotifyCbck fnNotifyCbck,
+                              IN Pvoid        cbckArg)
+{
+    DSP_STATUS         status = DSP_SOK ;
+    HOST_NotifyEntry * entry ;
+
+    (Void) ipsId ;
+    (Void) cbckArg ;
+    if ((procId >= MAX_PROCESSORS) || (eventNo >= HOST_MAX_EVENTS)) {
+        return DSP_EINVALIDARG ;
+    }
+
+    pthread_mutex_lock (&HOST_lock) ;
+    entry = &HOST_notifyTable [HOST_localProc (procId)][eventNo] ;
+    if (entry->fnNotifyCbck != fnNotifyCbck) {
+        status = DSP_ENOTFOUND ;
+    }
+    else {
+        entry->fnNotifyCbck = NULL ;
+        entry->cbckArg      = NULL ;
+    }
+    pthread_mutex_unlock (&HOST_lock) ;
+
+    return status ;
+}
+
+DSP_STATUS NOTIFY_notify (IN Uint32 procId,
+                          IN Uint32 ipsId,
+                          IN Uint32 eventNo,
+                          IN Uint32 payload)
+{
+    HOST_NotifyEntry entry ;
+
+    (Void) ipsId ;
+    if ((procId >= MAX_PROCESSORS) || (eventNo >= HOST_MAX_EVENTS)) {
+        return DSP_EINVALIDARG ;
+    }
+
+    pthread_mutex_lock (&HOST_lock) ;
+    entry = HOST_notifyTable [procId][eventNo] ;
+    pthread_mutex_unlock (&HOST_lock) ;
+
+    if (entry.fnNotifyCbck == NULL) {
+        return DSP_ENOTFOUND ;
+    }
+
+    /* The payload travels as the info pointer, as it does on the target. */
+    entry.fnNotifyCbck (eventNo, entry.cbckArg, (Pvoid) (uintptr_t) payload) ;
+
+    return DSP_SOK ;
+}
+
+
+/*  ============================================================================
+ *  POOL
+ *  ============================================================================
+ */
+
+STATIC HOST_Pool * HOST_findPool (PoolId poolId)
+{
+    Uint32 i ;
+
+    for (i = 0 ; i < HOST_MAX_POOLS ; i++) {
+        if (HOST_pools [i].isOpen && (HOST_pools [i].poolId == poolId)) {
+            return &HOST_pools [i] ;
+        }
+    }
+    return NULL ;
+}
+
+/*  Maps memory that both "processors" can address with a 32-bit pointer. */
+STATIC Uint8 * HOST_mapShared (size_t length)
+{
+    void * addr ;
+    int    flags = MAP_PRIVATE | MAP_ANONYMOUS ;
+
+#if defined (MAP_32BIT)
+    flags |= MAP_32BIT ;
+#endif
+    addr = mmap (NULL, length, PROT_READ | PROT_WRITE, flags, -1, 0) ;
+    if (addr == MAP_FAILED) {
+        return NULL ;
+    }
+    if ((uintptr_t) addr + length - 1 > (uintptr_t) 0xFFFFFFFFu) {
+        fprintf (stderr, "HOST: shared memory is not 32-bit addressable\n") ;
+        munmap (addr, length) ;
+        return NULL ;
+    }
+    return (Uint8 *) addr ;
+}
+
+DSP_STATUS POOL_open (IN PoolId poolId, IN Pvoid params)
+{
+    SMAPOOL_Attrs * attrs = (SMAPOOL_Attrs *) params ;
+    HOST_Pool *     pool  = NULL ;
+    size_t          length = 0 ;
+    Uint32          i, j, k, size ;
+    Uint8 *         addr ;
+
+    if (attrs == NULL) {
+        return DSP_EINVALIDARG ;
+    }
+    if (HOST_findPool (poolId) != NULL) {
+        return DSP_EALREADYCONNECTED ;
+    }
+    for (i = 0 ; i < HOST_MAX_POOLS ; i++) {
+        if (!HOST_pools [i].isOpen) {
+            pool = &HOST_pools [i] ;
+            break ;
+        }
+    }
+    if (pool == NULL) {
+        return DSP_ERESOURCE ;
+    }
+
+    memset (pool, 0, sizeof (HOST_Pool)) ;
+    for (i = 0 ; i < attrs->numBufPools ; i++) {
+        if (pool->numBufs + attrs->numBuffers [i] > HOST_MAX_BUFS) {
+            return DSP_ERESOURCE ;
+        }
+        pool->numBufs += attrs->numBuffers [i] ;
+        length += (size_t) attrs->numBuffers [i]
+                * DSPLINK_ALIGN (attrs->bufSizes [i], DSPLINK_BUF_ALIGN) ;
+    }
+    if (length == 0) {
+        return DSP_EINVALIDARG ;
+    }
+
+    pool->base = HOST_mapShared (length) ;
+    if (pool->base == NULL) {
+        return DSP_EMEMORY ;
+    }
+    pool->length        = length ;
+    pool->poolId        = poolId ;
+    pool->exactMatchReq = attrs->exactMatchReq ;
+
+    addr = pool->base ;
+    for (i = 0, k = 0 ; i < attrs->numBufPools ; i++) {
+        size = DSPLINK_ALIGN (attrs->bufSizes [i], DSPLINK_BUF_ALIGN) ;
+        for (j = 0 ; j < attrs->numBuffers [i] ; j++, k++) {
+            pool->bufAddr [k] = addr ;
+            pool->bufSize [k] = size ;
+            addr += size ;
+        }
+    }
+    pool->isOpen = TRUE ;
+
+    return DSP_SOK ;
+}
+
+DSP_STATUS POOL_close (IN PoolId poolId)
+{
+    HOST_Pool * pool = HOST_findPool (poolId) ;
+
+    if (pool == NULL) {
+        return DSP_ENOTFOUND ;
+    }
+    munmap (pool->base, pool->length) ;
+    memset (pool, 0, sizeof (HOST_Pool)) ;
+
+    return DSP_SOK ;
+}
+
+DSP_STATUS POOL_alloc (IN PoolId poolId, OUT Pvoid * bufPtr, IN Uint32 size)
+{
+    DSP_STATUS  status = DSP_EMEMORY ;
+    HOST_Pool * pool ;
+    Uint32      i, best = HOST_MAX_BUFS ;
+
+    if (bufPtr == NULL) {
+        return DSP_EINVALIDARG ;
+    }
+
+    pthread_mutex_lock (&HOST_lock) ;
+    pool = HOST_findPool (poolId) ;
+    if (pool == NULL) {
+        status = DSP_ENOTFOUND ;
+    }
+    else {
+        size = DSPLINK_ALIGN (size, DSPLINK_BUF_ALIGN) ;
+        for (i = 0 ; i < pool->numBufs ; i++) {
+            if (pool->bufUsed [i] || (pool->bufSize [i] < size)) {
+                continue ;
+            }
+            if (pool->exactMatchReq && (pool->bufSize [i] != size)) {
+                continue ;
+            }
+            if ((best == HOST_MAX_BUFS)
+                || (pool->bufSize [i] < pool->bufSize [best])) {
+                best = i ;
+            }
+        }
+        if (best != HOST_MAX_BUFS) {
+            pool->bufUsed [best] = TRUE ;
+            *bufPtr = pool->bufAddr [best] ;
+            status  = DSP_SOK ;
+        }
+    }
+    pthread_mutex_unlock (&HOST_lock) ;
+
+    return status ;
+}
+
+DSP_STATUS POOL_free (IN PoolId poolId, IN Pvoid buf, IN Uint32 size)
+{
+    DSP_STATUS  status = DSP_ENOTFOUND ;
+    HOST_Pool * pool ;
+    Uint32      i ;
+
+    (Void) size ;
+    pthread_mutex_lock (&HOST_lock) ;
+    pool = HOST_findPool (poolId) ;
+    if (pool != NULL) {
+        for (i = 0 ; i < pool->numBufs ; i++) {
+            if (pool->bufUsed [i] && (pool->bufAddr [i] == (Uint8 *) buf)) {
+                pool->bufUsed [i] = FALSE ;
+                status = DSP_SOK ;
+                break ;
+            }
+        }
+    }
+    pthread_mutex_unlock (&HOST_lock) ;
+
+    return status ;
+}
+
+DSP_STATUS POOL_translateAddr (IN  PoolId   poolId,
+                               OUT Pvoid *  dstAddr,
+                               IN  AddrType dstAddrType,
+                               IN  Pvoid    srcAddr,
+                               IN  AddrType srcAddrType)
+{
+    HOST_Pool * pool = HOST_findPool (poolId) ;
+
+    (Void) dstAddrType ;
+    (Void) srcAddrType ;
+    if ((pool == NULL) || (dstAddr == NULL)) {
+        return DSP_EINVALIDARG ;
+    }
+    if (   ((Uint8 *) srcAddr < pool->base)
+        || ((Uint8 *) srcAddr >= pool->base + pool->length)) {
+        return DSP_EINVALIDARG ;
+    }
+    /* Both processors see the mapping at the same address. */
+    *dstAddr = srcAddr ;
+
+    return DSP_SOK ;
+}
+
+DSP_STATUS POOL_writeback (IN PoolId poolId, IN Pvoid buf, IN Uint32 size)
+{
+    (Void) poolId ;
+    (Void) buf ;
+    (Void) size ;
+    return DSP_SOK ;
+}
+
+DSP_STATUS POOL_invalidate (IN PoolId poolId, IN Pvoid buf, IN Uint32 size)
+{
+    (Void) poolId ;
+    (Void) buf ;
+    (Void) size ;
+    return DSP_SOK ;
+}
+
+
+/*  ============================================================================
+ *  PROC
+ *  ============================================================================
+ */
+
+STATIC Void * HOST_dspThreadFxn (Void * arg)
+{
+    Int i ;
+
+    (Void) arg ;
+    DSP_main (HOST_dspArgc, HOST_dspArgv) ;
+
+    /* main () has returned: the scheduler starts the tasks it created. */
+    for (i = 0 ; i < HOST_numTasks ; i++) {
+        HOST_tasks [i] () ;
+    }
+
+    return NULL ;
+}
+
+DSP_STATUS PROC_setup (IN Pvoid attrs)
+{
+    (Void) attrs ;
+    return DSP_SOK ;
+}
+
+DSP_STATUS PROC_destroy (Void)
+{
+    return DSP_SOK ;
+}
+
+DSP_STATUS PROC_attach (IN Uint32 procId, IN Pvoid attr)
+{
+    (Void) attr ;
+    return (procId == 0) ? DSP_SOK : DSP_EINVALIDARG ;
+}
+
+DSP_STATUS PROC_detach (IN Uint32 procId)
+{
+    return (procId == 0) ? DSP_SOK : DSP_EINVALIDARG ;
+}
+
+DSP_STATUS PROC_load (IN Uint32  procId,
+                      IN Char8 * imagePath,
+                      IN Uint32  argc,
+                      IN Char8 ** argv)
+{
+    Uint32 i ;
+
+    (Void) imagePath ; /* The DSP image is linked into this executable. */
+    if ((procId != 0) || (argc > HOST_MAX_ARGS)) {
+        return DSP_EINVALIDARG ;
+    }
+
+    for (i = 0 ; i < (Uint32) HOST_dspArgc ; i++) {
+        free (HOST_dspArgv [i]) ;
+    }
+    for (i = 0 ; i < argc ; i++) {
+        HOST_dspArgv [i] = strdup (argv [i]) ;
+    }
+    HOST_dspArgv [argc] = NULL ;
+    HOST_dspArgc  = (Int) argc ;
+    HOST_numTasks = 0 ;
+
+    return DSP_SOK ;
+}
+
+DSP_STATUS PROC_start (IN Uint32 procId)
+{
+    if ((procId != 0) || HOST_dspRunning) {
+        return DSP_EINVALIDARG ;
+    }
+    if (pthread_create (&HOST_dspThread, NULL, HOST_dspThreadFxn, NULL) != 0) {
+        return DSP_EFAIL ;
+    }
+    HOST_dspRunning = TRUE ;
+
+    return DSP_SOK ;
+}
+
+DSP_STATUS PROC_stop (IN Uint32 procId)
+{
+    if ((procId != 0) || !HOST_dspRunning) {
+        return DSP_EINVALIDARG ;
+    }
+    /* A DSP still pending on a semaphore is halted like the real one. */
+    pthread_cancel (HOST_dspThread) ;
+    pthread_join (HOST_dspThread, NULL) ;
+    HOST_dspRunning = FALSE ;
+
+    return DSP_SOK ;
+}
+
+
+/*  ============================================================================
+ *  DSP/BIOS
+ *  ============================================================================
+ */
+
+Void DSPLINK_init (Void)
+{
+}
+
+TSK_Handle TSK_create (Fxn fxn, TSK_Attrs * attrs, ...)
+{
+    (Void) attrs ;
+    if (HOST_numTasks >= HOST_MAX_TASKS) {
+        return NULL ;
+    }
+    HOST_tasks [HOST_numTasks++] = fxn ;
+
+    return fxn ;
+}
+
+Void SEM_new (SEM_Handle sem, Int count)
+{
+    sem_init (&sem->sem, 0, (unsigned int) count) ;
+}
+
+Bool SEM_pend (SEM_Handle sem, Uns timeout)
+{
+    struct timespec deadline ;
+    int             ret ;
+
+    if (timeout == SYS_FOREVER) {
+        do {
+            ret = sem_wait (&sem->sem) ;
+        } while ((ret != 0) && (errno == EINTR)) ;
+    }
+    else if (timeout == 0) {
+        ret = sem_trywait (&sem->sem) ;
+    }
+    else {
+        clock_gettime (CLOCK_REALTIME, &deadline) ;
+        deadline.tv_sec  += timeout / 1000 ;
+        deadline.tv_nsec += (long) (timeout % 1000) * 1000000L ;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++ ;
+            deadline.tv_nsec -= 1000000000L ;
+        }
+        do {
+            ret = sem_timedwait (&sem->sem, &deadline) ;
+        } while ((ret != 0) && (errno == EINTR)) ;
+    }
+
+    return (ret == 0) ? TRUE : FALSE ;
+}
+
+Void SEM_post (SEM_Handle sem)
+{
+    sem_post (&sem->sem) ;
+}
+
+Ptr MEM_alloc (Int segid, size_t size, size_t align)
+{
+    void * addr = NULL ;
+
+    (Void) segid ;
+    if (align < sizeof (void *)) {
+        align = sizeof (void *) ;
+    }
+    if (posix_memalign (&addr, align, size) != 0) {
+        return MEM_ILLEGAL ;
+    }
+    return addr ;
+}
+
+Ptr MEM_calloc (Int segid, size_t size, size_t align)
+{
+    Ptr addr = MEM_alloc (segid, size, align) ;
+
+    if (addr != MEM_ILLEGAL) {
+        memset (addr, 0, size) ;
+    }
+    return addr ;
+}
+
+Bool MEM_free (Int segid, Ptr addr, size_t size)
+{
+    (Void) segid ;
+    (Void) size ;
+    free (addr) ;
+    return TRUE ;
+}
+
+
+#if defined (__cplusplus)
+}
+#endif /* defined (__cplusplus) */
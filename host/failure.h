@@ -0,0 +1,25 @@
+/** ============================================================================
+ *  @file   failure.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in for the DSP/BIOS LINK failure reporting macros.
+ *  ============================================================================
+ */
+
+
+#if !defined (FAILURE_H)
+#define FAILURE_H
+
+#include <stdio.h>
+#include <std.h>
+
+
+#define FID_APP_C          0x600
+
+#define SET_FAILURE_REASON(status)                                            \
+            fprintf (stderr, "DSP failure: file 0x%x line %d status %d\n",    \
+                     FILEID, __LINE__, (int) (status))
+
+
+#endif /* !defined (FAILURE_H) */
@@ -0,0 +1,17 @@
+/** ============================================================================
+ *  @file   gbl.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in, nothing from this header is used by pool_notify.
+ *  ============================================================================
+ */
+
+
+#if !defined (GBL_H)
+#define GBL_H
+
+#include <dsplink.h>
+
+
+#endif /* !defined (GBL_H) */
@@ -0,0 +1,25 @@
+/** ============================================================================
+ *  @file   log.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in for the DSP/BIOS LOG module.
+ *  ============================================================================
+ */
+
+
+#if !defined (LOG_H)
+#define LOG_H
+
+#include <stdio.h>
+#include <std.h>
+
+
+typedef struct LOG_Obj_tag {
+    Int      bufLen ;
+} LOG_Obj ;
+
+#define LOG_printf(log, ...)  ((Void) (log), printf (__VA_ARGS__))
+
+
+#endif /* !defined (LOG_H) */
@@ -0,0 +1,17 @@
+/** ============================================================================
+ *  @file   mpcs.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in, nothing from this header is used by pool_notify.
+ *  ============================================================================
+ */
+
+
+#if !defined (MPCS_H)
+#define MPCS_H
+
+#include <dsplink.h>
+
+
+#endif /* !defined (MPCS_H) */
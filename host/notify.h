@@ -0,0 +1,78 @@
+/** ============================================================================
+ *  @file   notify.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in for the NOTIFY component. The same functions serve
+ *          the GPP and the DSP side: the processor ID passed in names the
+ *          remote processor, exactly as in DSP/BIOS LINK.
+ *  ============================================================================
+ */
+
+
+#if !defined (NOTIFY_H)
+#define NOTIFY_H
+
+#include <dsplink.h>
+
+
+#if defined (__cplusplus)
+extern "C" {
+#endif /* defined (__cplusplus) */
+
+
+/** ============================================================================
+ *  @name   FnNotifyCbck
+ *
+ *  @desc   Signature of the callback invoked when an event is received.
+ *  ============================================================================
+ */
+typedef Void (*FnNotifyCbck) (Uint32 eventNo, Pvoid arg, Pvoid info) ;
+
+/** ============================================================================
+ *  @func   NOTIFY_register
+ *
+ *  @desc   Registers a callback for events sent by processor procId.
+ *  ============================================================================
+ */
+DSP_STATUS
+NOTIFY_register (IN Uint32       procId,
+                 IN Uint32       ipsId,
+                 IN Uint32       eventNo,
+                 IN FnNotifyCbck fnNotifyCbck,
+                 IN Pvoid        cbckArg) ;
+
+/** ============================================================================
+ *  @func   NOTIFY_unregister
+ *
+ *  @desc   Removes a callback registered earlier with NOTIFY_register ().
+ *  ============================================================================
+ */
+DSP_STATUS
+NOTIFY_unregister (IN Uint32       procId,
+                   IN Uint32       ipsId,
+                   IN Uint32       eventNo,
+                   IN FnNotifyCbck fnNotifyCbck,
+                   IN Pvoid        cbckArg) ;
+
+/** ============================================================================
+ *  @func   NOTIFY_notify
+ *
+ *  @desc   Sends event eventNo with a 32-bit payload to processor procId.
+ *          The remote callback runs on the caller's thread before this
+ *          function returns.
+ *  ============================================================================
+ */
+DSP_STATUS
+NOTIFY_notify (IN Uint32 procId,
+               IN Uint32 ipsId,
+               IN Uint32 eventNo,
+               IN Uint32 payload) ;
+
+
+#if defined (__cplusplus)
+}
+#endif /* defined (__cplusplus) */
+
+
+#endif /* !defined (NOTIFY_H) */
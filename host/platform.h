@@ -0,0 +1,17 @@
+/** ============================================================================
+ *  @file   platform.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in, nothing from this header is used by pool_notify.
+ *  ============================================================================
+ */
+
+
+#if !defined (PLATFORM_H)
+#define PLATFORM_H
+
+#include <dsplink.h>
+
+
+#endif /* !defined (PLATFORM_H) */
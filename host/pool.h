@@ -0,0 +1,81 @@
+/** ============================================================================
+ *  @file   pool.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in for the GPP side POOL component. Buffers come from
+ *          one anonymous mapping per pool which is placed below 4 GB, so a
+ *          buffer address still fits in a 32-bit NOTIFY payload. GPP and DSP
+ *          addresses are identical and the caches are coherent.
+ *  ============================================================================
+ */
+
+
+#if !defined (POOL_H)
+#define POOL_H
+
+#include <dsplink.h>
+
+
+#if defined (__cplusplus)
+extern "C" {
+#endif /* defined (__cplusplus) */
+
+
+typedef Uint16 PoolId ;
+
+/** ============================================================================
+ *  @macro  POOL_makePoolId
+ *
+ *  @desc   Builds a pool identifier from a processor ID and a pool number.
+ *  ============================================================================
+ */
+#define POOL_makePoolId(procId, poolNo)                                       \
+            ((PoolId) ((((procId) & 0xFF) << 8) | ((poolNo) & 0xFF)))
+
+/** ============================================================================
+ *  @name   SMAPOOL_Attrs
+ *
+ *  @desc   Attributes of a shared memory allocator pool.
+ *  ============================================================================
+ */
+typedef struct SMAPOOL_Attrs_tag {
+    Uint32   numBufPools ;
+    Uint32 * bufSizes ;
+    Uint32 * numBuffers ;
+    Bool     exactMatchReq ;
+} SMAPOOL_Attrs ;
+
+/** ============================================================================
+ *  @name   AddrType
+ *
+ *  @desc   Address spaces known to POOL_translateAddr ().
+ *  ============================================================================
+ */
+typedef enum {
+    AddrType_Usr = 0,
+    AddrType_Phy = 1,
+    AddrType_Knl = 2,
+    AddrType_Dsp = 3
+} AddrType ;
+
+DSP_STATUS POOL_open       (IN PoolId poolId, IN Pvoid params) ;
+DSP_STATUS POOL_close      (IN PoolId poolId) ;
+DSP_STATUS POOL_alloc      (IN PoolId poolId, OUT Pvoid * bufPtr,
+                            IN Uint32 size) ;
+DSP_STATUS POOL_free       (IN PoolId poolId, IN Pvoid buf, IN Uint32 size) ;
+DSP_STATUS POOL_translateAddr (IN  PoolId   poolId,
+                               OUT Pvoid *  dstAddr,
+                               IN  AddrType dstAddrType,
+                               IN  Pvoid    srcAddr,
+                               IN  AddrType srcAddrType) ;
+DSP_STATUS POOL_writeback  (IN PoolId poolId, IN Pvoid buf, IN Uint32 size) ;
+DSP_STATUS POOL_invalidate (IN PoolId poolId, IN Pvoid buf, IN Uint32 size) ;
+
+
+#if defined (__cplusplus)
+}
+#endif /* defined (__cplusplus) */
+
+
+#endif /* !defined (POOL_H) */
@@ -0,0 +1,39 @@
+/** ============================================================================
+ *  @file   proc.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in for the PROC component. PROC_load () records the
+ *          arguments for the DSP image linked into the process and
+ *          PROC_start () runs it on a worker thread.
+ *  ============================================================================
+ */
+
+
+#if !defined (PROC_H)
+#define PROC_H
+
+#include <dsplink.h>
+
+
+#if defined (__cplusplus)
+extern "C" {
+#endif /* defined (__cplusplus) */
+
+
+DSP_STATUS PROC_setup   (IN Pvoid attrs) ;
+DSP_STATUS PROC_destroy (Void) ;
+DSP_STATUS PROC_attach  (IN Uint32 procId, IN Pvoid attr) ;
+DSP_STATUS PROC_detach  (IN Uint32 procId) ;
+DSP_STATUS PROC_load    (IN Uint32 procId, IN Char8 * imagePath,
+                         IN Uint32 argc, IN Char8 ** argv) ;
+DSP_STATUS PROC_start   (IN Uint32 procId) ;
+DSP_STATUS PROC_stop    (IN Uint32 procId) ;
+
+
+#if defined (__cplusplus)
+}
+#endif /* defined (__cplusplus) */
+
+
+#endif /* !defined (PROC_H) */
@@ -0,0 +1,41 @@
+/** ============================================================================
+ *  @file   sem.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in for the DSP/BIOS SEM module, on top of POSIX
+ *          semaphores. Timeouts are given in milliseconds (system ticks).
+ *  ============================================================================
+ */
+
+
+#if !defined (SEM_H)
+#define SEM_H
+
+#include <semaphore.h>
+#include <std.h>
+#include <sys.h>
+
+
+#if defined (__cplusplus)
+extern "C" {
+#endif /* defined (__cplusplus) */
+
+
+typedef struct SEM_Obj_tag {
+    sem_t    sem ;
+} SEM_Obj ;
+
+typedef SEM_Obj * SEM_Handle ;
+
+Void SEM_new  (SEM_Handle sem, Int count) ;
+Bool SEM_pend (SEM_Handle sem, Uns timeout) ;
+Void SEM_post (SEM_Handle sem) ;
+
+
+#if defined (__cplusplus)
+}
+#endif /* defined (__cplusplus) */
+
+
+#endif /* !defined (SEM_H) */
@@ -0,0 +1,51 @@
+/** ============================================================================
+ *  @file   std.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in for the DSP/BIOS standard types and the MEM module.
+ *  ============================================================================
+ */
+
+
+#if !defined (STD_H)
+#define STD_H
+
+#include <stddef.h>
+#include <dsplink.h>
+
+
+#if defined (__cplusplus)
+extern "C" {
+#endif /* defined (__cplusplus) */
+
+
+typedef int                Int ;
+typedef unsigned int       Uns ;
+typedef long               LgInt ;
+typedef unsigned long      LgUns ;
+typedef char               Char ;
+typedef char *             String ;
+typedef void *             Ptr ;
+typedef Int             (* Fxn) () ;
+
+/** ============================================================================
+ *  @func   MEM_alloc, MEM_calloc, MEM_free
+ *
+ *  @desc   Heap allocation from a DSP memory segment. The segment ID is
+ *          ignored on the host; align may be 0 for no restriction.
+ *  ============================================================================
+ */
+Ptr  MEM_alloc  (Int segid, size_t size, size_t align) ;
+Ptr  MEM_calloc (Int segid, size_t size, size_t align) ;
+Bool MEM_free   (Int segid, Ptr addr, size_t size) ;
+
+#define MEM_ILLEGAL        NULL
+
+
+#if defined (__cplusplus)
+}
+#endif /* defined (__cplusplus) */
+
+
+#endif /* !defined (STD_H) */
@@ -0,0 +1,17 @@
+/** ============================================================================
+ *  @file   swi.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in, nothing from this header is used by pool_notify.
+ *  ============================================================================
+ */
+
+
+#if !defined (SWI_H)
+#define SWI_H
+
+#include <dsplink.h>
+
+
+#endif /* !defined (SWI_H) */
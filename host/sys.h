@@ -0,0 +1,29 @@
+/** ============================================================================
+ *  @file   sys.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in for the DSP/BIOS SYS module status codes.
+ *  ============================================================================
+ */
+
+
+#if !defined (SYS_H)
+#define SYS_H
+
+#include <std.h>
+
+
+#define SYS_OK             0
+#define SYS_EALLOC         1
+#define SYS_EFREE          2
+#define SYS_ENODEV         3
+#define SYS_EBUSY          4
+#define SYS_EINVAL         5
+#define SYS_ETIMEOUT       10
+
+#define SYS_FOREVER        ((Uns) -1)
+#define SYS_POLL           ((Uns) 0)
+
+
+#endif /* !defined (SYS_H) */
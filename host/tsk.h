@@ -0,0 +1,41 @@
+/** ============================================================================
+ *  @file   tsk.h
+ *
+ *  @path   host/
+ *
+ *  @desc   Host stand-in for the DSP/BIOS TSK module. Tasks created from the
+ *          DSP main () run one after the other on the DSP worker thread once
+ *          main () has returned, like the BIOS scheduler would start them.
+ *  ============================================================================
+ */
+
+
+#if !defined (TSK_H)
+#define TSK_H
+
+#include <std.h>
+
+
+#if defined (__cplusplus)
+extern "C" {
+#endif /* defined (__cplusplus) */
+
+
+typedef struct TSK_Attrs_tag {
+    Int      priority ;
+    Ptr      stack ;
+    size_t   stacksize ;
+    String   name ;
+} TSK_Attrs ;
+
+typedef Fxn TSK_Handle ;
+
+TSK_Handle TSK_create (Fxn fxn, TSK_Attrs * attrs, ...) ;
+
+
+#if defined (__cplusplus)
+}
+#endif /* defined (__cplusplus) */
+
+
+#endif /* !defined (TSK_H) */